@@ -36,11 +36,139 @@
 #include "variant.h"
 #include "list.h"
 #include "image.h"
+#include "command_queue_mt.h"
+#include "hash_map.h"
+#include "oa_hash_map.h"
+#include "map.h"
+#include "os/thread.h"
+#include "os/os.h"
 
 namespace TestContainers {
 
+struct _QueueBenchTarget {
+
+	uint64_t sum;
+	volatile bool exit;
+
+	void add(int p_value) { sum+=p_value; }
+	void quit() { exit=true; }
+};
+
+struct _QueueBench {
+
+	CommandQueueMT *queue;
+	_QueueBenchTarget target;
+};
+
+static void _queue_bench_consumer(void *p_ud) {
+
+	_QueueBench *qb = (_QueueBench*)p_ud;
+	while(!qb->target.exit) {
+		qb->queue->wait_and_flush_all();
+	}
+}
+
+static void _bench_command_queue(bool p_single_producer) {
+
+	const int commands=2000000;
+
+	_QueueBench qb;
+	qb.queue = memnew( CommandQueueMT(true,p_single_producer) );
+	qb.target.sum=0;
+	qb.target.exit=false;
+
+	Thread *thread = Thread::create(_queue_bench_consumer,&qb);
+
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<commands;i++) {
+		qb.queue->push(&qb.target,&_QueueBenchTarget::add,1);
+	}
+	qb.queue->push_and_sync(&qb.target,&_QueueBenchTarget::quit); //returns once everything before it ran
+
+	uint64_t elapsed = OS::get_singleton()->get_ticks_usec()-from;
+
+	Thread::wait_to_finish(thread);
+	memdelete(thread);
+	memdelete(qb.queue);
+
+	print_line(String(p_single_producer?"CommandQueueMT lock-free SPSC: ":"CommandQueueMT mutex: ")+itos(elapsed/1000)+" msec, "+rtos(commands/(elapsed/1000000.0))+" commands/sec"+(qb.target.sum==commands?"":" (ERROR: commands lost)"));
+}
+
+template<class M>
+static uint64_t _bench_iterate(const M& p_map) {
+
+	uint64_t sum=0;
+	const uint32_t *k=NULL;
+	while((k=p_map.next(k)))
+		sum+=*k;
+	return sum;
+}
+
+static uint64_t _bench_iterate(const Map<uint32_t,uint32_t>& p_map) {
+
+	uint64_t sum=0;
+	for(const Map<uint32_t,uint32_t>::Element *E=p_map.front();E;E=E->next())
+		sum+=E->key();
+	return sum;
+}
+
+template<class M>
+static void _bench_map(const String& p_name,const Vector<uint32_t>& p_keys) {
+
+	int count=p_keys.size();
+	M map;
+
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+	for(int i=0;i<count;i++)
+		map[p_keys[i]]=i;
+	uint64_t insert = OS::get_singleton()->get_ticks_usec()-from;
+
+	from = OS::get_singleton()->get_ticks_usec();
+	int found=0;
+	for(int i=0;i<count;i++) {
+		if (map.has(p_keys[i]))
+			found++;
+	}
+	uint64_t lookup = OS::get_singleton()->get_ticks_usec()-from;
+
+	from = OS::get_singleton()->get_ticks_usec();
+	uint64_t sum=0;
+	for(int i=0;i<10;i++)
+		sum+=_bench_iterate(map);
+	uint64_t iterate = OS::get_singleton()->get_ticks_usec()-from;
+
+	from = OS::get_singleton()->get_ticks_usec();
+	for(int i=0;i<count;i++)
+		map.erase(p_keys[i]);
+	uint64_t erase = OS::get_singleton()->get_ticks_usec()-from;
+
+	print_line(p_name+": insert "+itos(insert/1000)+" msec, lookup "+itos(lookup/1000)+" msec, iterate x10 "+itos(iterate/1000)+" msec, erase "+itos(erase/1000)+" msec"+((found==count && map.size()==0 && sum)?"":" (ERROR: contents mismatch)"));
+}
+
+static void _bench_hash_maps() {
+
+	const int count=500000;
+
+	Vector<uint32_t> keys;
+	keys.resize(count);
+	uint32_t seed=12345;
+	for(int i=0;i<count;i++) {
+		seed=seed*1103515245+12345; //scattered, like object ids after churn
+		keys[i]=seed;
+	}
+
+	_bench_map< HashMap<uint32_t,uint32_t> >("HashMap",keys);
+	_bench_map< OAHashMap<uint32_t,uint32_t> >("OAHashMap",keys);
+	_bench_map< Map<uint32_t,uint32_t> >("Map",keys);
+}
+
 MainLoop * test() {
 
+	_bench_command_queue(false);
+	_bench_command_queue(true);
+	_bench_hash_maps();
+
 
 	/*
 	HashMap<int,int> int_map;
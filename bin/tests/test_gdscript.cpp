@@ -528,6 +528,22 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 					txt+=DADDR(3);
 					incr+=5;
 
+				} break;
+				case GDFunction::OPCODE_OPERATOR_TYPED: {
+
+					const GDFunction::TypedOperatorInfo &info = GDFunction::get_typed_operator_info(code[ip+1]);
+					txt+="op-typed ";
+
+					String opname = Variant::get_operator_name(info.op);
+
+					txt+=DADDR(4);
+					txt+=" = ";
+					txt+=DADDR(2);
+					txt+=" "+opname+" ";
+					txt+=DADDR(3);
+					txt+=" ("+Variant::get_type_name(info.type_a)+","+Variant::get_type_name(info.type_b)+")";
+					incr+=5;
+
 				} break;
 				case GDFunction::OPCODE_SET: {
 
@@ -560,20 +576,22 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 					txt+=func.get_global_name(code[ip+2]);
 					txt+="\"]=";
 					txt+=DADDR(3);
-					incr+=4;
+					txt+=" (cache "+itos(code[ip+4])+")";
+					incr+=5;
 
 
 				} break;
 				case GDFunction::OPCODE_GET_NAMED: {
 
 					txt+=" get_named ";
-					txt+=DADDR(3);
+					txt+=DADDR(4);
 					txt+="=";
 					txt+=DADDR(1);
 					txt+="[\"";
 					txt+=func.get_global_name(code[ip+2]);
 					txt+="\"]";
-					incr+=4;
+					txt+=" (cache "+itos(code[ip+3])+")";
+					incr+=5;
 
 				} break;
 				case GDFunction::OPCODE_ASSIGN: {
@@ -675,7 +693,7 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 
 					int argc=code[ip+1];
 					if (ret) {
-						txt+=DADDR(4+argc)+"=";
+						txt+=DADDR(5+argc)+"=";
 					}
 
 					txt+=DADDR(2)+".";
@@ -685,12 +703,13 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 					for(int i=0;i<argc;i++) {
 						if (i>0)
 							txt+=", ";
-						txt+=DADDR(4+i);
+						txt+=DADDR(5+i);
 					}
 					txt+=")";
+					txt+=" (cache "+itos(code[ip+4])+")";
 
 
-					incr=5+argc;
+					incr=6+argc;
 
 				} break;
 				case GDFunction::OPCODE_CALL_BUILT_IN: {
@@ -821,8 +840,95 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 	}
 }
 
+static const char *_bytecode_bench_code=
+"var acc=0\n"
+"\n"
+"func bench_int(n):\n"
+"\tvar i=0\n"
+"\tvar s=0\n"
+"\twhile(i<n):\n"
+"\t\ts=s+i*3-(i/2)\n"
+"\t\ti=i+1\n"
+"\treturn s\n"
+"\n"
+"func bench_vector(n):\n"
+"\tvar i=0\n"
+"\tvar v=Vector3()\n"
+"\tvar d=Vector3(1,2,3)\n"
+"\twhile(i<n):\n"
+"\t\tv=v+d*0.5\n"
+"\t\ti=i+1\n"
+"\treturn v\n"
+"\n"
+"func _step(a):\n"
+"\treturn a+1\n"
+"\n"
+"func bench_call(n):\n"
+"\tvar i=0\n"
+"\tvar s=0\n"
+"\tvar d=Vector3(1,2,3)\n"
+"\twhile(i<n):\n"
+"\t\ts=_step(s)\n"
+"\t\tacc=acc+d.length()\n"
+"\t\ti=i+1\n"
+"\treturn s\n";
+
+static void _bench_bytecode() {
+
+	GDParser parser;
+	Error err = parser.parse(_bytecode_bench_code);
+	if (err) {
+		print_line("Parse Error:\n"+itos(parser.get_error_line())+":"+itos(parser.get_error_column())+":"+parser.get_error());
+		return;
+	}
+
+	GDScript *script = memnew( GDScript );
+
+	GDCompiler gdc;
+	err = gdc.compile(&parser,script);
+	if (err) {
+
+		print_line("Compile Error:\n"+itos(gdc.get_error_line())+":"+itos(gdc.get_error_column())+":"+gdc.get_error());
+		memdelete(script);
+		return;
+	}
+
+	Ref<GDScript> gds = Ref<GDScript>( script );
+
+	Variant::CallError ce;
+	Variant instance = gds->_new(NULL,0,ce);
+	Object *obj = instance;
+	ERR_FAIL_COND(!obj);
+
+#ifdef GDSCRIPT_THREADED_DISPATCH
+	print_line("dispatch: threaded");
+#else
+	print_line("dispatch: switch");
+#endif
+
+	const int iterations=1000000;
+	const char *benches[3]={"bench_int","bench_vector","bench_call"};
+
+	for(int i=0;i<3;i++) {
+
+		obj->call(benches[i],100); //warm up inline caches
+
+		uint64_t from = OS::get_singleton()->get_ticks_usec();
+		Variant ret = obj->call(benches[i],iterations);
+		uint64_t elapsed = OS::get_singleton()->get_ticks_usec()-from;
+
+		print_line(String(benches[i])+": "+itos(elapsed/1000)+" msec, "+rtos(elapsed*1000.0/iterations)+" nsec/iteration (result: "+String(ret)+")");
+	}
+}
+
 MainLoop* test(TestType p_test) {
 
+	if (p_test==TEST_BYTECODE_BENCHMARK) {
+
+		_bench_bytecode();
+		return NULL;
+	}
+
 	List<String> cmdlargs = OS::get_singleton()->get_cmdline_args();
 
 	if (cmdlargs.empty()) {
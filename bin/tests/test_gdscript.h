@@ -36,7 +36,8 @@ namespace TestGDScript {
 enum TestType {
 	TEST_TOKENIZER,
 	TEST_PARSER,
-	TEST_COMPILER
+	TEST_COMPILER,
+	TEST_BYTECODE_BENCHMARK
 };
 
 MainLoop* test(TestType p_type);
@@ -42,6 +42,8 @@
 #include "core/globals.h"
 
 #include "io/file_access_memory.h"
+#include "io/file_access_pack.h"
+#include "version.h"
 
 namespace TestIO {
 
@@ -80,10 +82,88 @@ public:
 	
 };
 
+// builds a pack with p_entries small files and times registering it and looking every entry up
+static void _pack_benchmark(int p_entries) {
+
+	String pack_path = OS::get_singleton()->get_data_dir()+"/pack_benchmark.pck";
+	FileAccess *f = FileAccess::open(pack_path,FileAccess::WRITE);
+	ERR_FAIL_COND(!f);
+
+	Vector<String> paths;
+	paths.resize(p_entries);
+	for(int i=0;i<p_entries;i++)
+		paths[i]="res://pack_benchmark/dir"+itos(i/100)+"/file"+itos(i)+".res";
+
+	f->store_32(0x4b435047); //GPCK
+	f->store_32(VERSION_MAJOR);
+	f->store_32(VERSION_MINOR);
+	f->store_32(VERSION_REVISION);
+	for(int i=0;i<16;i++)
+		f->store_32(0);
+	f->store_32(p_entries);
+
+	uint64_t ofs=f->get_pos();
+	for(int i=0;i<p_entries;i++)
+		ofs+=4+paths[i].utf8().length()+16;
+
+	for(int i=0;i<p_entries;i++) {
+
+		CharString cs=paths[i].utf8();
+		f->store_32(cs.length());
+		f->store_buffer((const uint8_t*)cs.get_data(),cs.length());
+		f->store_64(ofs+i*4);
+		f->store_64(4);
+	}
+	for(int i=0;i<p_entries;i++)
+		f->store_32(i);
+	memdelete(f);
+
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+	Error err = PackedData::get_singleton()->add_pack(pack_path);
+	uint64_t load = OS::get_singleton()->get_ticks_usec()-from;
+	ERR_FAIL_COND(err!=OK);
+
+	from = OS::get_singleton()->get_ticks_usec();
+	int found=0;
+	for(int i=0;i<p_entries;i++) {
+		if (PackedData::get_singleton()->has_path(paths[(i*7919)%p_entries]))
+			found++;
+	}
+	uint64_t lookup = OS::get_singleton()->get_ticks_usec()-from;
+
+	from = OS::get_singleton()->get_ticks_usec();
+	int valid=0;
+	for(int i=0;i<p_entries;i++) {
+
+		FileAccess *pf = PackedData::get_singleton()->try_open_path(paths[i]);
+		if (!pf)
+			continue;
+		if (pf->get_32()==uint32_t(i))
+			valid++;
+		memdelete(pf);
+	}
+	uint64_t open = OS::get_singleton()->get_ticks_usec()-from;
+
+	print_line("pack of "+itos(p_entries)+" entries: load "+itos(load/1000)+" msec, lookup "+itos(lookup/1000)+" msec, open+read "+itos(open/1000)+" msec"+((found==p_entries && valid==p_entries)?"":" (ERROR: contents mismatch)"));
+
+	DirAccess *da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	da->remove(pack_path);
+	memdelete(da);
+}
 
 MainLoop* test() {
 
 	print_line("this is test io");
+
+	List<String> cmdline = OS::get_singleton()->get_cmdline_args();
+	for(List<String>::Element *E=cmdline.front();E;E=E->next()) {
+
+		if (E->get()=="-pack_benchmark") {
+			_pack_benchmark(50000);
+			return NULL;
+		}
+	}
+
 	DirAccess* da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
 	da->change_dir(".");
 	print_line("Opening current dir "+ da->get_current_dir());
@@ -90,6 +90,11 @@ MainLoop* test_main(String p_test,const List<String>& p_args) {
 		return TestPhysics::test();
 	}
 
+	if (p_test=="physics_broad_phase") {
+
+		return TestPhysics::test_broad_phase();
+	}
+
 	if (p_test=="physics_2d") {
 
 		return TestPhysics2D::test();
@@ -104,6 +109,11 @@ MainLoop* test_main(String p_test,const List<String>& p_args) {
 	
 		return TestRender::test();
 	}
+
+	if (p_test=="canvas_batching") {
+
+		return TestRender::test_canvas_batching();
+	}
   
 	#ifndef _3D_DISABLED
 	if (p_test=="gui") {
@@ -152,6 +162,11 @@ MainLoop* test_main(String p_test,const List<String>& p_args) {
 		return TestGDScript::test(TestGDScript::TEST_COMPILER);
 	}
 
+	if (p_test=="gd_bytecode_bench") {
+
+		return TestGDScript::test(TestGDScript::TEST_BYTECODE_BENCHMARK);
+	}
+
 	if (p_test=="image") {
 
 		return TestImage::test();
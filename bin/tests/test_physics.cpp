@@ -37,6 +37,10 @@
 #include "map.h"
 #include "os/os.h"
 #include "quick_hull.h"
+#include "servers/physics/broad_phase_basic.h"
+#include "servers/physics/broad_phase_octree.h"
+#include "servers/physics/broad_phase_aabb_tree.h"
+#include "servers/physics/body_sw.h"
 
 class TestPhysicsMainLoop : public MainLoop {
 
@@ -659,4 +663,107 @@ MainLoop* test() {
 
 }
 
+struct _BroadPhaseBench {
+
+	int pairs;
+	int unpairs;
+
+	static void* _pair(CollisionObjectSW *A,int p_subindex_A,CollisionObjectSW *B,int p_subindex_B,void *p_userdata) {
+
+		((_BroadPhaseBench*)p_userdata)->pairs++;
+		return NULL;
+	}
+
+	static void _unpair(CollisionObjectSW *A,int p_subindex_A,CollisionObjectSW *B,int p_subindex_B,void *p_data,void *p_userdata) {
+
+		((_BroadPhaseBench*)p_userdata)->unpairs++;
+	}
+};
+
+static void _bench_broad_phase(const String& p_name,BroadPhaseSW::CreateFunction p_create,int p_dynamic,int p_static,int p_steps) {
+
+	const float extent=200;
+	const Vector3 size(1,1,1);
+
+	BroadPhaseSW *bp = p_create();
+	_BroadPhaseBench bench;
+	bench.pairs=0;
+	bench.unpairs=0;
+	bp->set_pair_callback(_BroadPhaseBench::_pair,&bench);
+	bp->set_unpair_callback(_BroadPhaseBench::_unpair,&bench);
+
+	int count=p_dynamic+p_static;
+	BodySW *bodies = memnew_arr(BodySW,count);
+	BroadPhaseSW::ID *ids = memnew_arr(BroadPhaseSW::ID,count);
+	Vector3 *pos = memnew_arr(Vector3,count);
+	Vector3 *vel = memnew_arr(Vector3,count);
+
+	Math::seed(1234);
+
+	for(int i=0;i<count;i++) {
+
+		pos[i]=Vector3(Math::random(0,extent),Math::random(0,extent*0.1),Math::random(0,extent));
+		vel[i]=Vector3(Math::random(-1,1),Math::random(-1,1),Math::random(-1,1))*0.2;
+		ids[i]=bp->create(&bodies[i]);
+		bp->move(ids[i],AABB(pos[i],size));
+		if (i>=p_dynamic)
+			bp->set_static(ids[i],true);
+	}
+	bp->update();
+
+	CollisionObjectSW *results[256];
+	int result_indices[256];
+	int culled=0;
+
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+
+	for(int s=0;s<p_steps;s++) {
+
+		for(int i=0;i<p_dynamic;i++) {
+
+			pos[i]+=vel[i];
+			for(int j=0;j<3;j++) {
+				if (pos[i][j]<0 || pos[i][j]>extent)
+					vel[i][j]=-vel[i][j];
+			}
+			bp->move(ids[i],AABB(pos[i],size));
+		}
+
+		bp->update();
+
+		for(int i=0;i<64;i++) {
+
+			Vector3 p = Vector3(Math::random(0,extent),0,Math::random(0,extent));
+			culled+=bp->cull_aabb(AABB(p,Vector3(10,10,10)),results,256,result_indices);
+			culled+=bp->cull_segment(p,p+Vector3(50,extent*0.1,0),results,256,result_indices);
+		}
+	}
+
+	uint64_t elapsed = OS::get_singleton()->get_ticks_usec()-from;
+
+	print_line(p_name+": "+itos(p_dynamic)+" moving, "+itos(p_static)+" static, "+itos(p_steps)+" steps: "+rtos(elapsed/1000.0/p_steps)+" msec/step ("+itos(bench.pairs)+" pairs, "+itos(bench.unpairs)+" unpairs, "+itos(culled)+" culled)");
+
+	for(int i=0;i<count;i++)
+		bp->remove(ids[i]);
+	memdelete(bp);
+
+	memdelete_arr(bodies);
+	memdelete_arr(ids);
+	memdelete_arr(pos);
+	memdelete_arr(vel);
+}
+
+MainLoop* test_broad_phase() {
+
+	// basic is O(n^2), keep it to a smaller scene
+	_bench_broad_phase("Basic",BroadPhaseBasic::_create,1000,250,20);
+	_bench_broad_phase("Octree",BroadPhaseOctree::_create,1000,250,20);
+	_bench_broad_phase("AABB Tree",BroadPhaseAABBTree::_create,1000,250,20);
+
+	_bench_broad_phase("Octree",BroadPhaseOctree::_create,8000,2000,100);
+	_bench_broad_phase("AABB Tree",BroadPhaseAABBTree::_create,8000,2000,100);
+
+	return NULL;
+}
+
 }
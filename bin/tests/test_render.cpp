@@ -33,6 +33,7 @@
 #include "print_string.h"
 #include "os/os.h"
 #include "quick_hull.h"
+#include "globals.h"
 #define OBJECT_COUNT 50
 
 namespace TestRender {
@@ -254,4 +255,58 @@ MainLoop* test() {
 
 }
 
+/* draws the same texture rects with and without canvas batching. Only RasterizerDummy
+   counts canvas draw calls, so run this one on the server platform */
+
+static int _canvas_draw_calls(bool p_batching) {
+
+	Globals::get_singleton()->set("render/canvas_batching",p_batching);
+	VS::get_singleton()->draw();
+	return VS::get_singleton()->get_render_info(VS::INFO_DRAW_CALLS_IN_FRAME);
+}
+
+MainLoop* test_canvas_batching() {
+
+	const int rects=200;
+	VisualServer *vs = VS::get_singleton();
+	bool was_batching = GLOBAL_DEF("render/canvas_batching",true);
+
+	RID viewport = vs->viewport_create();
+	vs->viewport_attach_to_screen(viewport);
+	RID canvas = vs->canvas_create();
+	vs->viewport_attach_canvas(viewport,canvas);
+
+	//cursors and margins are drawn too, count them with an empty canvas
+	int base_off=_canvas_draw_calls(false);
+	int base_on=_canvas_draw_calls(true);
+
+	RID texture = vs->texture_create();
+	vs->texture_allocate(texture,16,16,Image::FORMAT_RGBA);
+	RID item = vs->canvas_item_create();
+	vs->canvas_item_set_parent(item,canvas);
+	for(int i=0;i<rects;i++)
+		vs->canvas_item_add_texture_rect(item,Rect2((i%20)*16,(i/20)*16,16,16),texture);
+
+	int off=_canvas_draw_calls(false)-base_off;
+	int on=_canvas_draw_calls(true)-base_on;
+
+	String result;
+	if (off==0)
+		result="ERROR: no canvas draw calls counted, needs RasterizerDummy";
+	else if (off!=rects || on!=1)
+		result="ERROR: expected "+itos(rects)+" and 1";
+	else
+		result="ok";
+
+	print_line(itos(rects)+" same texture rects: "+itos(off)+" draw calls without batching, "+itos(on)+" with batching ("+result+")");
+
+	vs->free(item);
+	vs->free(texture);
+	vs->free(canvas);
+	vs->free(viewport);
+	Globals::get_singleton()->set("render/canvas_batching",was_batching);
+
+	return NULL;
+}
+
 }
@@ -38,6 +38,7 @@
 namespace TestRender {
 
 MainLoop* test();
+MainLoop* test_canvas_batching();
 
 }
 
@@ -35,8 +35,182 @@
 #include "print_string.h"
 #include "servers/audio_server.h"
 #include "os/os.h"
+#include "servers/audio/audio_mixer_sw.h"
+#include "servers/audio/sample_manager_sw.h"
 namespace TestSound {
 
+/* offline mixer benchmark and stress test, no driver needed */
+
+//looped noise-ish tone
+static RID _make_test_sample(SampleManagerSW *p_sample_manager, AS::SampleFormat p_format, bool p_stereo, int p_len) {
+
+	int chans=p_stereo?2:1;
+	int bytes=p_format==AS::SAMPLE_FORMAT_PCM16?2:1;
+	RID sample = p_sample_manager->sample_create(p_format,p_stereo,p_len);
+	DVector<uint8_t> data;
+	data.resize(p_len*chans*bytes);
+	{
+		DVector<uint8_t>::Write w=data.write();
+		for(int i=0;i<p_len*chans;i++) {
+			int v=Math::sin(i*(i&1?0.031:0.05))*20000+(Math::rand()%2000)-1000;
+			if (bytes==2)
+				((int16_t*)w.ptr())[i]=v;
+			else
+				((int8_t*)w.ptr())[i]=v>>8;
+		}
+	}
+	p_sample_manager->sample_set_data(sample,data);
+	p_sample_manager->sample_set_loop_format(sample,AS::SAMPLE_LOOP_FORWARD);
+	p_sample_manager->sample_set_loop_begin(sample,0);
+	p_sample_manager->sample_set_loop_end(sample,p_len);
+	return sample;
+}
+
+static uint64_t _mix_benchmark(SampleManagerSW *p_sample_manager, RID p_sample, int p_voices, bool p_simd, Vector<int32_t> &r_out) {
+
+	const int mix_rate=44100;
+	const int seconds=10;
+	const int block=512;
+
+	AudioMixerSW mixer(p_sample_manager,10,mix_rate,AudioMixerSW::MIX_STEREO,true,AudioMixerSW::INTERPOLATION_LINEAR);
+	mixer.set_simd_enabled(p_simd);
+
+	for(int i=0;i<p_voices;i++) {
+
+		AudioMixer::ChannelID ch = mixer.channel_alloc(p_sample);
+		mixer.channel_set_mix_rate(ch,22050+(i*997)%44100);
+		mixer.channel_set_pan(ch,(i%9)/4.0-1.0);
+		mixer.channel_set_volume(ch,0.2+(i%5)*0.1);
+		if (i&1)
+			mixer.channel_set_reverb(ch,AudioMixer::REVERB_MEDIUM,0.3);
+	}
+
+	//keep every block, so the whole run can be compared
+	int frames=mix_rate*seconds;
+	r_out.resize((frames+block-1)/block*block*2);
+	int32_t *buf=&r_out[0];
+
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+	for(int i=0;i<frames;i+=block)
+		mixer.mix(&buf[i*2],block);
+	return OS::get_singleton()->get_ticks_usec()-from;
+}
+
+static void mix_benchmark() {
+
+	SampleManagerMallocSW sample_manager;
+	RID sample = _make_test_sample(&sample_manager,AS::SAMPLE_FORMAT_PCM16,true,44100);
+
+	int voices[3]={8,32,64}; //64 is the mixer channel limit
+
+	for(int i=0;i<3;i++) {
+
+		Vector<int32_t> scalar_out,simd_out;
+		uint64_t scalar = _mix_benchmark(&sample_manager,sample,voices[i],false,scalar_out);
+		String line = itos(voices[i])+" voices, 10 sec: scalar "+itos(scalar/1000)+" msec";
+
+		if (AudioMixerSW::has_simd()) {
+			uint64_t simd = _mix_benchmark(&sample_manager,sample,voices[i],true,simd_out);
+			int max_diff=0;
+			for(int j=0;j<scalar_out.size();j++)
+				max_diff=MAX(max_diff,ABS(scalar_out[j]-simd_out[j]));
+			line+=", simd "+itos(simd/1000)+" msec (x"+rtos(scalar/double(MAX(simd,1)))+", max diff "+itos(max_diff)+")";
+		} else {
+			line+=", simd not available on this platform";
+		}
+		print_line(line);
+	}
+
+	sample_manager.free(sample);
+}
+
+static void _mix_stress_voice(AudioMixerSW *p_mixer, AudioMixer::ChannelID p_ch, uint32_t p_seed) {
+
+	if (p_ch==AudioMixer::INVALID_CHANNEL)
+		return;
+
+	p_mixer->channel_set_mix_rate(p_ch,11025+p_seed%66150);
+	p_mixer->channel_set_pan(p_ch,((p_seed>>3)%201)/100.0-1.0);
+	p_mixer->channel_set_volume(p_ch,((p_seed>>5)%100)/100.0);
+	p_mixer->channel_set_chorus(p_ch,(p_seed&1)?0.2:0);
+	p_mixer->channel_set_reverb(p_ch,AudioMixer::ReverbRoomType((p_seed>>9)%4),(p_seed>>11)%3==0?0:0.4);
+	if ((p_seed>>13)%4==0)
+		p_mixer->channel_set_filter(p_ch,AudioMixer::FILTER_LOWPASS,500+(p_seed>>15)%8000,0.5);
+	else
+		p_mixer->channel_set_filter(p_ch,AudioMixer::FILTER_NONE,0,0);
+}
+
+/* mixes the same changing voices with and without threads, output must be identical */
+
+static void mix_stress_test() {
+
+	const int mix_rate=44100;
+	const int seconds=20;
+	const int block=512;
+	const int voices=64;
+	const int threads=3;
+
+	SampleManagerMallocSW sample_manager;
+	RID samples[2]={
+		_make_test_sample(&sample_manager,AS::SAMPLE_FORMAT_PCM16,true,44100),
+		_make_test_sample(&sample_manager,AS::SAMPLE_FORMAT_PCM8,false,20000)
+	};
+
+	AudioMixerSW *mixers[2];
+	AudioMixer::ChannelID chans[2][voices];
+	uint64_t time[2]={0,0};
+	Vector<int32_t> out[2];
+
+	for(int m=0;m<2;m++) {
+		mixers[m] = memnew( AudioMixerSW(&sample_manager,10,mix_rate,AudioMixerSW::MIX_STEREO,true,AudioMixerSW::INTERPOLATION_LINEAR) );
+		mixers[m]->set_mix_threads(m==0?0:threads);
+		out[m].resize(block*2);
+	}
+
+	uint32_t seed=1234;
+	int mismatches=0;
+
+	for(int f=0,b=0;f<mix_rate*seconds;f+=block,b++) {
+
+		for(int i=0;i<voices;i++) {
+
+			if (b>0 && (b+i)%64!=0)
+				continue;
+			// every voice is restarted or changed now and then
+			seed=seed*1664525+1013904223;
+			for(int m=0;m<2;m++) {
+
+				if (b>0 && (seed>>20)%2==0) {
+					mixers[m]->channel_free(chans[m][i]);
+					chans[m][i]=mixers[m]->channel_alloc(samples[i&1]);
+				} else if (b==0) {
+					chans[m][i]=mixers[m]->channel_alloc(samples[i&1]);
+				}
+				_mix_stress_voice(mixers[m],chans[m][i],seed);
+			}
+		}
+
+		for(int m=0;m<2;m++) {
+
+			uint64_t from = OS::get_singleton()->get_ticks_usec();
+			mixers[m]->mix(&out[m][0],block);
+			time[m]+=OS::get_singleton()->get_ticks_usec()-from;
+		}
+
+		for(int i=0;i<block*2;i++) {
+			if (out[0][i]!=out[1][i])
+				mismatches++;
+		}
+	}
+
+	print_line(itos(voices)+" voices stress, "+itos(seconds)+" sec: serial "+itos(time[0]/1000)+" msec, "+itos(mixers[1]->get_mix_threads())+" extra threads "+itos(time[1]/1000)+" msec"+(mismatches?" (ERROR: "+itos(mismatches)+" samples differ)":String(", output identical")));
+
+	for(int m=0;m<2;m++)
+		memdelete(mixers[m]);
+	sample_manager.free(samples[0]);
+	sample_manager.free(samples[1]);
+}
+
 
 class TestMainLoop : public MainLoop {
 
@@ -62,6 +236,12 @@ public:
 			sample=ResourceLoader::load(cmdline.back()->get());
 			ERR_FAIL_COND(sample.is_null());
 			print_line("Sample loaded OK");
+		} else {
+			//no sample given, benchmark the mixer instead
+			mix_benchmark();
+			mix_stress_test();
+			quit=true;
+			return;
 		}
 
 		RID voice = AudioServer::get_singleton()->voice_create();
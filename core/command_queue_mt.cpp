@@ -73,11 +73,34 @@ CommandQueueMT::SyncSemaphore* CommandQueueMT::_alloc_sync_sem() {
 }
 
 
-CommandQueueMT::CommandQueueMT(bool p_sync){
+void CommandQueueMT::_wait_for_commands() {
+
+	if (_get_write_ptr()!=read_ptr)
+		return; //work pending, don't sleep
+
+	atomic_exchange(&consumer_idle,1);
+
+	if (atomic_load_acquire(&write_ptr)!=read_ptr) {
+		//producer committed meanwhile, if it also saw the idle flag it posted, so take that post back
+		if (atomic_exchange(&consumer_idle,0)==0)
+			sync->wait();
+		return;
+	}
+
+	sync->wait();
+}
+
+CommandQueueMT::CommandQueueMT(bool p_sync,bool p_single_producer){
 
 	read_ptr=0;
-	write_ptr=0;	
-	mutex = Mutex::create();
+	write_ptr=0;
+	alloc_ptr=0;
+	single_producer=p_single_producer;
+	consumer_idle=0;
+#ifdef DEBUG_ENABLED
+	producer_thread=0;
+#endif
+	mutex = single_producer ? NULL : Mutex::create();
 
 	for(int i=0;i<SYNC_SEMAPHORES;i++) {
 
@@ -97,7 +120,8 @@ CommandQueueMT::~CommandQueueMT() {
 
 	if (sync)
 		memdelete(sync);
-	memdelete(mutex);
+	if (mutex)
+		memdelete(mutex);
 	for(int i=0;i<SYNC_SEMAPHORES;i++) {
 
 		memdelete(sync_sems[i].sem);
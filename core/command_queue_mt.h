@@ -32,8 +32,10 @@
 #include "typedefs.h"
 #include "os/semaphore.h"
 #include "os/mutex.h"
+#include "os/thread.h"
 #include "os/memory.h"
 #include "simple_type.h"
+#include "safe_refcount.h"
 /**
 	@author Juan Linietsky <reduzio@gmail.com>
 */
@@ -400,59 +402,84 @@ class CommandQueueMT {
 
 
 	uint8_t command_mem[COMMAND_MEM_SIZE];
-	uint32_t read_ptr;
-	uint32_t write_ptr;
+	volatile uint32_t read_ptr; //owned by the consumer
+	volatile uint32_t write_ptr; //last committed command, owned by the producer
+	uint32_t alloc_ptr; //producer cursor, becomes write_ptr on commit
 	SyncSemaphore sync_sems[SYNC_SEMAPHORES];
 	Mutex *mutex;
 	Semaphore *sync;
-	
-	
+
+	/* In single producer mode there is no mutex, the producer publishes
+	   write_ptr and the consumer read_ptr with release/acquire barriers.
+	   The consumer flags itself idle before sleeping on the semaphore, so
+	   the producer only posts it when it's actually needed. */
+
+	bool single_producer;
+	volatile uint32_t consumer_idle;
+#ifdef DEBUG_ENABLED
+	Thread::ID producer_thread;
+#endif
+
+	_FORCE_INLINE_ uint32_t _get_read_ptr() { return single_producer ? atomic_load_acquire(&read_ptr) : read_ptr; }
+	_FORCE_INLINE_ uint32_t _get_write_ptr() { return single_producer ? atomic_load_acquire(&write_ptr) : write_ptr; }
+	_FORCE_INLINE_ void _set_read_ptr(uint32_t p_ptr) { if (single_producer) atomic_store_release(&read_ptr,p_ptr); else read_ptr=p_ptr; }
+
 	template<class T>
 	T* allocate() {
 	
 		// alloc size is size+T+safeguard
 		uint32_t alloc_size=sizeof(T)+sizeof(uint32_t);
-		
+		uint32_t read_pos=_get_read_ptr(); //may only move forward (or wrap) while allocating, which leaves more room
+
 		tryagain:
 		
-		if (write_ptr < read_ptr) {
+		if (alloc_ptr < read_pos) {
 			// behind read_ptr, check that there is room
-			if ( (read_ptr-write_ptr) <= alloc_size )
+			if ( (read_pos-alloc_ptr) <= alloc_size )
 				return NULL;
-		} else if (write_ptr >= read_ptr) {
+		} else if (alloc_ptr >= read_pos) {
 			// ahead of read_ptr, check that there is room
 			
 			
-			if ( (COMMAND_MEM_SIZE-write_ptr) < alloc_size+4 ) {
+			if ( (COMMAND_MEM_SIZE-alloc_ptr) < alloc_size+4 ) {
 				// no room at the end, wrap down;
 				
-				if (read_ptr==0) // dont want write_ptr to become read_ptr
+				if (read_pos==0) // dont want write_ptr to become read_ptr
 					return NULL;
 					
 				// if this happens, it's a bug
-				ERR_FAIL_COND_V( (COMMAND_MEM_SIZE-write_ptr) < sizeof(uint32_t), NULL );
+				ERR_FAIL_COND_V( (COMMAND_MEM_SIZE-alloc_ptr) < sizeof(uint32_t), NULL );
 				// zero means, wrap to begining
 
-				uint32_t * p = (uint32_t*)&command_mem[write_ptr];
+				uint32_t * p = (uint32_t*)&command_mem[alloc_ptr];
 				*p=0;
-				write_ptr=0;
+				alloc_ptr=0;
 				goto tryagain;
 			}
 		}
 		// allocate the size
-		uint32_t * p = (uint32_t*)&command_mem[write_ptr];
+		uint32_t * p = (uint32_t*)&command_mem[alloc_ptr];
 		*p=sizeof(T);
-		write_ptr+=sizeof(uint32_t);
+		alloc_ptr+=sizeof(uint32_t);
 		// allocate the command
-		T* cmd = memnew_placement( &command_mem[write_ptr], T );
-		write_ptr+=sizeof(T);
+		T* cmd = memnew_placement( &command_mem[alloc_ptr], T );
+		alloc_ptr+=sizeof(T);
 		return cmd;
 	
 	}
 	
 	template<class T>
 	T* allocate_and_lock() {
-	
+
+#ifdef DEBUG_ENABLED
+		if (single_producer) {
+			if (producer_thread==0)
+				producer_thread=Thread::get_caller_ID();
+			if (producer_thread!=Thread::get_caller_ID()) {
+				ERR_PRINT("Single producer CommandQueueMT pushed from more than one thread.");
+			}
+		}
+#endif
 		lock();
 		T* ret;
 		
@@ -474,29 +501,47 @@ class CommandQueueMT {
 		tryagain:
 		
 		// tried to read an empty queue
-		if (read_ptr == write_ptr )
+		uint32_t pos = read_ptr;
+		if (pos == _get_write_ptr() )
 			return false;
 		
-		uint32_t size = *(uint32_t*)( &command_mem[read_ptr] );
+		uint32_t size = *(uint32_t*)( &command_mem[pos] );
 		
 		if (size==0) {
 			//end of ringbuffer, wrap
-			read_ptr=0;
+			_set_read_ptr(0);
 			goto tryagain;
 		}
 		
-		read_ptr+=sizeof(uint32_t);
+		pos+=sizeof(uint32_t);
 		
-		CommandBase *cmd = reinterpret_cast<CommandBase*>( &command_mem[read_ptr] );
+		CommandBase *cmd = reinterpret_cast<CommandBase*>( &command_mem[pos] );
 		
 		cmd->call();
 		cmd->~CommandBase();
 		
-		read_ptr+=size;		
+		_set_read_ptr(pos+size); //only now the producer may reuse the memory
 
 		return true;
 	}
-	
+
+	_FORCE_INLINE_ void commit_and_unlock() {
+
+		if (single_producer) {
+
+			atomic_store_release(&write_ptr,alloc_ptr);
+			//exchange is a full barrier, pairs with the one in _wait_for_commands()
+			if (sync && atomic_exchange(&consumer_idle,0))
+				sync->post();
+		} else {
+
+			write_ptr=alloc_ptr;
+			unlock();
+			if (sync) sync->post();
+		}
+	}
+
+	void _wait_for_commands();
 	
 	void lock();
 	void unlock();
@@ -516,9 +561,7 @@ public:
 		cmd->instance=p_instance;
 		cmd->method=p_method;
 		
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1>
@@ -530,9 +573,7 @@ public:
 		cmd->method=p_method;
 		cmd->p1=p1;
 		
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2>
@@ -545,9 +586,7 @@ public:
 		cmd->p1=p1;
 		cmd->p2=p2;
 		
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2, class P3>
@@ -561,9 +600,7 @@ public:
 		cmd->p2=p2;
 		cmd->p3=p3;
 		
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2, class P3, class P4>
@@ -578,9 +615,7 @@ public:
 		cmd->p3=p3;
 		cmd->p4=p4;
 		
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2, class P3, class P4, class P5>
@@ -596,9 +631,7 @@ public:
 		cmd->p4=p4;
 		cmd->p5=p5;
 		
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2, class P3, class P4, class P5, class P6>
@@ -615,9 +648,7 @@ public:
 		cmd->p5=p5;
 		cmd->p6=p6;
 		
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 
 	template<class T, class M, class P1, class P2, class P3, class P4, class P5, class P6, class P7>
@@ -635,9 +666,7 @@ public:
 		cmd->p6=p6;
 		cmd->p7=p7;
 		
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 	}
 	/*** PUSH AND RET COMMANDS ***/
 	
@@ -653,9 +682,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -671,9 +698,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 		
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -690,9 +715,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -710,9 +733,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -731,9 +752,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -753,9 +772,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -776,9 +793,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 	
@@ -800,9 +815,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-		
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -818,9 +831,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -836,9 +847,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -855,9 +864,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -875,9 +882,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -896,9 +901,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -918,9 +921,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -941,9 +942,7 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
@@ -965,19 +964,33 @@ public:
 		SyncSemaphore *ss=_alloc_sync_sem();
 		cmd->sync=ss;
 
-		unlock();
-
-		if (sync) sync->post();
+		commit_and_unlock();
 		ss->sem->wait();
 	}
 
 	void wait_and_flush_one() {
 		ERR_FAIL_COND(!sync);
+		if (single_producer) {
+			_wait_for_commands();
+			flush_one();
+			return;
+		}
 		sync->wait();
 		lock();
 		flush_one();		
 		unlock();
 	}
+
+	//same as above, but runs everything pending after waking up
+	void wait_and_flush_all() {
+		ERR_FAIL_COND(!sync);
+		if (!single_producer) {
+			wait_and_flush_one(); //one post per command, can't batch without desyncing the semaphore
+			return;
+		}
+		_wait_for_commands();
+		while(flush_one()) {}
+	}
 	
 	void flush_all() {
 			
@@ -990,8 +1003,10 @@ public:
 		}
 		unlock();
 	}
+
+	bool is_single_producer() const { return single_producer; }
 	
-	CommandQueueMT(bool p_sync);
+	CommandQueueMT(bool p_sync,bool p_single_producer=false);
 	~CommandQueueMT();
 	
 };
@@ -30,6 +30,8 @@
 #define DVECTOR_H
 
 #include "os/memory.h"
+#include "error_macros.h"
+#include "safe_refcount.h"
 
 
 /**
@@ -37,184 +39,162 @@
 */
 
 
-extern Mutex* dvector_lock;
-
 template<class T>
 class DVector {
 
-	mutable MID mem;
-		
-		
+	// elements follow the header. "refcount" keeps the memory alive and counts both the owning
+	// DVectors and the Read/Write accessors, "owners" counts only the DVectors and decides copy on write.
+	struct Header {
+
+		SafeRefCount refcount;
+		SafeRefCount owners;
+		int size;
+		int capacity; // elements that fit in the allocation
+	};
+
+	class Lock {
+
+		Header *header;
+	public:
+
+		_FORCE_INLINE_ static T *get_data(Header *p_header) { return reinterpret_cast<T*>(p_header+1); }
+
+		static void release(Header *p_header) {
+
+			if (!p_header->refcount.unref())
+				return;
+
+			T *t=get_data(p_header);
+			for (int i=0;i<p_header->size;i++) {
+
+				t[i].~T();
+			}
+			memfree(p_header);
+		}
+
+		void operator=(const Lock& p_lock) { if (p_lock.header) p_lock.header->refcount.ref(); if (header) release(header); header=p_lock.header; }
+		Lock(Header *p_header) { header=p_header; if (header) header->refcount.ref(); }
+		Lock(const Lock& p_lock) { header=p_lock.header; if (header) header->refcount.ref(); }
+		Lock() { header=NULL; }
+		~Lock() { if (header) release(header); }
+	};
+
+	Header *mem;
+
+	_FORCE_INLINE_ static int _get_alloc_size(int p_elements) {
+
+		return sizeof(Header)+p_elements*sizeof(T);
+	}
+
+	// rounded up for incremental growth, so push_back is amortized
+	_FORCE_INLINE_ static int _get_grow_capacity(int p_elements) {
+
+		return (nearest_power_of_2(_get_alloc_size(p_elements))-sizeof(Header))/sizeof(T);
+	}
+
+	Error _resize(int p_size,bool p_grow);
+
 	void copy_on_write() {
-		
-		if (!mem.is_valid())
-			return;
 
-		if (dvector_lock)
-			dvector_lock->lock();
-					
-		MID_Lock lock( mem );
-		
+		if (!mem)
+			return;
 
-		if ( *(int*)lock.data()  == 1 ) {
-			// one reference, means no refcount changes
-			if (dvector_lock)
-				dvector_lock->unlock();
+		if (mem->owners.get()==1) {
+			// one owner, means no refcount changes
 			return;
 		}
-		
-		MID new_mem= dynalloc( mem.get_size() );
-		
-		if (!new_mem.is_valid()) {
-		
-			if (dvector_lock)
-				dvector_lock->unlock();
-			ERR_FAIL_COND( new_mem.is_valid() ); // out of memory		
-		}
-		
-		MID_Lock dst_lock( new_mem );
-		
-		int *rc = (int*)dst_lock.data();
-		
-		*rc=1;
-		
-		T * dst = (T*)(rc + 1 );
-		
-		T * src =(T*) ((int*)lock.data() + 1 );
-		
-		int count = (mem.get_size() - sizeof(int)) / sizeof(T);
-		
-		for (int i=0;i<count;i++) {
-		
+
+		Header *new_mem = (Header*)memalloc( _get_alloc_size(mem->size) );
+		ERR_FAIL_COND( !new_mem ); // out of memory
+
+		new_mem->refcount.init();
+		new_mem->owners.init();
+		new_mem->size=mem->size;
+		new_mem->capacity=mem->size;
+
+		T * dst = Lock::get_data(new_mem);
+		const T * src = Lock::get_data(mem);
+
+		for (int i=0;i<new_mem->size;i++) {
+
 			memnew_placement( &dst[i], T(src[i]) );
 		}
-		
-		(*(int*)lock.data())--;
-		
-		// unlock all
-		dst_lock=MID_Lock();
-		lock=MID_Lock();
-		
+
+		unreference();
 		mem=new_mem;
-				
-		if (dvector_lock)
-			dvector_lock->unlock();
-				
 	}
-	
+
 	void reference( const DVector& p_dvector ) {
-	
+
+		if (mem==p_dvector.mem)
+			return;
+
 		unreference();
-				
-		if (dvector_lock)
-			dvector_lock->lock();
-		
-		if (!p_dvector.mem.is_valid()) {
-		
-			if (dvector_lock)
-				dvector_lock->unlock();
-			return;			
-		}
-		
-		MID_Lock lock(p_dvector.mem);
-		
-		int * rc = (int*)lock.data();
-		(*rc)++;
-		
-		lock = MID_Lock();
+
+		if (!p_dvector.mem)
+			return;
+
+		p_dvector.mem->refcount.ref();
+		p_dvector.mem->owners.ref();
 		mem=p_dvector.mem;
-			
-		if (dvector_lock)
-			dvector_lock->unlock();
-			
 	}
-	
-	
+
+
 	void unreference() {
-	
-		if (dvector_lock)
-			dvector_lock->lock();
-		
-		if (!mem.is_valid()) {
-		
-			if (dvector_lock)
-				dvector_lock->unlock();
-			return;			
-		}
-		
-		MID_Lock lock(mem);
-		
-		int * rc = (int*)lock.data();
-		(*rc)--;
-		
-		if (*rc==0) {
-			// no one else using it, destruct
-			
-			T * t= (T*)(rc+1);
-			int count = (mem.get_size() - sizeof(int)) / sizeof(T);
-			
-			for (int i=0;i<count;i++) {
-			
-				t[i].~T();
-			}
-						
-		}
-			
-		
-		lock = MID_Lock();
-		
-		mem = MID ();
-		
-		if (dvector_lock)
-			dvector_lock->unlock();
-					
+
+		if (!mem)
+			return;
+
+		mem->owners.unref();
+		Lock::release(mem);
+		mem=NULL;
 	}
-	
+
 public:
 
 	class Read {
 	friend class DVector;
-		MID_Lock lock;
+		Lock lock;
 		const T * mem;
 	public:
-	
+
 		_FORCE_INLINE_ const T& operator[](int p_index) const { return mem[p_index]; }
 		_FORCE_INLINE_ const T *ptr() const { return mem; }
-		
+
 		Read() { mem=NULL; }
 	};
 
 	class Write {
 	friend class DVector;
-		MID_Lock lock;
+		Lock lock;
 		T * mem;
 	public:
-	
+
 		_FORCE_INLINE_ T& operator[](int p_index) { return mem[p_index]; }
 		_FORCE_INLINE_ T *ptr() { return mem; }
-		
+
 		Write() { mem=NULL; }
 	};
 
 
 	Read read() const {
-	
+
 		Read r;
-		if (mem.is_valid()) {		
-			r.lock = MID_Lock( mem );
-			r.mem = (const T*)((int*)r.lock.data()+1);
+		if (mem) {
+			r.lock = Lock( mem );
+			r.mem = Lock::get_data(mem);
 		}
-		return r;		
+		return r;
 	}
 	Write write() {
-	
+
 		Write w;
-		if (mem.is_valid()) {
+		if (mem) {
 			copy_on_write();
-			w.lock = MID_Lock( mem );
-			w.mem = (T*)((int*)w.lock.data()+1);
+			w.lock = Lock( mem );
+			w.mem = Lock::get_data(mem);
 		}
-		return w;		
+		return w;
 	}
 
 	template<class MC>
@@ -255,23 +235,24 @@ public:
 		if (ds==0)
 			return;
 		int bs = size();
-		resize( bs + ds);
+		_resize( bs + ds, true);
 		Write w = write();
 		Read r = p_arr.read();
 		for(int i=0;i<ds;i++)
 			w[bs+i]=r[i];
 	}
 
-	bool is_locked() const { return mem.is_locked(); }
-	
+	// a Read or Write of this vector is alive
+	bool is_locked() const { return mem && mem->refcount.get()!=mem->owners.get(); }
+
 	inline const T operator[](int p_index) const;
 
-	Error resize(int p_size);
-	
-	
+	Error resize(int p_size) { return _resize(p_size,false); }
+
+
 	void operator=(const DVector& p_dvector) { reference(p_dvector); }
-	DVector() {}
-	DVector(const DVector& p_dvector) { reference(p_dvector); }
+	DVector() { mem=NULL; }
+	DVector(const DVector& p_dvector) { mem=NULL; reference(p_dvector); }
 	~DVector() { unreference(); }
 
 };
@@ -279,7 +260,7 @@ public:
 template<class T>
 int DVector<T>::size() const {
 
-	return mem.is_valid() ? ((mem.get_size() - sizeof(int)) / sizeof(T) ) : 0;
+	return mem ? mem->size : 0;
 }
 
 template<class T>
@@ -291,18 +272,18 @@ T DVector<T>::get(int p_index) const {
 template<class T>
 void DVector<T>::set(int p_index, const T& p_val) {
 
-	if (p_index<0 || p_index>=size()) {		
+	if (p_index<0 || p_index>=size()) {
 		ERR_FAIL_COND(p_index<0 || p_index>=size());
 	}
 
-	Write w = write();
-	w[p_index]=p_val;
+	copy_on_write();
+	Lock::get_data(mem)[p_index]=p_val;
 }
 
 template<class T>
 void DVector<T>::push_back(const T& p_val) {
 
-	resize( size() + 1 );
+	_resize( size() + 1, true );
 	set( size() -1, p_val );
 }
 
@@ -314,96 +295,81 @@ const T DVector<T>::operator[](int p_index) const {
 		ERR_FAIL_COND_V(p_index<0 || p_index>=size(),aux);
 	}
 
-	Read r = read();
-	
-	return r[p_index];
+	// this vector holds a reference, no need to lock for reading
+	return Lock::get_data(mem)[p_index];
 }
 
 
 template<class T>
-Error DVector<T>::resize(int p_size) {
-
-	if (dvector_lock)
-		dvector_lock->lock();
-
-	bool same = p_size==size();
-	
-	if (dvector_lock)
-		dvector_lock->unlock();
-	// no further locking is necesary because we are supposed to own the only copy of this (using copy on write)	
-	
-	if (same)
+Error DVector<T>::_resize(int p_size,bool p_grow) {
+
+	ERR_FAIL_COND_V(p_size<0,ERR_INVALID_PARAMETER);
+
+	int oldsize=size();
+
+	if (p_size==oldsize)
 		return OK;
 
 	if (p_size == 0 ) {
-	
+
 		unreference();
 		return OK;
 	}
 
 
 	copy_on_write(); // make it unique
-	
-	ERR_FAIL_COND_V( mem.is_locked(), ERR_LOCKED ); // if after copy on write, memory is locked, fail.
-	
-	if (p_size > size() ) {
-	
-		int oldsize=size();
-		
-		MID_Lock lock;
-		
-		if (oldsize==0) {
-
-			mem = dynalloc( p_size * sizeof(T) + sizeof(int) );
-			lock=MID_Lock(mem);
-			int *rc = ((int*)lock.data());
-			*rc=1;
-			
-		} else {
 
-			if (dynrealloc( mem, p_size * sizeof(T) + sizeof(int) )!=OK ) {
-			
-				ERR_FAIL_V(ERR_OUT_OF_MEMORY); // out of memory
-			}
-			
-			lock=MID_Lock(mem);			
-		}
-	
-	
-		
-		
-		T *t = (T*)((int*)lock.data() + 1);
-		
-		for (int i=oldsize;i<p_size;i++) {
-		
-			memnew_placement(&t[i], T );
-		}
-		
-		lock = MID_Lock(); // clear
+	ERR_FAIL_COND_V( is_locked(), ERR_LOCKED ); // if after copy on write, memory is locked, fail.
+
+	if (oldsize==0) {
+
+		int capacity = p_grow ? _get_grow_capacity(p_size) : p_size;
+		mem = (Header*)memalloc( _get_alloc_size(capacity) );
+		ERR_FAIL_COND_V( !mem, ERR_OUT_OF_MEMORY );
+		mem->refcount.init();
+		mem->owners.init();
+		mem->size=0;
+		mem->capacity=capacity;
+
 	} else {
-	
-		int oldsize=size();
-	
-		MID_Lock lock(mem);
-		
-		
-		T *t = (T*)((int*)lock.data() + 1);
-		
+
+		T *t = Lock::get_data(mem);
+
 		for (int i=p_size;i<oldsize;i++) {
-		
+
 			t[i].~T();
 		}
-		
-		lock = MID_Lock(); // clear
-	
-		if (dynrealloc( mem, p_size * sizeof(T) + sizeof(int) )!=OK ) {
-	
-			ERR_FAIL_V(ERR_OUT_OF_MEMORY); // wtf error		
+
+		// plain resize allocates exactly, growing by push_back/append keeps spare room
+		int capacity = mem->capacity;
+		if (p_grow) {
+			if (p_size>capacity)
+				capacity=_get_grow_capacity(p_size);
+		} else {
+			capacity=p_size;
+		}
+
+		if (capacity!=mem->capacity) {
+
+			Header *new_mem = (Header*)memrealloc( mem, _get_alloc_size(capacity) );
+			if (!new_mem) {
+				mem->size=MIN(p_size,oldsize);
+				ERR_FAIL_V(ERR_OUT_OF_MEMORY); // out of memory
+			}
+			mem=new_mem;
+			mem->capacity=capacity;
 		}
-		
-		
 	}
-	
+
+	T *t = Lock::get_data(mem);
+
+	for (int i=oldsize;i<p_size;i++) {
+
+		memnew_placement(&t[i], T );
+	}
+
+	mem->size=p_size;
+
 	return OK;
 }
 
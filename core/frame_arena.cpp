@@ -0,0 +1,232 @@
+/*************************************************************************/
+/*  frame_arena.cpp                                                      */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "frame_arena.h"
+#include "safe_refcount.h"
+#include "error_macros.h"
+
+#ifdef NO_THREADS
+#define _FRAME_ARENA_TLS
+#elif defined(_MSC_VER)
+#define _FRAME_ARENA_TLS __declspec(thread)
+#else
+#define _FRAME_ARENA_TLS __thread
+#endif
+
+static _FRAME_ARENA_TLS FrameArena *_thread_arena=NULL;
+
+FrameArena *FrameArena::arena_list=NULL;
+FrameArena *FrameArena::main_arena=NULL;
+
+#define CHUNK_HEADER ((sizeof(Chunk)+BLOCK_HEADER-1)&~(size_t)(BLOCK_HEADER-1))
+
+FrameArena *FrameArena::_get() {
+
+	FrameArena *a=_thread_arena;
+	if (a)
+		return a;
+
+	a = memnew( FrameArena );
+	_global_lock();
+	a->next_arena=arena_list;
+	arena_list=a;
+	_global_unlock();
+	_thread_arena=a;
+	return a;
+}
+
+void FrameArena::_rewind() {
+
+	current=first;
+	pos=CHUNK_HEADER;
+	used=0;
+}
+
+void *FrameArena::_alloc_chunk(size_t p_size) {
+
+	if (current && current->next) {
+		//reuse a chunk from a previous frame
+		current=current->next;
+	} else {
+
+		Chunk *c = (Chunk*)memalloc(CHUNK_SIZE);
+		ERR_FAIL_COND_V(!c,NULL);
+		c->next=NULL;
+		c->size=CHUNK_SIZE;
+		if (current)
+			current->next=c;
+		else
+			first=c;
+		current=c;
+		reserved+=CHUNK_SIZE;
+	}
+
+	pos=CHUNK_HEADER+p_size;
+	return (uint8_t*)current+CHUNK_HEADER;
+}
+
+void *FrameArena::alloc(size_t p_bytes) {
+
+	size_t size = (p_bytes+BLOCK_HEADER+BLOCK_HEADER-1)&~(size_t)(BLOCK_HEADER-1);
+	uint8_t *mem;
+
+	if (size>MAX_BLOCK_SIZE) {
+
+		mem = (uint8_t*)memalloc(size);
+		ERR_FAIL_COND_V(!mem,NULL);
+		*(FrameArena**)mem=NULL; //heap block, no owner
+		return mem+BLOCK_HEADER;
+	}
+
+	FrameArena *a=_get();
+
+	if (a->live==0 && a->used) // blocks were freed from another thread
+		a->_rewind();
+
+	if (!a->current || a->pos+size > a->current->size) {
+
+		mem = (uint8_t*)a->_alloc_chunk(size);
+		if (!mem)
+			return NULL;
+	} else {
+
+		mem = (uint8_t*)a->current+a->pos;
+		a->pos+=size;
+	}
+
+	a->used+=size;
+	if (a->used>a->frame_peak) {
+		a->frame_peak=a->used;
+		if (a->used>a->peak)
+			a->peak=a->used;
+	}
+
+	atomic_add(&a->live,1);
+	*(FrameArena**)mem=a;
+	return mem+BLOCK_HEADER;
+}
+
+void FrameArena::free(void *p_ptr) {
+
+	if (!p_ptr)
+		return;
+
+	uint8_t *mem = (uint8_t*)p_ptr-BLOCK_HEADER;
+	FrameArena *owner = *(FrameArena**)mem;
+
+	if (!owner) {
+		memfree(mem);
+		return;
+	}
+
+	// memory is only reclaimed by the owner thread, other threads just release their reference
+	if (atomic_sub(&owner->live,1)==0 && owner==_thread_arena)
+		owner->_rewind();
+}
+
+void FrameArena::end_frame() {
+
+	FrameArena *a=_get();
+	main_arena=a;
+
+	if (a->live==0) {
+		a->_rewind();
+	} else if (!a->leak_reported) {
+		a->leak_reported=true;
+		ERR_PRINT("Frame arena blocks still in use at the end of the frame, arena can't be reset.");
+	}
+
+	a->last_frame_peak=a->frame_peak;
+	a->frame_peak=a->used;
+}
+
+void FrameArena::finish() {
+
+	_global_lock();
+	while(arena_list) {
+
+		FrameArena *a=arena_list;
+		arena_list=a->next_arena;
+		memdelete(a);
+	}
+	main_arena=NULL;
+	_global_unlock();
+	_thread_arena=NULL;
+}
+
+size_t FrameArena::get_frame_peak() {
+
+	return main_arena ? main_arena->last_frame_peak : 0;
+}
+
+size_t FrameArena::get_peak() {
+
+	size_t peak=0;
+	_global_lock();
+	for(FrameArena *a=arena_list;a;a=a->next_arena) {
+		if (a->peak>peak)
+			peak=a->peak;
+	}
+	_global_unlock();
+	return peak;
+}
+
+size_t FrameArena::get_reserved() {
+
+	size_t reserved=0;
+	_global_lock();
+	for(FrameArena *a=arena_list;a;a=a->next_arena)
+		reserved+=a->reserved;
+	_global_unlock();
+	return reserved;
+}
+
+FrameArena::FrameArena() {
+
+	first=NULL;
+	current=NULL;
+	pos=CHUNK_HEADER;
+	used=0;
+	frame_peak=0;
+	last_frame_peak=0;
+	peak=0;
+	reserved=0;
+	live=0;
+	leak_reported=false;
+	next_arena=NULL;
+}
+
+FrameArena::~FrameArena() {
+
+	while(first) {
+
+		Chunk *c=first;
+		first=c->next;
+		memfree(c);
+	}
+}
@@ -0,0 +1,102 @@
+/*************************************************************************/
+/*  frame_arena.h                                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include "os/memory.h"
+
+/**
+ * Per thread bump allocator for temporaries that never outlive the frame
+ * they were created in. Blocks are carved linearly out of chunks and only
+ * reclaimed in bulk, once every block of the thread has been freed. The
+ * main loop calls end_frame() at the end of each iteration to collect the
+ * usage statistics.
+ */
+
+class FrameArena {
+
+	enum {
+		CHUNK_SIZE=64*1024,
+		BLOCK_HEADER=16, // keeps returned blocks 16 bytes aligned
+		MAX_BLOCK_SIZE=CHUNK_SIZE/4 // bigger requests go to the heap
+	};
+
+	struct Chunk {
+
+		Chunk *next;
+		size_t size;
+	};
+
+	Chunk *first;
+	Chunk *current;
+	size_t pos; // offset in current chunk
+	size_t used; // bytes handed out since last rewind
+	size_t frame_peak;
+	size_t last_frame_peak;
+	size_t peak;
+	size_t reserved;
+	volatile uint32_t live;
+	bool leak_reported;
+	FrameArena *next_arena;
+
+	static FrameArena *arena_list;
+	static FrameArena *main_arena;
+
+	static FrameArena *_get();
+	void _rewind();
+	void *_alloc_chunk(size_t p_size);
+
+public:
+
+	static void *alloc(size_t p_bytes);
+	static void free(void *p_ptr);
+
+	static void end_frame(); // call from the main thread only
+	static void finish();
+
+	static size_t get_frame_peak(); // main thread, last complete frame
+	static size_t get_peak(); // any thread, since startup
+	static size_t get_reserved(); // chunk memory held by all threads
+
+	FrameArena();
+	~FrameArena();
+};
+
+/**
+ * Allocator adapter for List, Map and Set, ie: List<Node*,FrameAllocator>.
+ * Only use for containers that are destroyed before the frame ends.
+ */
+
+class FrameAllocator {
+public:
+	_FORCE_INLINE_ static void *alloc(size_t p_memory) { return FrameArena::alloc(p_memory); }
+	_FORCE_INLINE_ static void free(void *p_ptr) { FrameArena::free(p_ptr); }
+};
+
+#endif // FRAME_ARENA_H
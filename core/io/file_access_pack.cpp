@@ -28,8 +28,10 @@
 /*************************************************************************/
 #include "file_access_pack.h"
 #include "version.h"
+#include "io/marshalls.h"
 
 #include <stdio.h>
+#include <string.h>
 
 Error PackedData::add_pack(const String& p_path) {
 
@@ -46,41 +48,50 @@ Error PackedData::add_pack(const String& p_path) {
 
 void PackedData::add_path(const String& pkg_path, const String& path, uint64_t ofs, uint64_t size, PackSource* p_src) {
 
-	bool exists = files.has(path);
-
 	PackedFile pf;
 	pf.pack=pkg_path;
 	pf.offset=ofs;
 	pf.size=size;
 	pf.src = p_src;
 
-	files[path]=pf;
+	PackedFile *existing=files.getptr(path);
+	if (existing) {
+		*existing=pf;
+		return;
+	}
+
+	files.set(path,pf);
 
-	if (!exists) {
-		//search for dir
-		String p = path.replace_first("res://","");
-		PackedDir *cd=root;
+	//search for dir
+	String p = path.replace_first("res://","");
+	String base = p.get_base_dir();
+	PackedDir *cd=root;
 
-		if (p.find("/")!=-1) { //in a subdir
+	if (last_dir && base==last_dir_path) {
 
-			Vector<String> ds=p.get_base_dir().split("/");
+		cd=last_dir;
+	} else if (base!="") { //in a subdir
 
-			for(int j=0;j<ds.size();j++) {
+		Vector<String> ds=base.split("/");
 
-				if (!cd->subdirs.has(ds[j])) {
+		for(int j=0;j<ds.size();j++) {
 
-					PackedDir *pd = memnew( PackedDir );
-					pd->name=ds[j];
-					pd->parent=cd;
-					cd->subdirs[pd->name]=pd;
-					cd=pd;
-				} else {
-					cd=cd->subdirs[ds[j]];
-				}
+			if (!cd->subdirs.has(ds[j])) {
+
+				PackedDir *pd = memnew( PackedDir );
+				pd->name=ds[j];
+				pd->parent=cd;
+				cd->subdirs[pd->name]=pd;
+				cd=pd;
+			} else {
+				cd=cd->subdirs[ds[j]];
 			}
 		}
-		cd->files.insert(path.get_file());
 	}
+
+	last_dir_path=base;
+	last_dir=cd;
+	cd->files.insert(path.get_file());
 }
 
 void PackedData::add_pack_source(PackSource *p_source) {
@@ -95,9 +106,16 @@ PackedData::PackedData() {
 	singleton=this;
 	root=memnew(PackedDir);
 	root->parent=NULL;
+	last_dir=NULL;
 	disabled=false;
 
-	add_pack_source(memnew(PackedSourcePCK));
+	pck_source=memnew(PackedSourcePCK);
+	add_pack_source(pck_source);
+}
+
+PackedData::~PackedData() {
+
+	memdelete(pck_source);
 }
 
 
@@ -150,6 +168,42 @@ bool PackedSourcePCK::try_open_pack(const String& p_path) {
 
 	int file_count = f->get_32();
 
+	const uint8_t *data = mapped_packs.has(p_path) ? NULL : f->map_read_only();
+
+	if (data) {
+
+		// parse the index in place, reading it through get_32()/get_64() costs a read call per byte
+		uint64_t len=f->get_len();
+		uint64_t pos=f->get_pos();
+
+		for(int i=0;i<file_count;i++) {
+
+			ERR_EXPLAIN("Truncated index in pack: "+p_path);
+			ERR_BREAK(pos+4>len);
+			uint32_t sl = decode_uint32(&data[pos]);
+			pos+=4;
+			ERR_EXPLAIN("Truncated index in pack: "+p_path);
+			ERR_BREAK(pos+sl+16>len);
+
+			String path;
+			path.parse_utf8((const char*)&data[pos],sl);
+			pos+=sl;
+
+			uint64_t ofs = decode_uint64(&data[pos]);
+			uint64_t size = decode_uint64(&data[pos+8]);
+			pos+=16;
+
+			PackedData::get_singleton()->add_path(p_path, path, ofs, size, this);
+		}
+
+		MappedPack mp;
+		mp.f=f;
+		mp.data=data;
+		mp.len=len;
+		mapped_packs[p_path]=mp;
+		return true;
+	}
+
 	for(int i=0;i<file_count;i++) {
 
 		uint32_t sl = f->get_32();
@@ -167,14 +221,28 @@ bool PackedSourcePCK::try_open_pack(const String& p_path) {
 		PackedData::get_singleton()->add_path(p_path, path, ofs, size, this);
 	};
 
+	memdelete(f);
+
 	return true;
 };
 
 FileAccess* PackedSourcePCK::get_file(const String &p_path, PackedData::PackedFile* p_file) {
 
+	const Map<String,MappedPack>::Element *E=mapped_packs.find(p_file->pack);
+	if (E && p_file->offset+p_file->size<=E->get().len)
+		return memnew( FileAccessPack(p_path, *p_file, E->get().data));
+
 	return memnew( FileAccessPack(p_path, *p_file));
 };
 
+PackedSourcePCK::~PackedSourcePCK() {
+
+	for (Map<String,MappedPack>::Element *E=mapped_packs.front();E;E=E->next()) {
+
+		memdelete(E->get().f);
+	}
+}
+
 //////////////////////////////////////////////////////////////////
 
 
@@ -186,11 +254,17 @@ Error FileAccessPack::_open(const String& p_path, int p_mode_flags) {
 
 void FileAccessPack::close() {
 
+	if (!f) {
+		data=NULL;
+		return;
+	}
 	f->close();
 }
 
 bool FileAccessPack::is_open() const{
 
+	if (!f)
+		return data!=NULL;
 	return f->is_open();
 }
 
@@ -202,7 +276,9 @@ void FileAccessPack::seek(size_t p_position){
 		eof=false;
 	}
 
-	f->seek(pf.offset+p_position);
+	pos=p_position;
+	if (!data)
+		f->seek(pf.offset+p_position);
 }
 void FileAccessPack::seek_end(int64_t p_position){
 
@@ -230,6 +306,9 @@ uint8_t FileAccessPack::get_8() const {
 		return 0;
 	}
 
+	if (data)
+		return data[pos++];
+
 	pos++;
 	return f->get_8();
 }
@@ -246,18 +325,35 @@ int FileAccessPack::get_buffer(uint8_t *p_dst,int p_length) const {
 		to_read=int64_t(pf.size)-int64_t(pos);
 	}
 
+	size_t from=pos;
 	pos+=p_length;
 
 	if (to_read<=0)
 		return 0;
-	f->get_buffer(p_dst,to_read);
+
+	if (data)
+		memcpy(p_dst,&data[from],to_read);
+	else
+		f->get_buffer(p_dst,to_read);
 
 	return to_read;
 }
 
+const uint8_t *FileAccessPack::get_buffer_ptr(int p_length) const {
+
+	// only mapped packs can be read in place, short reads fall back to get_buffer
+	if (!data || eof || p_length<0 || pos+p_length > pf.size)
+		return NULL;
+
+	const uint8_t *ptr=&data[pos];
+	pos+=p_length;
+	return ptr;
+}
+
 void FileAccessPack::set_endian_swap(bool p_swap) {
 	FileAccess::set_endian_swap(p_swap);
-	f->set_endian_swap(p_swap);
+	if (f)
+		f->set_endian_swap(p_swap);
 }
 
 Error FileAccessPack::get_error() const {
@@ -285,17 +381,26 @@ bool FileAccessPack::file_exists(const String& p_name) {
 }
 
 
-FileAccessPack::FileAccessPack(const String& p_path, const PackedData::PackedFile& p_file) {
+FileAccessPack::FileAccessPack(const String& p_path, const PackedData::PackedFile& p_file, const uint8_t *p_mapped_pack) {
 
 	pf=p_file;
+	pos=0;
+	eof=false;
+	f=NULL;
+	data=NULL;
+
+	if (p_mapped_pack) {
+		// no open or seek needed, reads are served from the shared mapping
+		data=p_mapped_pack+pf.offset;
+		return;
+	}
+
 	f=FileAccess::open(pf.pack,FileAccess::READ);
 	if (!f) {
 		ERR_EXPLAIN("Can't open pack-referenced file: "+String(pf.pack));
 		ERR_FAIL_COND(!f);
 	}
 	f->seek(pf.offset);
-	pos=0;
-	eof=false;
 }
 
 FileAccessPack::~FileAccessPack() {
@@ -32,6 +32,7 @@
 #include "os/file_access.h"
 #include "os/dir_access.h"
 #include "map.h"
+#include "oa_hash_map.h"
 #include "list.h"
 #include "print_string.h"
 
@@ -60,10 +61,13 @@ private:
 	};
 
 
-	Map<String,PackedFile> files;
+	OAHashMap<String,PackedFile> files;
 	Vector<PackSource*> sources;
 
 	PackedDir *root;
+	String last_dir_path; // entries come grouped by directory, skip the tree walk for runs of them
+	PackedDir *last_dir;
+	PackSource *pck_source;
 	//Map<String,PackedDir*> dirs;
 
 	static PackedData *singleton;
@@ -84,6 +88,7 @@ public:
 	_FORCE_INLINE_ bool has_path(const String& p_path);
 
 	PackedData();
+	~PackedData();
 };
 
 class PackSource {
@@ -92,14 +97,26 @@ public:
 
 	virtual bool try_open_pack(const String& p_path)=0;
 	virtual FileAccess* get_file(const String& p_path, PackedData::PackedFile* p_file)=0;
+	virtual ~PackSource() {}
 };
 
 class PackedSourcePCK : public PackSource {
 
+	// packs are mapped once and shared by every FileAccessPack opened from them
+	struct MappedPack {
+		FileAccess *f;
+		const uint8_t *data;
+		uint64_t len;
+	};
+
+	Map<String,MappedPack> mapped_packs;
+
 public:
 
 	virtual bool try_open_pack(const String &p_path);
 	virtual FileAccess* get_file(const String& p_path, PackedData::PackedFile* p_file);
+
+	~PackedSourcePCK();
 };
 
 
@@ -111,6 +128,7 @@ class FileAccessPack : public FileAccess {
 	mutable bool eof;
 
 	FileAccess *f;
+	const uint8_t *data; // start of the file inside a mapped pack, f is NULL when set
 	virtual Error _open(const String& p_path, int p_mode_flags);
 	virtual uint64_t _get_modified_time(const String& p_file) { return 0; }
 
@@ -131,6 +149,7 @@ public:
 
 
 	virtual int get_buffer(uint8_t *p_dst,int p_length) const;
+	virtual const uint8_t *get_buffer_ptr(int p_length) const;
 
 	virtual void set_endian_swap(bool p_swap);
 
@@ -143,16 +162,16 @@ public:
 	virtual bool file_exists(const String& p_name);
 
 
-	FileAccessPack(const String& p_path, const PackedData::PackedFile& p_file);
+	FileAccessPack(const String& p_path, const PackedData::PackedFile& p_file, const uint8_t *p_mapped_pack=NULL);
 	~FileAccessPack();
 };
 
 
 FileAccess *PackedData::try_open_path(const String& p_path) {
 
-	if (files.has(p_path)) {
-		return files[p_path].src->get_file(p_path, &files[p_path]);
-	}
+	PackedFile *pf=files.getptr(p_path);
+	if (pf)
+		return pf->src->get_file(p_path, pf);
 
 	return NULL;
 }
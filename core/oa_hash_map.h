@@ -0,0 +1,448 @@
+/*************************************************************************/
+/*  oa_hash_map.h                                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#ifndef OA_HASH_MAP_H
+#define OA_HASH_MAP_H
+
+#include "hash_map.h"
+#include <string.h>
+
+/**
+ * @class OAHashMap
+ *
+ * Open addressing variant of HashMap, with the same interface. Pairs are kept in a single flat array
+ * using Robin Hood linear probing and backward shift erasing, so there is no allocation per element
+ * and lookups touch contiguous memory.
+ *
+ * Unlike HashMap, inserting or erasing may move other pairs: pointers returned by getptr()/next()
+ * are only valid until the map is modified, and the iteration order changes on every rehash.
+ * Pairs are relocated with memcpy, as Vector does on resize, so TKey and TData must be trivially relocatable
+ * (true for engine types like String, StringName, Ref or Variant, which hold no pointers into themselves).
+ * The table grows but only shrinks on clear().
+ */
+
+template<class TKey, class TData, class Hasher=HashMapHahserDefault,uint8_t MIN_HASH_TABLE_POWER=3>
+class OAHashMap {
+public:
+
+	struct Pair {
+
+		TKey key;
+		TData data;
+
+		Pair() {}
+		Pair(const TKey& p_key, const TData& p_data) { key=p_key; data=p_data; }
+	};
+
+private:
+
+	enum {
+		EMPTY_HASH=0 //slot is free, real hashes equal to it are remapped
+	};
+
+	union _PairStorage {
+
+		uint8_t data[sizeof(Pair)];
+		uint64_t _align;
+		double _align_d;
+		void *_align_p;
+	};
+
+	Pair *pairs; //constructed only where hashes[i]!=EMPTY_HASH
+	uint32_t *hashes;
+	uint32_t capacity;
+	uint32_t elements;
+
+	_FORCE_INLINE_ static uint32_t _hash(const TKey& p_key) {
+
+		uint32_t hash = Hasher::hash(p_key);
+		return hash==EMPTY_HASH ? EMPTY_HASH+1 : hash;
+	}
+
+	_FORCE_INLINE_ uint32_t _probe_distance(uint32_t p_hash,uint32_t p_pos) const {
+
+		return (p_pos-(p_hash&(capacity-1)))&(capacity-1);
+	}
+
+	_FORCE_INLINE_ static void _swap_raw(void *p_a,void *p_b) {
+
+		_PairStorage tmp;
+		memcpy(tmp.data,(const void*)p_a,sizeof(Pair));
+		memcpy((void*)p_a,(const void*)p_b,sizeof(Pair));
+		memcpy((void*)p_b,tmp.data,sizeof(Pair));
+	}
+
+	template<class C>
+	_FORCE_INLINE_ bool _lookup_pos(const C& p_key,uint32_t p_hash,uint32_t &r_pos) const {
+
+		if (!elements)
+			return false;
+
+		uint32_t pos=p_hash&(capacity-1);
+		uint32_t distance=0;
+
+		while(true) {
+
+			uint32_t h=hashes[pos];
+			if (h==EMPTY_HASH || distance>_probe_distance(h,pos))
+				return false; //robin hood: would have been placed before this one
+			/* checking hash first avoids comparing key, which may take longer */
+			if (h==p_hash && pairs[pos].key==p_key) {
+				r_pos=pos;
+				return true;
+			}
+
+			pos=(pos+1)&(capacity-1);
+			distance++;
+		}
+	}
+
+	/* places the raw pair in p_pair (which is left undefined), returns the slot where it ends */
+	uint32_t _insert_raw(uint32_t p_hash,void *p_pair) {
+
+		uint32_t pos=p_hash&(capacity-1);
+		uint32_t distance=0;
+		uint32_t placed=capacity;
+
+		while(true) {
+
+			uint32_t h=hashes[pos];
+			if (h==EMPTY_HASH) {
+
+				memcpy((void*)&pairs[pos],(const void*)p_pair,sizeof(Pair));
+				hashes[pos]=p_hash;
+				return placed==capacity ? pos : placed;
+			}
+
+			uint32_t existing_distance=_probe_distance(h,pos);
+			if (existing_distance<distance) {
+				//take the slot from the richer pair, and carry it forward
+				_swap_raw(&pairs[pos],p_pair);
+				hashes[pos]=p_hash;
+				p_hash=h;
+				distance=existing_distance;
+				if (placed==capacity)
+					placed=pos;
+			}
+
+			pos=(pos+1)&(capacity-1);
+			distance++;
+		}
+	}
+
+	void _resize(uint32_t p_capacity) {
+
+		Pair *old_pairs=pairs;
+		uint32_t *old_hashes=hashes;
+		uint32_t old_capacity=capacity;
+
+		capacity=p_capacity;
+		pairs=(Pair*)memalloc(sizeof(Pair)*capacity);
+		hashes=(uint32_t*)memalloc(sizeof(uint32_t)*capacity);
+		for(uint32_t i=0;i<capacity;i++) {
+
+			hashes[i]=EMPTY_HASH;
+		}
+
+		for(uint32_t i=0;i<old_capacity;i++) {
+
+			if (old_hashes[i]!=EMPTY_HASH)
+				_insert_raw(old_hashes[i],&old_pairs[i]);
+		}
+
+		if (old_pairs) {
+			memfree(old_pairs);
+			memfree(old_hashes);
+		}
+	}
+
+	Pair *_create(const TKey& p_key,uint32_t p_hash,const TData& p_data) {
+
+		if (!capacity)
+			_resize(1<<MIN_HASH_TABLE_POWER);
+		else if ((elements+1)*4 > capacity*3)
+			_resize(capacity*2); //keep load under 3/4
+
+		_PairStorage tmp;
+		memnew_placement(tmp.data,Pair(p_key,p_data));
+		elements++;
+		return &pairs[_insert_raw(p_hash,tmp.data)];
+	}
+
+	void copy_from(const OAHashMap& p_t) {
+
+		if (&p_t==this)
+			return; /* much less bother with that */
+
+		clear();
+
+		if (!p_t.elements)
+			return; /* not copying from empty table */
+
+		/* same capacity, so every pair can go to the same slot */
+		capacity=p_t.capacity;
+		elements=p_t.elements;
+		pairs=(Pair*)memalloc(sizeof(Pair)*capacity);
+		hashes=(uint32_t*)memalloc(sizeof(uint32_t)*capacity);
+
+		for(uint32_t i=0;i<capacity;i++) {
+
+			hashes[i]=p_t.hashes[i];
+			if (hashes[i]!=EMPTY_HASH)
+				memnew_placement(&pairs[i],Pair(p_t.pairs[i]));
+		}
+	}
+
+public:
+
+	void set( const TKey& p_key, const TData& p_data ) {
+
+		uint32_t hash=_hash(p_key);
+		uint32_t pos;
+		if (_lookup_pos(p_key,hash,pos))
+			pairs[pos].data=p_data;
+		else
+			_create(p_key,hash,p_data);
+	}
+
+	void set( const Pair& p_pair ) {
+
+		set(p_pair.key,p_pair.data);
+	}
+
+	bool has( const TKey& p_key ) const {
+
+		uint32_t pos;
+		return _lookup_pos(p_key,_hash(p_key),pos);
+	}
+
+	/**
+	 * Get a key from data, return a const reference.
+	 * WARNING: this doesn't check errors, use either getptr and check NULL, or check
+	 * first with has(key)
+	 */
+
+	const TData& get( const TKey& p_key ) const {
+
+		const TData* res = getptr(p_key);
+		ERR_FAIL_COND_V(!res,*res);
+		return *res;
+	}
+
+	TData& get( const TKey& p_key )  {
+
+		TData* res = getptr(p_key);
+		ERR_FAIL_COND_V(!res,*res);
+		return *res;
+	}
+
+	/**
+	 * Same as get, except it can return NULL when item was not found.
+	 * The pointer is invalidated by any insertion or erasure.
+	 */
+
+	_FORCE_INLINE_  TData* getptr( const TKey& p_key ) {
+
+		uint32_t pos;
+		if (!_lookup_pos(p_key,_hash(p_key),pos))
+			return NULL;
+		return &pairs[pos].data;
+	}
+
+	_FORCE_INLINE_  const TData* getptr( const TKey& p_key ) const {
+
+		uint32_t pos;
+		if (!_lookup_pos(p_key,_hash(p_key),pos))
+			return NULL;
+		return &pairs[pos].data;
+	}
+
+	/**
+	 * Same as getptr, but takes a hash and a custom key (that should support operator==()
+	 * with TKey), like HashMap::custom_getptr. The hash must match the one Hasher produces.
+	 */
+
+	template<class C>
+	_FORCE_INLINE_ TData* custom_getptr( C p_custom_key,uint32_t p_custom_hash )  {
+
+		uint32_t pos;
+		if (!_lookup_pos(p_custom_key,p_custom_hash==EMPTY_HASH?EMPTY_HASH+1:p_custom_hash,pos))
+			return NULL;
+		return &pairs[pos].data;
+	}
+
+	template<class C>
+	_FORCE_INLINE_ const TData* custom_getptr( C p_custom_key,uint32_t p_custom_hash ) const {
+
+		uint32_t pos;
+		if (!_lookup_pos(p_custom_key,p_custom_hash==EMPTY_HASH?EMPTY_HASH+1:p_custom_hash,pos))
+			return NULL;
+		return &pairs[pos].data;
+	}
+
+	/**
+	 * Erase an item, return true if erasing was succesful
+	 */
+
+	bool erase( const TKey& p_key ) {
+
+		uint32_t pos;
+		if (!_lookup_pos(p_key,_hash(p_key),pos))
+			return false;
+
+		pairs[pos].~Pair();
+		hashes[pos]=EMPTY_HASH;
+		elements--;
+
+		/* backward shift the following pairs of the run, so no tombstones are needed */
+		uint32_t next=(pos+1)&(capacity-1);
+		while(hashes[next]!=EMPTY_HASH && _probe_distance(hashes[next],next)!=0) {
+
+			memcpy((void*)&pairs[pos],(const void*)&pairs[next],sizeof(Pair));
+			hashes[pos]=hashes[next];
+			hashes[next]=EMPTY_HASH;
+			pos=next;
+			next=(next+1)&(capacity-1);
+		}
+
+		return true;
+	}
+
+	inline const TData& operator[](const TKey& p_key) const { //constref
+
+		return get(p_key);
+	}
+
+	inline TData& operator[](const TKey& p_key ) { //assignment
+
+		uint32_t hash=_hash(p_key);
+		uint32_t pos;
+		if (_lookup_pos(p_key,hash,pos))
+			return pairs[pos].data;
+
+		/* if we made it up to here, the pair doesn't exist, create */
+		return _create(p_key,hash,TData())->data;
+	}
+
+	/**
+	 * Get the next key to p_key, and the first key if p_key is null.
+	 * Returns a pointer to the next key if found, NULL otherwise.
+	 * Adding/Removing elements while iterating will, of course, have unexpected results, don't do it.
+	 */
+
+	const TKey* next(const TKey* p_key) const {
+
+		if (!elements)
+			return NULL;
+
+		uint32_t from=0;
+		if (p_key) {
+			/* keys live inside the pair array, so the slot comes from the address */
+			from = ((const uint8_t*)p_key - (const uint8_t*)pairs)/sizeof(Pair);
+			ERR_FAIL_COND_V( from>=capacity || hashes[from]==EMPTY_HASH, NULL ); /* invalid key supplied */
+			from++;
+		}
+
+		for(uint32_t i=from;i<capacity;i++) {
+
+			if (hashes[i]!=EMPTY_HASH)
+				return &pairs[i].key;
+		}
+
+		return NULL; /* nothing found, was at end */
+	}
+
+	inline unsigned int size() const {
+
+		return elements;
+	}
+
+	inline bool empty() const {
+
+		return elements==0;
+	}
+
+	void clear() {
+
+		if (pairs) {
+
+			for(uint32_t i=0;i<capacity;i++) {
+
+				if (hashes[i]!=EMPTY_HASH)
+					pairs[i].~Pair();
+			}
+			memfree(pairs);
+			memfree(hashes);
+		}
+
+		pairs=NULL;
+		hashes=NULL;
+		capacity=0;
+		elements=0;
+	}
+
+	void get_key_list(List<TKey> *p_keys) const {
+
+		for(uint32_t i=0;i<capacity;i++) {
+
+			if (hashes[i]!=EMPTY_HASH)
+				p_keys->push_back(pairs[i].key);
+		}
+	}
+
+	void operator=(const OAHashMap& p_table) {
+
+		copy_from(p_table);
+	}
+
+	OAHashMap() {
+
+		pairs=NULL;
+		hashes=NULL;
+		capacity=0;
+		elements=0;
+	}
+
+	OAHashMap(const OAHashMap& p_table) {
+
+		pairs=NULL;
+		hashes=NULL;
+		capacity=0;
+		elements=0;
+
+		copy_from(p_table);
+	}
+
+	~OAHashMap() {
+
+		clear();
+	}
+
+};
+
+#endif
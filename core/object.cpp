@@ -990,14 +990,6 @@ void Object::add_user_signal(const MethodInfo& p_signal) {
 	signal_map[p_signal.name]=s;
 }
 
-struct _ObjectSignalDisconnectData {
-
-	StringName signal;
-	Object *target;
-	StringName method;
-
-};
-
 #if 0
 void Object::_emit_signal(const StringName& p_name,const Array& p_pargs){
 
@@ -1055,110 +1047,99 @@ void Object::emit_signal(const StringName& p_name,VARIANT_ARG_DECLARE) {
 		return;
 	}
 
+	//slots are not copied, instead the signal is locked while emitting: disconnections are deferred
+	//until it unlocks and connections made meanwhile are skipped, so indices stay valid.
+	//signal entries are never moved by the hash map, so the pointer survives new connections.
+	EmitGuard guard;
+	guard.alive=true;
+	guard.prev=_emit_guard;
+	_emit_guard=&guard;
+	s->lock++;
 
-	List<_ObjectSignalDisconnectData> disconnect_data;
-
-
-	//copy on write will ensure that disconnecting the signal or even deleting the object will not affect the signal calling.
-	//this happens automatically and will not change the performance of calling.
-	//awesome, isn't it?
-	VMap<Signal::Target,Signal::Slot> slot_map = s->slot_map;
-
+	const VMap<Signal::Target,Signal::Slot> &slot_map = s->slot_map;
 	int ssize = slot_map.size();
 
 	for(int i=0;i<ssize;i++) {
 
-		const Connection &c = slot_map.getv(i).conn;
-		VARIANT_ARGPTRS
+		const Signal::Slot &slot = slot_map.getv(i);
+		if (slot.removed || slot.pending)
+			continue;
+
+		const Connection &c = slot.conn;
+		ObjectID target_id = slot_map.getk(i)._id;
 
 		Object *target;
 #ifdef DEBUG_ENABLED
-		target = ObjectDB::get_instance(slot_map.getk(i)._id);
+		target = ObjectDB::get_instance(target_id);
 		ERR_CONTINUE(!target);
 #else
 		target=c.target;
 #endif
 
+		//the callback may add slots and reallocate the map, keep what is used past it
+		StringName method=c.method;
+		Vector<Variant> binds=c.binds;
+		uint32_t flags=c.flags;
 
-		int bind_count=c.binds.size();
+		VARIANT_ARGPTRS
+
+		int bind_count=binds.size();
 		int bind=0;
 
 		for(int i=0;bind < bind_count && i<VARIANT_ARG_MAX;i++) {
 
 			if (argptr[i]->get_type()==Variant::NIL) {
-				argptr[i]=&c.binds[bind];
+				argptr[i]=&binds[bind];
 				bind++;
 			}
 		}
 
-		if (c.flags&CONNECT_DEFERRED) {
-			MessageQueue::get_singleton()->push_call(target->get_instance_ID(),c.method,VARIANT_ARGPTRS_PASS);
+		if (flags&CONNECT_DEFERRED) {
+			MessageQueue::get_singleton()->push_call(target_id,method,VARIANT_ARGPTRS_PASS);
 		} else {
-			target->call( c.method, VARIANT_ARGPTRS_PASS );
+			target->call( method, VARIANT_ARGPTRS_PASS );
 		}
 
-		if (c.flags&CONNECT_ONESHOT) {
-			_ObjectSignalDisconnectData dd;
-			dd.signal=p_name;
-			dd.target=target;
-			dd.method=c.method;
-			disconnect_data.push_back(dd);
+		if (!guard.alive)
+			return; //this object was freed from the callback
+
+		if (slot_map.size()!=ssize) {
+			//slots were connected from the callback, find where this one moved
+			i=slot_map.find(Signal::Target(target_id,method));
+			ssize=slot_map.size();
 		}
 
+		if ((flags&CONNECT_ONESHOT) && !slot_map.getv(i).removed) {
+			target = ObjectDB::get_instance(target_id);
+			if (target)
+				disconnect(p_name,target,method);
+		}
 	}
 
-#if 0
-
-	//old (deprecated and dangerous code)
-	s->lock++;
-	for( Map<Signal::Target,Signal::Slot>::Element *E = s->slot_map.front();E;E=E->next() ) {
-
-		const Signal::Target& t = E->key();
-		const Signal::Slot& s = E->get();
-		const Connection &c = s.cE->get();
-
-		VARIANT_ARGPTRS
-
-		int bind_count=c.binds.size();
-		int bind=0;
-
-		for(int i=0;bind < bind_count && i<VARIANT_ARG_MAX;i++) {
+	_emit_guard=guard.prev;
+	s->lock--;
+	if (s->lock==0 && s->dirty)
+		_unlock_signal(p_name,s);
 
-			if (argptr[i]->get_type()==Variant::NIL) {
-				argptr[i]=&c.binds[bind];
-				bind++;
-			}
-		}
+}
 
-		if (c.flags&CONNECT_DEFERRED) {
-			MessageQueue::get_singleton()->push_call(t._id,t.method,VARIANT_ARGPTRS_PASS);
-		} else {
-			Object *obj = ObjectDB::get_instance(t._id);
-			ERR_CONTINUE(!obj); //yeah this should always be here
-			obj->call( t.method, VARIANT_ARGPTRS_PASS );
-		}
+void Object::_unlock_signal(const StringName& p_name,Signal *p_signal) {
 
-		if (c.flags&CONNECT_ONESHOT) {
-			_ObjectSignalDisconnectData dd;
-			dd.signal=p_name;
-			dd.target=ObjectDB::get_instance(t._id);
-			dd.method=t.method;
-			disconnect_data.push_back(dd);
-		}
+	for(int i=p_signal->slot_map.size()-1;i>=0;i--) {
 
+		Signal::Slot &slot = p_signal->slot_map.getv(i);
+		if (slot.removed)
+			p_signal->slot_map.erase(p_signal->slot_map.getk(i));
+		else
+			slot.pending=false;
 	}
 
+	p_signal->dirty=false;
 
-
-	s->lock--;
-#endif
-	while (!disconnect_data.empty()) {
-
-		const _ObjectSignalDisconnectData &dd = disconnect_data.front()->get();
-		disconnect(dd.signal,dd.target,dd.method);
-		disconnect_data.pop_front();
+	if (p_signal->slot_map.empty() && ObjectTypeDB::has_signal(get_type_name(),p_name )) {
+		//not user signal, delete
+		signal_map.erase(p_name);
 	}
-
 }
 
 
@@ -1235,8 +1216,12 @@ void Object::get_signal_connection_list(const StringName& p_signal,List<Connecti
 	if (!s)
 		return; //nothing
 
-	for(int i=0;i<s->slot_map.size();i++)
-		p_connections->push_back(s->slot_map.getv(i).conn);
+	for(int i=0;i<s->slot_map.size();i++) {
+
+		const Signal::Slot &slot = s->slot_map.getv(i);
+		if (!slot.removed)
+			p_connections->push_back(slot.conn);
+	}
 
 }
 
@@ -1257,12 +1242,17 @@ void Object::connect(const StringName& p_signal, Object *p_to_object, const Stri
 	}
 
 	Signal::Target target(p_to_object->get_instance_ID(),p_to_method);
-	if (s->slot_map.has(target)) {
+	int idx = s->slot_map.find(target);
+	if (idx!=-1 && !s->slot_map.getv(idx).removed) {
 		ERR_EXPLAIN("Signal '"+p_signal+"'' already connected to given method '"+p_to_method+"' in that object.");
 		ERR_FAIL_COND(s->slot_map.has(target));
 	}
 
 	Signal::Slot slot;
+	if (s->lock>0) {
+		slot.pending=true;
+		s->dirty=true;
+	}
 
 	Connection conn;
 	conn.source=this;
@@ -1290,7 +1280,8 @@ bool Object::is_connected(const StringName& p_signal, Object *p_to_object, const
 
 	Signal::Target target(p_to_object->get_instance_ID(),p_to_method);
 
-	return s->slot_map.has(target);
+	int idx = s->slot_map.find(target);
+	return idx!=-1 && !s->slot_map.getv(idx).removed;
 	//const Map<Signal::Target,Signal::Slot>::Element *E = s->slot_map.find(target);
 	//return (E!=NULL);
 
@@ -1304,19 +1295,26 @@ void Object::disconnect(const StringName& p_signal, Object *p_to_object, const S
 		ERR_EXPLAIN("Unexisting signal: "+p_signal);
 		ERR_FAIL_COND(!s);
 	}
-	if (s->lock>0) {
-		ERR_EXPLAIN("Attempt to disconnect signal '"+p_signal+"' while emitting (locks: "+itos(s->lock)+")");
-		ERR_FAIL_COND(s->lock>0);
-	}
 
 	Signal::Target target(p_to_object->get_instance_ID(),p_to_method);
 
-	if (!s->slot_map.has(target)) {
+	int idx = s->slot_map.find(target);
+	if (idx==-1 || s->slot_map.getv(idx).removed) {
 		ERR_EXPLAIN("Disconnecting unexisting signal '"+p_signal+"', slot: "+itos(target._id)+":"+target.method);
 		ERR_FAIL();
 	}
-	int prev = p_to_object->connections.size();
-	p_to_object->connections.erase(s->slot_map[target].cE);
+
+	Signal::Slot &slot = s->slot_map.getv(idx);
+	p_to_object->connections.erase(slot.cE);
+
+	if (s->lock>0) {
+		//emitting, erase when it unlocks
+		slot.removed=true;
+		slot.cE=NULL;
+		s->dirty=true;
+		return;
+	}
+
 	s->slot_map.erase(target);
 
 	if (s->slot_map.empty() && ObjectTypeDB::has_signal(get_type_name(),p_signal )) {
@@ -1526,6 +1524,7 @@ Object::Object() {
 	
 
 	_block_signals=false;
+	_emit_guard=NULL;
 	_predelete_ok=0;
 	_instance_ID=0;
 	_instance_ID = ObjectDB::add_instance(this);
@@ -1556,15 +1555,21 @@ Object::~Object() {
 
 		Signal *s=&signal_map[*S];
 
-		ERR_EXPLAIN("Attempt to delete an object in the middle of a signal emission from it");
-		ERR_CONTINUE(s->lock>0);
+		//freed from a callback, emissions in progress bail out when it returns
+		s->lock=0;
 
 		for(int i=0;i<s->slot_map.size();i++) {
 
-			sconnections.push_back(s->slot_map.getv(i).conn);
+			const Signal::Slot &slot = static_cast<const VMap<Signal::Target,Signal::Slot>&>(s->slot_map).getv(i);
+			if (!slot.removed)
+				sconnections.push_back(slot.conn);
 		}
 	}
 
+	for(EmitGuard *g=_emit_guard;g;g=g->prev)
+		g->alive=false;
+	_emit_guard=NULL;
+
 	for(List<Connection>::Element *E=sconnections.front();E;E=E->next()) {
 
 		Connection &c = E->get();
@@ -1597,9 +1602,9 @@ void postinitialize_handler(Object *p_object) {
 	p_object->_postinitialize();
 }
 
-HashMap<uint32_t,Object*> ObjectDB::instances;
+OAHashMap<uint32_t,Object*> ObjectDB::instances;
 uint32_t ObjectDB::instance_counter=1;
-HashMap<Object*,ObjectID,ObjectDB::ObjectPtrHash> ObjectDB::instance_checks;
+OAHashMap<Object*,ObjectID,ObjectDB::ObjectPtrHash> ObjectDB::instance_checks;
 uint32_t ObjectDB::add_instance(Object *p_object) {
 
 	GLOBAL_LOCK_FUNCTION;
@@ -34,6 +34,7 @@
 #include "set.h"
 #include "map.h"
 #include "vmap.h"
+#include "oa_hash_map.h"
 
 #define VARIANT_ARG_LIST const Variant& p_arg1=Variant(),const Variant& p_arg2=Variant(),const Variant& p_arg3=Variant(),const Variant& p_arg4=Variant(),const Variant& p_arg5=Variant()
 #define VARIANT_ARG_PASS p_arg1,p_arg2,p_arg3,p_arg4,p_arg5
@@ -353,18 +354,32 @@ friend void postinitialize_handler(Object*);
 
 			Connection conn;
 			List<Connection>::Element *cE;
+			bool removed; //disconnected while emitting, erased once the signal is unlocked
+			bool pending; //connected while emitting, not called until the signal is unlocked
+			Slot() { cE=NULL; removed=false; pending=false; }
 		};
 
 		MethodInfo user;
 		VMap<Target,Slot> slot_map;
 		int lock;
-		Signal() { lock=0; }
+		bool dirty; //has removed or pending slots
+		Signal() { lock=0; dirty=false; }
 
 	};
 
+	//one per emission in progress, so an object freed from a callback can stop its emissions
+	struct EmitGuard {
+
+		bool alive;
+		EmitGuard *prev;
+	};
+
 
 	HashMap< StringName, Signal, StringNameHasher> signal_map;
 	List<Connection> connections;
+	EmitGuard *_emit_guard;
+
+	void _unlock_signal(const StringName& p_name,Signal *p_signal);
 
 	bool _block_signals;
 	int _predelete_ok;
@@ -608,8 +623,8 @@ class ObjectDB {
 		}
 	};
 
-	static HashMap<uint32_t,Object*> instances;
-	static HashMap<Object*,ObjectID,ObjectPtrHash> instance_checks;
+	static OAHashMap<uint32_t,Object*> instances;
+	static OAHashMap<Object*,ObjectID,ObjectPtrHash> instance_checks;
 
 	static uint32_t instance_counter;
 friend class Object;	
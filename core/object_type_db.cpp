@@ -620,6 +620,50 @@ bool ObjectTypeDB::get_property(Object* p_object,const StringName& p_property, V
 }
 
 
+MethodBind *ObjectTypeDB::get_property_setter(StringName p_type,const StringName& p_property) {
+
+	OBJTYPE_LOCK;
+
+	TypeInfo *check=types.getptr(p_type);
+	while(check) {
+		const PropertySetGet *psg = check->property_setget.getptr(p_property);
+		if (psg) {
+			//same resolution order as set_property()
+			if (psg->index>=0)
+				return NULL;
+			return psg->_setptr;
+		}
+
+		check=check->inherits_ptr;
+	}
+
+	return NULL;
+}
+
+MethodBind *ObjectTypeDB::get_property_getter(StringName p_type,const StringName& p_property) {
+
+	OBJTYPE_LOCK;
+
+	TypeInfo *check=types.getptr(p_type);
+	while(check) {
+		const PropertySetGet *psg = check->property_setget.getptr(p_property);
+		if (psg) {
+			//same resolution order as get_property()
+			if (psg->index>=0)
+				return NULL;
+			return psg->_getptr;
+		}
+
+		if (check->constant_map.getptr(p_property))
+			return NULL; //resolves to a constant
+
+		check=check->inherits_ptr;
+	}
+
+	return NULL;
+}
+
+
 void ObjectTypeDB::set_method_flags(StringName p_type,StringName p_method,int p_flags) {
 
 	TypeInfo *type=types.getptr(p_type);
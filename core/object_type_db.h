@@ -425,6 +425,8 @@ public:
 	static void get_property_list(StringName p_type,List<PropertyInfo> *p_list,bool p_no_inheritance=false);
 	static bool set_property(Object* p_object,const StringName& p_property, const Variant& p_value);
 	static bool get_property(Object* p_object,const StringName& p_property, Variant& r_value);
+	static MethodBind *get_property_setter(StringName p_type,const StringName& p_property); //direct setter bind, only if it can be called without index
+	static MethodBind *get_property_getter(StringName p_type,const StringName& p_property); //direct getter bind, only if it can be called without index
 
 
 
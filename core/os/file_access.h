@@ -100,6 +100,8 @@ public:
 	virtual real_t get_real() const;
 
 	virtual int get_buffer(uint8_t *p_dst,int p_length) const; ///< get an array of bytes
+	virtual const uint8_t *get_buffer_ptr(int p_length) const { return NULL; } ///< read p_length bytes in place (valid while the file is open), NULL if unsupported or not enough data
+	virtual const uint8_t *map_read_only() { return NULL; } ///< map the whole file read only (valid until close), NULL if unsupported
 	virtual String get_line() const;
 	virtual Vector<String> get_csv_line() const;
 	
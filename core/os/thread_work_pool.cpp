@@ -0,0 +1,152 @@
+/*************************************************************************/
+/*  thread_work_pool.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "thread_work_pool.h"
+#include "os/os.h"
+#include "os/memory.h"
+#include "safe_refcount.h"
+#include "error_macros.h"
+
+void ThreadWorkPool::_process() {
+
+	while(true) {
+
+		uint32_t i = atomic_add(&index,1)-1;
+		if (i>=max_elements)
+			break;
+		work_func(work_userdata,i);
+	}
+}
+
+void ThreadWorkPool::_thread_func(void *p_userdata) {
+
+	ThreadData *td=(ThreadData*)p_userdata;
+	ThreadWorkPool *pool=td->pool;
+
+	while(true) {
+
+		td->start->wait();
+		if (pool->exit)
+			break;
+		pool->_process();
+		pool->done->post();
+	}
+}
+
+void ThreadWorkPool::init(int p_threads) {
+
+	ERR_FAIL_COND(threads!=NULL);
+
+	if (p_threads<0)
+		p_threads=OS::get_singleton()->get_processor_count()-1;
+	if (p_threads<=0)
+		return;
+
+	done = Semaphore::create();
+	if (!done)
+		return; //no thread support, work runs on the caller
+
+	exit=false;
+	threads = memnew_arr(ThreadData,p_threads);
+
+	for(int i=0;i<p_threads;i++) {
+
+		threads[i].pool=this;
+		threads[i].start=Semaphore::create();
+		threads[i].thread=Thread::create(_thread_func,&threads[i]);
+	}
+
+	thread_count=p_threads;
+}
+
+void ThreadWorkPool::do_work(int p_elements,WorkFunc p_func,void *p_userdata) {
+
+	if (thread_count==0 || p_elements<2) {
+
+		for(int i=0;i<p_elements;i++)
+			p_func(p_userdata,i);
+		return;
+	}
+
+	work_func=p_func;
+	work_userdata=p_userdata;
+	max_elements=p_elements;
+	index=0;
+	atomic_full_barrier();
+
+	int wake = MIN(thread_count,p_elements-1);
+	for(int i=0;i<wake;i++)
+		threads[i].start->post();
+
+	_process();
+
+	for(int i=0;i<wake;i++)
+		done->wait();
+}
+
+void ThreadWorkPool::finish() {
+
+	if (!threads)
+		return;
+
+	exit=true;
+	atomic_full_barrier();
+
+	for(int i=0;i<thread_count;i++)
+		threads[i].start->post();
+
+	for(int i=0;i<thread_count;i++) {
+
+		Thread::wait_to_finish(threads[i].thread);
+		memdelete(threads[i].thread);
+		memdelete(threads[i].start);
+	}
+
+	memdelete_arr(threads);
+	memdelete(done);
+	threads=NULL;
+	done=NULL;
+	thread_count=0;
+}
+
+ThreadWorkPool::ThreadWorkPool() {
+
+	threads=NULL;
+	thread_count=0;
+	done=NULL;
+	index=0;
+	max_elements=0;
+	work_func=NULL;
+	work_userdata=NULL;
+	exit=false;
+}
+
+ThreadWorkPool::~ThreadWorkPool() {
+
+	finish();
+}
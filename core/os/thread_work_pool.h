@@ -1,5 +1,5 @@
 /*************************************************************************/
-/*  dvector.cpp                                                          */
+/*  thread_work_pool.h                                                   */
 /*************************************************************************/
 /*                       This file is part of:                           */
 /*                           GODOT ENGINE                                */
@@ -26,7 +26,55 @@
 /* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
 /* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
 /*************************************************************************/
-#include "dvector.h"
+#ifndef THREAD_WORK_POOL_H
+#define THREAD_WORK_POOL_H
 
-Mutex* dvector_lock=NULL;
+#include "os/thread.h"
+#include "os/semaphore.h"
 
+/**
+ * A fixed set of worker threads that process an array of independent work
+ * items. The calling thread takes part in the work and do_work() returns
+ * once all items have been processed.
+ */
+
+class ThreadWorkPool {
+public:
+
+	typedef void (*WorkFunc)(void *p_userdata,int p_index);
+
+private:
+
+	struct ThreadData {
+
+		ThreadWorkPool *pool;
+		Thread *thread;
+		Semaphore *start;
+	};
+
+	ThreadData *threads;
+	int thread_count;
+	Semaphore *done;
+
+	volatile uint32_t index;
+	uint32_t max_elements;
+	WorkFunc work_func;
+	void *work_userdata;
+	bool exit;
+
+	void _process();
+	static void _thread_func(void *p_userdata);
+
+public:
+
+	void init(int p_threads=-1); ///< -1 uses one thread per extra processor, 0 runs everything on the caller
+	void do_work(int p_elements,WorkFunc p_func,void *p_userdata);
+	void finish();
+
+	_FORCE_INLINE_ int get_thread_count() const { return thread_count; }
+
+	ThreadWorkPool();
+	~ThreadWorkPool();
+};
+
+#endif // THREAD_WORK_POOL_H
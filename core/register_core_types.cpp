@@ -49,6 +49,7 @@
 #include "core/io/xml_parser.h"
 #include "io/http_client.h"
 #include "packed_data_container.h"
+#include "frame_arena.h"
 
 #ifdef XML_ENABLED
 static ResourceFormatSaverXML *resource_saver_xml=NULL;
@@ -238,6 +239,7 @@ void unregister_core_types() {
 	ResourceCache::clear();
 	ObjectDB::cleanup();
 	StringName::cleanup();
+	FrameArena::finish();
 
 	if (_global_mutex) {
 		memdelete(_global_mutex);
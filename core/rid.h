@@ -47,6 +47,7 @@ typedef uint32_t ID;
 class RID {	
 friend class RID_OwnerBase;	
 	ID _id;
+	uint32_t _slot; //index in the owner's slot array, only used by RID_SlotOwner
 	RID_OwnerBase *owner;
 public:
 
@@ -79,6 +80,7 @@ public:
 
 	_FORCE_INLINE_ RID() {
 		_id = 0;
+		_slot = 0;
 		owner=0;
 	}
 };
@@ -88,6 +90,8 @@ class RID_OwnerBase {
 protected:
 friend class RID;
 	void set_id(RID& p_rid, ID p_id) const { p_rid._id=p_id; }
+	void set_slot(RID& p_rid, uint32_t p_slot) const { p_rid._slot=p_slot; }
+	_FORCE_INLINE_ uint32_t get_slot(const RID& p_rid) const { return p_rid._slot; }
 	void set_ownage(RID& p_rid) const { p_rid.owner=const_cast<RID_OwnerBase*>(this); }
 	ID new_ID();
 public:
@@ -213,4 +217,211 @@ public:
 };
 
 
+/* Same interface as RID_Owner, but the RID carries the index of its slot
+   in a dense array, so get() is an array access plus an ID compare instead
+   of a hash lookup. IDs are never reused, so they act as the generation of
+   the slot: a freed (stale) RID no longer matches. Slots live in chunks that
+   are never moved, so the thread safe version only locks to create and free. */
+
+template<class T,bool thread_safe=false>
+class RID_SlotOwner : public RID_OwnerBase {
+
+	enum {
+		CHUNK_BITS=10,
+		CHUNK_SIZE=1<<CHUNK_BITS,
+		CHUNK_MASK=CHUNK_SIZE-1,
+		MAX_CHUNKS=1024
+	};
+
+	static const uint32_t FREE_NONE=0xFFFFFFFF; //kept out of the enum, it would make all of it unsigned
+
+	struct Slot {
+
+		volatile uint32_t id; //0 if free
+		T *data;
+		uint32_t next_free;
+	};
+
+	Slot **chunks;
+	volatile uint32_t slot_count;
+	uint32_t free_head;
+	Mutex *mutex;
+
+	_FORCE_INLINE_ Slot &_slot(uint32_t p_slot) const { return chunks[p_slot>>CHUNK_BITS][p_slot&CHUNK_MASK]; }
+
+	_FORCE_INLINE_ Slot *_find(const RID& p_rid) const {
+
+		uint32_t idx = get_slot(p_rid);
+		ID id = p_rid.get_id();
+		if (id==0 || idx>=(thread_safe ? atomic_load_acquire(const_cast<volatile uint32_t*>(&slot_count)) : slot_count))
+			return NULL;
+		Slot &s=_slot(idx);
+		if ((thread_safe ? atomic_load_acquire(&s.id) : s.id)!=id)
+			return NULL;
+		return &s;
+	}
+
+public:
+
+	RID make_rid(T * p_data) {
+
+		if (thread_safe) {
+			mutex->lock();
+		}
+
+		uint32_t idx;
+		if (free_head!=FREE_NONE) {
+
+			idx=free_head;
+			free_head=_slot(idx).next_free;
+		} else {
+
+			idx=slot_count;
+			if (idx>=MAX_CHUNKS*CHUNK_SIZE) {
+				if (thread_safe) {
+					mutex->unlock();
+				}
+				ERR_EXPLAIN("Too many RIDs in RID_SlotOwner");
+				ERR_FAIL_V(RID());
+			}
+
+			if ((idx&CHUNK_MASK)==0) {
+
+				Slot *chunk = memnew_arr(Slot,CHUNK_SIZE);
+				for(int i=0;i<CHUNK_SIZE;i++) {
+					chunk[i].id=0;
+					chunk[i].data=NULL;
+					chunk[i].next_free=FREE_NONE;
+				}
+				chunks[idx>>CHUNK_BITS]=chunk;
+			}
+
+			if (thread_safe)
+				atomic_store_release(&slot_count,idx+1);
+			else
+				slot_count=idx+1;
+		}
+
+		ID id = new_ID();
+		Slot &s=_slot(idx);
+		s.data=p_data;
+		s.next_free=FREE_NONE;
+		if (thread_safe)
+			atomic_store_release(&s.id,id); //data must be visible before the id matches
+		else
+			s.id=id;
+
+		if (thread_safe) {
+			mutex->unlock();
+		}
+
+		RID rid;
+		set_id(rid,id);
+		set_slot(rid,idx);
+		set_ownage(rid);
+		return rid;
+	}
+
+	_FORCE_INLINE_ T * get(const RID& p_rid) {
+
+		Slot *s=_find(p_rid);
+		ERR_FAIL_COND_V(!s,NULL);
+
+		T *data=s->data;
+
+		if (thread_safe) {
+			//freed (and maybe reused) while reading, ids are never repeated so this is enough
+			atomic_full_barrier();
+			ERR_FAIL_COND_V(s->id!=p_rid.get_id(),NULL);
+		}
+
+		return data;
+	}
+
+	virtual bool owns(const RID& p_rid) const {
+
+		return _find(p_rid)!=NULL;
+	}
+
+	virtual void free(RID p_rid) {
+
+		if (thread_safe) {
+			mutex->lock();
+		}
+
+		Slot *s=_find(p_rid);
+		if (!s) {
+			if (thread_safe) {
+				mutex->unlock();
+			}
+			ERR_FAIL_COND(!s);
+		}
+
+		if (thread_safe)
+			atomic_store_release(&s->id,0);
+		else
+			s->id=0;
+		s->data=NULL;
+		s->next_free=free_head;
+		free_head=get_slot(p_rid);
+
+		if (thread_safe) {
+			mutex->unlock();
+		}
+	}
+
+	virtual void get_owned_list(List<RID> *p_owned) const {
+
+		if (thread_safe) {
+			mutex->lock();
+		}
+
+		for(uint32_t i=0;i<slot_count;i++) {
+
+			const Slot &s=_slot(i);
+			if (s.id==0)
+				continue;
+
+			RID rid;
+			set_id(rid,s.id);
+			set_slot(rid,i);
+			set_ownage(rid);
+			p_owned->push_back(rid);
+		}
+
+		if (thread_safe) {
+			mutex->unlock();
+		}
+	}
+
+	RID_SlotOwner() {
+
+		chunks = memnew_arr(Slot*,MAX_CHUNKS);
+		for(int i=0;i<MAX_CHUNKS;i++)
+			chunks[i]=NULL;
+		slot_count=0;
+		free_head=FREE_NONE;
+		mutex=NULL;
+
+		if (thread_safe) {
+
+			mutex = Mutex::create();
+		}
+	}
+
+	~RID_SlotOwner() {
+
+		for(int i=0;i<MAX_CHUNKS;i++) {
+			if (chunks[i])
+				memdelete_arr(chunks[i]);
+		}
+		memdelete_arr(chunks);
+
+		if (thread_safe) {
+
+			memdelete(mutex);
+		}
+	}
+};
+
 #endif
@@ -52,4 +52,42 @@ long atomic_decrement( register long * pw ) {
 	return InterlockedDecrement( pw );
 }
 
+void atomic_full_barrier() {
+
+	MemoryBarrier();
+}
+
+uint32_t atomic_load_acquire( volatile uint32_t *pw ) {
+
+	uint32_t v=*pw;
+	MemoryBarrier();
+	return v;
+}
+
+void atomic_store_release( volatile uint32_t *pw, uint32_t p_value ) {
+
+	MemoryBarrier();
+	*pw=p_value;
+}
+
+uint32_t atomic_exchange( volatile uint32_t *pw, uint32_t p_value ) {
+
+	return InterlockedExchange( (volatile LONG*)pw, p_value );
+}
+
+uint32_t atomic_compare_exchange( volatile uint32_t *pw, uint32_t p_expected, uint32_t p_value ) {
+
+	return InterlockedCompareExchange( (volatile LONG*)pw, p_value, p_expected );
+}
+
+uint32_t atomic_add( volatile uint32_t *pw, uint32_t p_value ) {
+
+	return InterlockedExchangeAdd( (volatile LONG*)pw, p_value )+p_value;
+}
+
+uint32_t atomic_sub( volatile uint32_t *pw, uint32_t p_value ) {
+
+	return InterlockedExchangeAdd( (volatile LONG*)pw, -(LONG)p_value )-p_value;
+}
+
 #endif
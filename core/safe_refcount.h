@@ -30,6 +30,7 @@
 #define SAFE_REFCOUNT_H
 
 #include "os/mutex.h"
+#include "typedefs.h"
 /* x86/x86_64 GCC */
 
 #include "platform_config.h"
@@ -376,4 +377,38 @@ public:
 
 #endif // no thread safe
 
-#endif 
+/* Plain 32 bits atomics, for lock-free structures (ring buffers, counters) */
+
+#if defined( NO_THREADS )
+
+static _FORCE_INLINE_ void atomic_full_barrier() {}
+static _FORCE_INLINE_ uint32_t atomic_load_acquire( volatile uint32_t *pw ) { return *pw; }
+static _FORCE_INLINE_ void atomic_store_release( volatile uint32_t *pw, uint32_t p_value ) { *pw=p_value; }
+static _FORCE_INLINE_ uint32_t atomic_exchange( volatile uint32_t *pw, uint32_t p_value ) { uint32_t old=*pw; *pw=p_value; return old; }
+static _FORCE_INLINE_ uint32_t atomic_compare_exchange( volatile uint32_t *pw, uint32_t p_expected, uint32_t p_value ) { uint32_t old=*pw; if (old==p_expected) *pw=p_value; return old; }
+static _FORCE_INLINE_ uint32_t atomic_add( volatile uint32_t *pw, uint32_t p_value ) { return (*pw)+=p_value; }
+static _FORCE_INLINE_ uint32_t atomic_sub( volatile uint32_t *pw, uint32_t p_value ) { return (*pw)-=p_value; }
+
+#elif defined( __GNUC__ )
+
+static _FORCE_INLINE_ void atomic_full_barrier() { __sync_synchronize(); }
+static _FORCE_INLINE_ uint32_t atomic_load_acquire( volatile uint32_t *pw ) { uint32_t v=*pw; __sync_synchronize(); return v; }
+static _FORCE_INLINE_ void atomic_store_release( volatile uint32_t *pw, uint32_t p_value ) { __sync_synchronize(); *pw=p_value; }
+static _FORCE_INLINE_ uint32_t atomic_exchange( volatile uint32_t *pw, uint32_t p_value ) { __sync_synchronize(); return __sync_lock_test_and_set(pw,p_value); } //test_and_set alone is only an acquire barrier
+static _FORCE_INLINE_ uint32_t atomic_compare_exchange( volatile uint32_t *pw, uint32_t p_expected, uint32_t p_value ) { return __sync_val_compare_and_swap(pw,p_expected,p_value); }
+static _FORCE_INLINE_ uint32_t atomic_add( volatile uint32_t *pw, uint32_t p_value ) { return __sync_add_and_fetch(pw,p_value); }
+static _FORCE_INLINE_ uint32_t atomic_sub( volatile uint32_t *pw, uint32_t p_value ) { return __sync_sub_and_fetch(pw,p_value); }
+
+#elif defined( _MSC_VER )
+
+void atomic_full_barrier();
+uint32_t atomic_load_acquire( volatile uint32_t *pw );
+void atomic_store_release( volatile uint32_t *pw, uint32_t p_value );
+uint32_t atomic_exchange( volatile uint32_t *pw, uint32_t p_value );
+uint32_t atomic_compare_exchange( volatile uint32_t *pw, uint32_t p_expected, uint32_t p_value );
+uint32_t atomic_add( volatile uint32_t *pw, uint32_t p_value );
+uint32_t atomic_sub( volatile uint32_t *pw, uint32_t p_value );
+
+#endif
+
+#endif
@@ -243,6 +243,12 @@ void ScriptDebuggerRemote::debug(ScriptLanguage *p_script,bool p_can_continue) {
 
 				if (request_scene_tree)
 					request_scene_tree(request_scene_tree_ud);
+			} else if (command=="start_profiling") {
+
+				_profiling_start();
+			} else if (command=="stop_profiling") {
+
+				_profiling_stop();
 			}
 
 
@@ -331,12 +337,78 @@ void ScriptDebuggerRemote::_poll_events() {
 
 			if (request_scene_tree)
 				request_scene_tree(request_scene_tree_ud);
+		} else if (command=="start_profiling") {
+
+			_profiling_start();
+		} else if (command=="stop_profiling") {
+
+			_profiling_stop();
 		}
 
 	}
 
 }
 
+void ScriptDebuggerRemote::_profiling_start() {
+
+	if (profiling)
+		return;
+
+	int max_functions = GLOBAL_DEF("debug/profiler_max_functions",4096);
+	if (max_functions<128)
+		max_functions=128;
+	profile_info.resize(max_functions);
+
+	for(int i=0;i<ScriptServer::get_language_count();i++) {
+		ScriptServer::get_language(i)->profiling_start();
+	}
+	profiling=true;
+}
+
+void ScriptDebuggerRemote::_profiling_stop() {
+
+	if (!profiling)
+		return;
+
+	//send the totals before the languages drop them
+	_send_profiling_data(false);
+
+	for(int i=0;i<ScriptServer::get_language_count();i++) {
+		ScriptServer::get_language(i)->profiling_stop();
+	}
+	profiling=false;
+}
+
+void ScriptDebuggerRemote::_send_profiling_data(bool p_for_frame) {
+
+	/* Sent as a flat array with 4 entries per function:
+	   signature, call count, self time and total time (usec) */
+
+	Array data;
+
+	for(int i=0;i<ScriptServer::get_language_count();i++) {
+
+		ScriptLanguage *lang = ScriptServer::get_language(i);
+		int count;
+		if (p_for_frame)
+			count=lang->profiling_get_frame_data(&profile_info[0],profile_info.size());
+		else
+			count=lang->profiling_get_accumulated_data(&profile_info[0],profile_info.size());
+
+		for(int j=0;j<count;j++) {
+
+			data.push_back(profile_info[j].signature);
+			data.push_back(profile_info[j].call_count);
+			data.push_back(profile_info[j].self_time);
+			data.push_back(profile_info[j].total_time);
+		}
+	}
+
+	packet_peer_stream->put_var(p_for_frame ? "profile_frame" : "profile_total");
+	packet_peer_stream->put_var(1);
+	packet_peer_stream->put_var(data);
+}
+
 
 void ScriptDebuggerRemote::idle_poll() {
 
@@ -352,6 +424,11 @@ void ScriptDebuggerRemote::idle_poll() {
 	    }
 
 
+	    if (profiling) {
+
+		_send_profiling_data(true);
+	    }
+
 	    if (performance) {
 
 		uint64_t pt = OS::get_singleton()->get_ticks_msec();
@@ -429,6 +506,7 @@ ScriptDebuggerRemote::ScriptDebuggerRemote() {
 	last_perf_time=0;
 	poll_every=0;
 	request_scene_tree=NULL;
+	profiling=false;
 
 }
 
@@ -65,6 +65,13 @@ class ScriptDebuggerRemote : public ScriptDebugger {
 	RequestSceneTreeMessageFunc request_scene_tree;
 	void *request_scene_tree_ud;
 
+	bool profiling;
+	Vector<ScriptLanguage::ProfilingInfo> profile_info;
+
+	void _profiling_start();
+	void _profiling_stop();
+	void _send_profiling_data(bool p_for_frame);
+
 
 public:
 
@@ -80,6 +87,8 @@ public:
 
 	virtual void set_request_scene_tree_message_func(RequestSceneTreeMessageFunc p_func, void *p_udata);
 
+	virtual bool is_profiling() const { return profiling; }
+
 	ScriptDebuggerRemote();
 	~ScriptDebuggerRemote();
 };
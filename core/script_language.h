@@ -158,6 +158,22 @@ public:
 	virtual void get_recognized_extensions(List<String> *p_extensions) const=0;
 	virtual void get_public_functions(List<MethodInfo> *p_functions) const=0;
 
+	/* PROFILING FUNCTIONS */
+
+	struct ProfilingInfo {
+
+		StringName signature;
+		uint64_t call_count;
+		uint64_t total_time; //usec, including called script functions
+		uint64_t self_time; //usec
+	};
+
+	virtual void profiling_start() {}
+	virtual void profiling_stop() {}
+	virtual bool is_profiling() const { return false; }
+	virtual int profiling_get_accumulated_data(ProfilingInfo *p_info_arr,int p_info_max) { return 0; }
+	virtual int profiling_get_frame_data(ProfilingInfo *p_info_arr,int p_info_max) { return 0; } //only valid until frame() is called
+
 	virtual void frame();
 
 	virtual ~ScriptLanguage() {};	
@@ -241,6 +257,8 @@ public:
 
 	virtual void set_request_scene_tree_message_func(RequestSceneTreeMessageFunc p_func, void *p_udata) {}
 
+	virtual bool is_profiling() const { return false; }
+
 	ScriptDebugger();
 	virtual ~ScriptDebugger() {}
 
@@ -28,12 +28,13 @@
 /*************************************************************************/
 #include "string_db.h"
 #include "print_string.h"
+#include <string.h>
 
 StaticCString StaticCString::create(const char *p_ptr) {
 	StaticCString scs; scs.ptr=p_ptr; return scs;
 }
 
-StringName::_Data *StringName::_table[STRING_TABLE_LEN];
+StringName::_Shard StringName::_shards[SHARD_COUNT];
 
 StringName _scs_create(const char *p_chr) {
 
@@ -42,54 +43,288 @@ StringName _scs_create(const char *p_chr) {
 
 bool StringName::configured=false;
 
+bool StringName::_Data::matches(const char *p_name) const {
+
+	if (cname)
+		return strcmp(cname,p_name)==0;
+	return name==p_name;
+}
+
+bool StringName::_Data::matches(const CharType *p_name) const {
+
+	if (!cname)
+		return name==p_name;
+
+	const char *c=cname;
+	while(*c && *c==*p_name) {
+		c++;
+		p_name++;
+	}
+	return *c==*p_name;
+}
+
+bool StringName::_Data::matches(const String& p_name) const {
+
+	if (cname)
+		return p_name==cname;
+	return name==p_name;
+}
+
+StringName::_Buckets *StringName::_alloc_buckets(uint32_t p_bits) {
+
+	uint32_t len=1<<p_bits;
+	_Buckets *b = (_Buckets*)memalloc(sizeof(_Buckets)+sizeof(_Data*)*(len-1));
+	b->mask=len-1;
+	b->retired_next=NULL;
+	for(uint32_t i=0;i<len;i++) {
+
+		b->list[i]=NULL;
+	}
+	return b;
+}
+
+void StringName::_grow(_Shard &p_shard) {
+
+	_Buckets *old = p_shard.buckets;
+	uint32_t bits=0;
+	while((1U<<bits)<=old->mask)
+		bits++;
+	_Buckets *b = _alloc_buckets(bits+1);
+
+	// entries are relinked in place; a lookup walking the old array may stray into
+	// another chain and miss, which is fine since misses are retried under the lock.
+	for(uint32_t i=0;i<=old->mask;i++) {
+
+		_Data *d=old->list[i];
+		while(d) {
+
+			_Data *next=d->next;
+			uint32_t idx=d->hash&b->mask;
+			d->next=b->list[idx];
+			b->list[idx]=d;
+			d=next;
+		}
+	}
+
+	atomic_full_barrier();
+	p_shard.buckets=b;
+	old->retired_next=p_shard.retired_buckets;
+	p_shard.retired_buckets=old;
+}
+
+void StringName::_collect(_Shard &p_shard) {
+
+	if (!p_shard.retired && !p_shard.retired_buckets)
+		return;
+
+	atomic_full_barrier();
+	if (atomic_load_acquire(&p_shard.readers)!=0)
+		return; //try again on the next change
+
+	while(p_shard.retired) {
+
+		_Data *d=p_shard.retired;
+		p_shard.retired=d->retired_next;
+		memdelete(d);
+	}
+
+	while(p_shard.retired_buckets) {
+
+		_Buckets *b=p_shard.retired_buckets;
+		p_shard.retired_buckets=b->retired_next;
+		memfree(b);
+	}
+}
+
+template<class C>
+StringName::_Data *StringName::_lookup(const C& p_name,uint32_t p_hash,bool p_create,const char *p_cname) {
+
+	_Shard &shard=_get_shard(p_hash);
+
+	// lock free path, enough for names that already exist
+	atomic_add(&shard.readers,1);
+
+	_Buckets *b=shard.buckets;
+	_Data *d=b->list[p_hash&b->mask];
+
+	while(d) {
+
+		// compare hash first
+		if (d->hash==p_hash && d->matches(p_name))
+			break;
+		d=d->next;
+	}
+
+	if (d && !d->refcount.ref())
+		d=NULL; //being freed
+
+	atomic_sub(&shard.readers,1);
+
+	if (d)
+		return d;
+
+	if (shard.lock)
+		shard.lock->lock();
+
+	b=shard.buckets;
+	uint32_t idx=p_hash&b->mask;
+	d=b->list[idx];
+
+	while(d) {
+
+		if (d->hash==p_hash && d->matches(p_name) && d->refcount.ref())
+			break;
+		d=d->next;
+	}
+
+	if (!d && p_create) {
+
+		d = memnew( _Data );
+		if (p_cname)
+			d->cname=p_cname;
+		else
+			d->name=p_name;
+		d->refcount.init();
+		d->hash=p_hash;
+		d->next=b->list[idx];
+
+		atomic_full_barrier(); //publish fully built
+		b->list[idx]=d;
+
+		shard.count++;
+		if (shard.count>int(b->mask+1))
+			_grow(shard);
+	}
+
+	_collect(shard);
+
+	if (shard.lock)
+		shard.lock->unlock();
+
+	return d;
+}
+
 void StringName::setup() {
 	
 	ERR_FAIL_COND(configured);
-	for(int i=0;i<STRING_TABLE_LEN;i++) {
+	for(int i=0;i<SHARD_COUNT;i++) {
 		
-		_table[i]=NULL;
+		_Shard &shard=_shards[i];
+		shard.lock=Mutex::create();
+		shard.buckets=_alloc_buckets(MIN_BUCKET_BITS);
+		shard.count=0;
+		shard.readers=0;
+		shard.retired=NULL;
+		shard.retired_buckets=NULL;
 	}
 	configured=true;
 }
 
 void StringName::cleanup() {
 	
-	_global_lock();	
-	for(int i=0;i<STRING_TABLE_LEN;i++) {
+	for(int i=0;i<SHARD_COUNT;i++) {
 		
-		while(_table[i]) {
-			
-			_Data*d=_table[i];
-			_table[i]=_table[i]->next;
-			memdelete(d);
+		_Shard &shard=_shards[i];
+		if (shard.lock)
+			shard.lock->lock();
+
+		_Buckets *b=shard.buckets;
+		for(uint32_t j=0;j<=b->mask;j++) {
+
+			while(b->list[j]) {
+
+				_Data*d=b->list[j];
+				b->list[j]=d->next;
+				memdelete(d);
+			}
+		}
+		shard.count=0;
+		_collect(shard);
+
+		memfree(shard.buckets);
+		shard.buckets=NULL;
+
+		if (shard.lock) {
+			shard.lock->unlock();
+			memdelete(shard.lock);
+			shard.lock=NULL;
 		}
 	}
-	_global_unlock();	
+
+	configured=false;
+}
+
+StringName::TableStats StringName::get_table_stats() {
+
+	TableStats stats;
+	stats.entries=0;
+	stats.buckets=0;
+	stats.used_buckets=0;
+	stats.longest_chain=0;
+
+	ERR_FAIL_COND_V(!configured,stats);
+
+	for(int i=0;i<SHARD_COUNT;i++) {
+
+		_Shard &shard=_shards[i];
+		if (shard.lock)
+			shard.lock->lock();
+
+		const _Buckets *b=shard.buckets;
+		stats.entries+=shard.count;
+		stats.buckets+=b->mask+1;
+
+		for(uint32_t j=0;j<=b->mask;j++) {
+
+			int chain=0;
+			for(const _Data *d=b->list[j];d;d=d->next)
+				chain++;
+			if (chain)
+				stats.used_buckets++;
+			stats.longest_chain=MAX(stats.longest_chain,chain);
+		}
+
+		if (shard.lock)
+			shard.lock->unlock();
+	}
+
+	return stats;
 }
 
 void StringName::unref() {
-	
-	ERR_FAIL_COND(!configured);
+
+	if (!configured) {
+		//released after cleanup(), the data went away with the table
+		_data=NULL;
+		return;
+	}
 
 	if (_data && _data->refcount.unref()) {
 		
-		_global_lock();	
-
-		if (_data->prev) {
-			_data->prev->next=_data->next;
+		_Shard &shard=_get_shard(_data->hash);
+		if (shard.lock)
+			shard.lock->lock();
+
+		_Buckets *b=shard.buckets;
+		_Data **prev=&b->list[_data->hash&b->mask];
+
+		while(*prev && *prev!=_data)
+			prev=&(*prev)->next;
+
+		if (*prev) {
+			//unlink but keep next, a lookup may be standing on it
+			*prev=_data->next;
+			_data->retired_next=shard.retired;
+			shard.retired=_data;
+			shard.count--;
 		} else {
-			if (_table[_data->idx]!=_data) {
-				ERR_PRINT("BUG!");
-			}
-			_table[_data->idx]=_data->next;
+			ERR_PRINT("BUG!");
 		}
-		
-		if (_data->next) {
-			_data->next->prev=_data->prev;
 
-		}
-		memdelete(_data);
-		_global_unlock();		
+		_collect(shard);
+
+		if (shard.lock)
+			shard.lock->unlock();
 	}
 	
 	_data=NULL;
@@ -170,49 +405,8 @@ StringName::StringName(const char *p_name) {
 	ERR_FAIL_COND(!configured);
 
 	ERR_FAIL_COND( !p_name || !p_name[0]);
-	
-	_global_lock();	
-	
-	uint32_t hash = String::hash(p_name);
-	
-	uint32_t idx=hash&STRING_TABLE_MASK;
-	
-	_data=_table[idx];
-	
-	while(_data) {
-		
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
-
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			_global_unlock();
-			return;
-		} else {
-
-		}
-	}
-
-	_data = memnew( _Data );
-	_data->name=p_name;
-	_data->refcount.init();
-	_data->hash=hash;
-	_data->idx=idx;
-	_data->cname=NULL;
-	_data->next=_table[idx];
-	_data->prev=NULL;
-	if (_table[idx])
-		_table[idx]->prev=_data;
-	_table[idx]=_data;
 
-
-	_global_unlock();
-	
+	_data=_lookup(p_name,String::hash(p_name),true,NULL);
 }
 
 StringName::StringName(const StaticCString& p_static_string) {
@@ -223,48 +417,7 @@ StringName::StringName(const StaticCString& p_static_string) {
 
 	ERR_FAIL_COND( !p_static_string.ptr || !p_static_string.ptr[0]);
 
-	_global_lock();
-
-	uint32_t hash = String::hash(p_static_string.ptr);
-
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_data=_table[idx];
-
-	while(_data) {
-
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_static_string.ptr)
-			break;
-		_data=_data->next;
-	}
-
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			_global_unlock();
-			return;
-		} else {
-
-		}
-	}
-
-	_data = memnew( _Data );
-
-	_data->refcount.init();
-	_data->hash=hash;
-	_data->idx=idx;	
-	_data->cname=p_static_string.ptr;
-	_data->next=_table[idx];
-	_data->prev=NULL;
-	if (_table[idx])
-		_table[idx]->prev=_data;
-	_table[idx]=_data;
-
-
-	_global_unlock();
-
+	_data=_lookup(p_static_string.ptr,String::hash(p_static_string.ptr),true,p_static_string.ptr);
 }
 
 
@@ -274,48 +427,7 @@ StringName::StringName(const String& p_name) {
 
 	ERR_FAIL_COND(!configured);
 
-	_global_lock();	
-	
-	uint32_t hash = p_name.hash();
-	
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_data=_table[idx];
-	
-	while(_data) {
-		
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
-		
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			_global_unlock();
-			return;
-		} else {
-
-
-		}
-	}
-
-
-	_data = memnew( _Data );
-	_data->name=p_name;
-	_data->refcount.init();
-	_data->hash=hash;
-	_data->idx=idx;
-	_data->cname=NULL;
-	_data->next=_table[idx];
-	_data->prev=NULL;
-	if (_table[idx])
-		_table[idx]->prev=_data;
-	_table[idx]=_data;
-
-	_global_unlock();
-	
+	_data=_lookup(p_name,p_name.hash(),true,NULL);
 }
 
 StringName StringName::search(const char *p_name) {
@@ -326,32 +438,7 @@ StringName StringName::search(const char *p_name) {
 	if (!p_name[0])
 		return StringName();
 
-	_global_lock();
-
-	uint32_t hash = String::hash(p_name);
-
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_Data *_data=_table[idx];
-
-	while(_data) {
-
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		_global_unlock();
-		return StringName(_data);
-
-	}
-
-	_global_unlock();
-	return StringName(); //does not exist
-
-
+	return StringName(_lookup(p_name,String::hash(p_name),false,NULL));
 }
 
 StringName StringName::search(const CharType *p_name) {
@@ -362,61 +449,14 @@ StringName StringName::search(const CharType *p_name) {
 	if (!p_name[0])
 		return StringName();
 
-	_global_lock();
-
-	uint32_t hash = String::hash(p_name);
-
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_Data *_data=_table[idx];
-
-	while(_data) {
-
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		_global_unlock();
-		return StringName(_data);
-
-	}
-
-	_global_unlock();
-	return StringName(); //does not exist
-
+	return StringName(_lookup(p_name,String::hash(p_name),false,NULL));
 }
+
 StringName StringName::search(const String &p_name) {
 
 	ERR_FAIL_COND_V( p_name=="", StringName() );
 
-	_global_lock();
-
-	uint32_t hash = p_name.hash();
-
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_Data *_data=_table[idx];
-
-	while(_data) {
-
-		// compare hash first
-		if (_data->hash==hash && p_name==_data->get_name())
-			break;
-		_data=_data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		_global_unlock();
-		return StringName(_data);
-
-	}
-
-	_global_unlock();
-	return StringName(); //does not exist
-
+	return StringName(_lookup(p_name,p_name.hash(),false,NULL));
 }
 
 
@@ -50,9 +50,9 @@ class StringName {
 
 	enum {
 		
-		STRING_TABLE_BITS=12,
-		STRING_TABLE_LEN=1<<STRING_TABLE_BITS,
-		STRING_TABLE_MASK=STRING_TABLE_LEN-1
+		SHARD_BITS=6,
+		SHARD_COUNT=1<<SHARD_BITS,
+		MIN_BUCKET_BITS=6 //per shard, doubled whenever the entries outnumber the buckets
 	};
 	
 	struct _Data {		
@@ -61,15 +61,44 @@ class StringName {
 		String name;
 
 		String get_name() const {  return cname?String(cname):name; }
-		int idx;
 		uint32_t hash;
-		_Data *prev;
 		_Data *next;
-		_Data() { cname=NULL; next=prev=NULL; hash=0; }
+		_Data *retired_next;
+		_Data() { cname=NULL; next=NULL; retired_next=NULL; hash=0; }
+
+		bool matches(const char *p_name) const;
+		bool matches(const CharType *p_name) const;
+		bool matches(const String& p_name) const;
 	};
-	
-	
-	static _Data *_table[STRING_TABLE_LEN];
+
+	struct _Buckets {
+
+		uint32_t mask;
+		_Buckets *retired_next;
+		_Data *list[1]; //mask+1 entries
+	};
+
+	// the table is sharded by the top hash bits, each shard has its own lock and grows on its own.
+	// existing names are looked up without locking; readers are counted per shard, so unlinked
+	// entries and replaced bucket arrays are only freed once no lookup is walking the shard.
+	struct _Shard {
+
+		Mutex *lock;
+		_Buckets * volatile buckets;
+		int count;
+		volatile uint32_t readers;
+		_Data *retired;
+		_Buckets *retired_buckets;
+	};
+
+	static _Shard _shards[SHARD_COUNT];
+
+	_FORCE_INLINE_ static _Shard &_get_shard(uint32_t p_hash) { return _shards[p_hash>>(32-SHARD_BITS)]; }
+	static _Buckets *_alloc_buckets(uint32_t p_bits);
+	static void _grow(_Shard &p_shard);
+	static void _collect(_Shard &p_shard);
+	template<class C>
+	static _Data *_lookup(const C& p_name,uint32_t p_hash,bool p_create,const char *p_cname);
 	
 	_Data *_data;
 	
@@ -128,6 +157,16 @@ public:
 		}
 	};
 
+	struct TableStats {
+
+		int entries;
+		int buckets;
+		int used_buckets;
+		int longest_chain;
+	};
+
+	static TableStats get_table_stats();
+
 	void operator=(const StringName& p_name);
 	StringName(const char *p_name);
 	StringName(const StringName& p_name);
@@ -123,6 +123,7 @@ private:
 
 
 	friend class _VariantCall;
+	friend class GDFunction; //typed operator fast paths read _data directly
 	// Variant takes 20 bytes when real_t is float, and 36 if double
 	// it only allocates extra memory for aabb/matrix.
 	
@@ -384,6 +385,12 @@ public:
 
 	Variant call(const StringName& p_method,const Variant** p_args,int p_argcount,CallError &r_error);
 	Variant call(const StringName& p_method,const Variant& p_arg1=Variant(),const Variant& p_arg2=Variant(),const Variant& p_arg3=Variant(),const Variant& p_arg4=Variant(),const Variant& p_arg5=Variant());
+
+	// pre-resolved method of a built-in (non object) type, so call sites can skip the name lookup.
+	// handles stay valid until the variant methods are unregistered.
+	struct BuiltinMethod;
+	static const BuiltinMethod* get_builtin_method(Variant::Type p_type,const StringName& p_method);
+	void call_builtin(const BuiltinMethod* p_method,Variant& r_ret,const Variant** p_args,int p_argcount,CallError &r_error);
 	static Variant construct(const Variant::Type,const Variant** p_args,int p_argcount,CallError &r_error);
 
 	void get_method_list(List<MethodInfo> *p_list) const;
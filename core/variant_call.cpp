@@ -38,98 +38,158 @@ typedef void (*VariantConstructFunc)(Variant& r_ret,const Variant** p_args);
 VARIANT_ENUM_CAST(Image::CompressMode);
 //VARIANT_ENUM_CAST(Image::Format);
 
+// the data of a built-in type method, also handed out as a pre-resolved handle
+struct Variant::BuiltinMethod {
 
-struct _VariantCall {
-
-
-
-
-	static void Vector3_dot(Variant& r_ret,Variant& p_self,const Variant** p_args) {
-
-		r_ret=reinterpret_cast<Vector3*>(p_self._data._mem)->dot(*reinterpret_cast<const Vector3*>(p_args[0]->_data._mem));
-	}
-
-	struct FuncData {
-
-		int arg_count;
-		Vector<Variant> default_args;
-		Vector<Variant::Type> arg_types;
+	Variant::Type type;
+	int arg_count;
+	Vector<Variant> default_args;
+	Vector<Variant::Type> arg_types;
 
 #ifdef DEBUG_ENABLED
-		Vector<StringName> arg_names;
-		Variant::Type return_type;
-		bool returns;
+	Vector<StringName> arg_names;
+	Variant::Type return_type;
+	bool returns;
 #endif
-		VariantFunc func;
+	VariantFunc func;
 
-		_FORCE_INLINE_ bool verify_arguments(const Variant **p_args,Variant::CallError &r_error) {
+	_FORCE_INLINE_ bool verify_arguments(const Variant **p_args,Variant::CallError &r_error) {
 
-			if (arg_count==0)
-				return true;
+		if (arg_count==0)
+			return true;
 
-			Variant::Type *tptr = &arg_types[0];
+		Variant::Type *tptr = &arg_types[0];
 
-			for(int i=0;i<arg_count;i++) {
+		for(int i=0;i<arg_count;i++) {
 
-				if (!tptr[i] || tptr[i]==p_args[i]->type)
-					continue; // all good
-				if (!Variant::can_convert(p_args[i]->type,tptr[i])) {
-					r_error.error=Variant::CallError::CALL_ERROR_INVALID_ARGUMENT;
-					r_error.argument=i;
-					r_error.expected=tptr[i];
-					return false;
+			if (!tptr[i] || tptr[i]==p_args[i]->type)
+				continue; // all good
+			if (!Variant::can_convert(p_args[i]->type,tptr[i])) {
+				r_error.error=Variant::CallError::CALL_ERROR_INVALID_ARGUMENT;
+				r_error.argument=i;
+				r_error.expected=tptr[i];
+				return false;
 
-				}
 			}
-			return true;
 		}
+		return true;
+	}
 
-		_FORCE_INLINE_ void call(Variant& r_ret,Variant& p_self,const Variant** p_args,int p_argcount,Variant::CallError &r_error) {
+	_FORCE_INLINE_ void call(Variant& r_ret,Variant& p_self,const Variant** p_args,int p_argcount,Variant::CallError &r_error) {
 #ifdef DEBUG_ENABLED
-			if(p_argcount>arg_count) {
-				r_error.error=Variant::CallError::CALL_ERROR_TOO_MANY_ARGUMENTS;
-				r_error.argument=arg_count;
-				return;
-			} else
+		if(p_argcount>arg_count) {
+			r_error.error=Variant::CallError::CALL_ERROR_TOO_MANY_ARGUMENTS;
+			r_error.argument=arg_count;
+			return;
+		} else
 #endif
-			if (p_argcount<arg_count) {
-				int def_argcount = default_args.size();
+		if (p_argcount<arg_count) {
+			int def_argcount = default_args.size();
 #ifdef DEBUG_ENABLED
-				if (p_argcount<(arg_count-def_argcount)) {
-					r_error.error=Variant::CallError::CALL_ERROR_TOO_FEW_ARGUMENTS;
-					r_error.argument=arg_count-def_argcount;
-					return;
-				}
+			if (p_argcount<(arg_count-def_argcount)) {
+				r_error.error=Variant::CallError::CALL_ERROR_TOO_FEW_ARGUMENTS;
+				r_error.argument=arg_count-def_argcount;
+				return;
+			}
 
 #endif
-				ERR_FAIL_COND(p_argcount>VARIANT_ARG_MAX);
-				const Variant *newargs[VARIANT_ARG_MAX];
-				for(int i=0;i<p_argcount;i++)
-					newargs[i]=p_args[i];
-				int defargcount=def_argcount;
-				for(int i=p_argcount;i<arg_count;i++)
-					newargs[i]=&default_args[defargcount-(i-p_argcount)-1]; //default arguments
+			ERR_FAIL_COND(p_argcount>VARIANT_ARG_MAX);
+			const Variant *newargs[VARIANT_ARG_MAX];
+			for(int i=0;i<p_argcount;i++)
+				newargs[i]=p_args[i];
+			int defargcount=def_argcount;
+			for(int i=p_argcount;i<arg_count;i++)
+				newargs[i]=&default_args[defargcount-(i-p_argcount)-1]; //default arguments
 #ifdef DEBUG_ENABLED
-				if (!verify_arguments(newargs,r_error))
-					return;
+			if (!verify_arguments(newargs,r_error))
+				return;
 #endif
-				func(r_ret,p_self,newargs);
-			} else {
+			func(r_ret,p_self,newargs);
+		} else {
 #ifdef DEBUG_ENABLED
-				if (!verify_arguments(p_args,r_error))
-					return;
+			if (!verify_arguments(p_args,r_error))
+				return;
 #endif
-				func(r_ret,p_self,p_args);
+			func(r_ret,p_self,p_args);
+		}
+
+	}
+
+};
+
+
+struct _VariantCall {
+
+
+
+
+	static void Vector3_dot(Variant& r_ret,Variant& p_self,const Variant** p_args) {
+
+		r_ret=reinterpret_cast<Vector3*>(p_self._data._mem)->dot(*reinterpret_cast<const Vector3*>(p_args[0]->_data._mem));
+	}
+
+	typedef Variant::BuiltinMethod FuncData;
+
+
+	// open addressed index from StringName to entries of a Map, probed with the
+	// precomputed name hash and compared by StringName pointer. Built once after
+	// registration, the Map keeps ownership and the listing order.
+	template<class T>
+	struct NameIndex {
+
+		struct Slot {
+			StringName name;
+			T *value;
+			Slot() { value=NULL; }
+		};
+
+		Slot *slots;
+		uint32_t mask;
+
+		void build(Map<StringName,T>& p_map) {
+
+			if (slots)
+				memdelete_arr(slots);
+			slots=NULL;
+			mask=0;
+			if (p_map.empty())
+				return;
+
+			uint32_t size = nearest_power_of_2(p_map.size()*2); //keep load under one half
+			slots = memnew_arr(Slot,size);
+			mask=size-1;
+
+			for(typename Map<StringName,T>::Element *E=p_map.front();E;E=E->next()) {
+
+				uint32_t idx=E->key().hash()&mask;
+				while(slots[idx].value)
+					idx=(idx+1)&mask;
+				slots[idx].name=E->key();
+				slots[idx].value=&E->get();
 			}
+		}
 
+		_FORCE_INLINE_ T* find(const StringName& p_name) const {
+
+			if (!slots)
+				return NULL;
+			uint32_t idx=p_name.hash()&mask;
+			while(slots[idx].value) {
+				if (slots[idx].name==p_name)
+					return slots[idx].value;
+				idx=(idx+1)&mask;
+			}
+			return NULL;
 		}
 
+		NameIndex() { slots=NULL; mask=0; }
+		~NameIndex() { if (slots) memdelete_arr(slots); }
 	};
 
-
 	struct TypeFunc {
 
 		Map<StringName,FuncData> functions;
+		NameIndex<FuncData> index;
 	};
 
 	static TypeFunc* type_funcs;
@@ -149,6 +209,7 @@ struct _VariantCall {
 	static void addfunc(Variant::Type p_type, Variant::Type p_return,const StringName& p_name,VariantFunc p_func, const Vector<Variant>& p_defaultarg,const Arg& p_argtype1=Arg(),const Arg& p_argtype2=Arg(),const Arg& p_argtype3=Arg(),const Arg& p_argtype4=Arg(),const Arg& p_argtype5=Arg()) {
 
 		FuncData funcdata;
+		funcdata.type=p_type;
 		funcdata.func=p_func;
 		funcdata.default_args=p_defaultarg;
 #ifdef DEBUG_ENABLED
@@ -818,6 +879,7 @@ static void _call_##m_type##_##m_method(Variant& r_ret,Variant& p_self,const Var
 	struct ConstantData {
 
 		Map<StringName,int> value;
+		NameIndex<int> index;
 	};
 
 	static ConstantData* constant_data;
@@ -859,20 +921,40 @@ Variant Variant::call(const StringName& p_method,const Variant** p_args,int p_ar
 
 		r_error.error=Variant::CallError::CALL_OK;
 
-		Map<StringName,_VariantCall::FuncData>::Element *E=_VariantCall::type_funcs[type].functions.find(p_method);
+		_VariantCall::FuncData *funcdata=_VariantCall::type_funcs[type].index.find(p_method);
 #ifdef DEBUG_ENABLED
-		if (!E) {
+		if (!funcdata) {
 			r_error.error=Variant::CallError::CALL_ERROR_INVALID_METHOD;
 			return Variant();
 		}
 #endif
-		_VariantCall::FuncData& funcdata = E->get();
-		funcdata.call(ret,*this,p_args,p_argcount,r_error);
+		funcdata->call(ret,*this,p_args,p_argcount,r_error);
 	}
 
 	return ret;
 }
 
+const Variant::BuiltinMethod* Variant::get_builtin_method(Variant::Type p_type,const StringName& p_method) {
+
+	ERR_FAIL_INDEX_V(p_type,VARIANT_MAX,NULL);
+	if (p_type==OBJECT)
+		return NULL; //objects go through ObjectTypeDB::get_method()
+
+	return _VariantCall::type_funcs[p_type].index.find(p_method);
+}
+
+void Variant::call_builtin(const BuiltinMethod* p_method,Variant& r_ret,const Variant** p_args,int p_argcount,CallError &r_error) {
+
+#ifdef DEBUG_ENABLED
+	if (!p_method || p_method->type!=type) {
+		r_error.error=Variant::CallError::CALL_ERROR_INVALID_METHOD;
+		return;
+	}
+#endif
+	r_error.error=Variant::CallError::CALL_OK;
+	const_cast<BuiltinMethod*>(p_method)->call(r_ret,*this,p_args,p_argcount,r_error);
+}
+
 #define VCALL(m_type,m_method) _VariantCall::_call_##m_type##_##m_method
 
 
@@ -1088,7 +1170,7 @@ bool Variant::has_numeric_constant(Variant::Type p_type, const StringName& p_val
 
 	ERR_FAIL_INDEX_V(p_type,Variant::VARIANT_MAX,false);
 	_VariantCall::ConstantData& cd = _VariantCall::constant_data[p_type];
-	return cd.value.has(p_value);
+	return cd.index.find(p_value)!=NULL;
 }
 
 int Variant::get_numeric_constant_value(Variant::Type p_type, const StringName& p_value) {
@@ -1097,9 +1179,9 @@ int Variant::get_numeric_constant_value(Variant::Type p_type, const StringName&
 	_VariantCall::ConstantData& cd = _VariantCall::constant_data[p_type];
 
 
-	Map<StringName,int>::Element *E = cd.value.find(p_value);
-	ERR_FAIL_COND_V(!E,0);
-	return E->get();
+	int *value = cd.index.find(p_value);
+	ERR_FAIL_COND_V(!value,0);
+	return *value;
 }
 
 
@@ -1485,6 +1567,12 @@ _VariantCall::addfunc(Variant::m_vtype,Variant::m_ret,_SCS(#m_method),VCALL(m_cl
 	_VariantCall::constant_data[Variant::IMAGE].value["FORMAT_ETC"]=Image::FORMAT_ETC;
 	_VariantCall::constant_data[Variant::IMAGE].value["FORMAT_CUSTOM"]=Image::FORMAT_CUSTOM;
 
+	for(int i=0;i<Variant::VARIANT_MAX;i++) {
+
+		_VariantCall::type_funcs[i].index.build(_VariantCall::type_funcs[i].functions);
+		_VariantCall::constant_data[i].index.build(_VariantCall::constant_data[i].value);
+	}
+
 }
 
 void unregister_variant_methods() {
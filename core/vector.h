@@ -61,23 +61,40 @@ class Vector {
 		return reinterpret_cast<int*>(((uint8_t*)(_ptr))+sizeof(SafeRefCount));
  		
  	}
+	_FORCE_INLINE_ int* _get_capacity() const  {
+
+		if (!_ptr)
+			return NULL;
+		return reinterpret_cast<int*>(((uint8_t*)(_ptr))+sizeof(SafeRefCount)+sizeof(int));
+
+	}
+	_FORCE_INLINE_ static int _get_header_size() {
+
+		// refcount, size and capacity, padded so elements stay 8 bytes aligned
+		return (sizeof(SafeRefCount)+sizeof(int)*2+7)&~7;
+	}
 	_FORCE_INLINE_ T* _get_data() const {
  	
 		if (!_ptr)
  			return NULL;
-		return reinterpret_cast<T*>(((uint8_t*)(_ptr))+sizeof(SafeRefCount)+sizeof(int));
+		return reinterpret_cast<T*>(((uint8_t*)(_ptr))+_get_header_size());
  		
  	}
  	
 	_FORCE_INLINE_ int _get_alloc_size(int p_elements) const {
  	
- 		return  nearest_power_of_2(p_elements*sizeof(T)+sizeof(SafeRefCount)+sizeof(int));
+ 		return  nearest_power_of_2(p_elements*sizeof(T)+_get_header_size());
  	}
+
+	_FORCE_INLINE_ int _get_capacity_for(int p_alloc_size) const {
+
+		return (p_alloc_size-_get_header_size())/sizeof(T);
+	}
  	
 	void _unref(void *p_data);
 	
 	void _copy_from(const Vector& p_from);
-	void _copy_on_write();
+	void _copy_on_write(int p_min_capacity=0);
 public:
 
 
@@ -94,8 +111,10 @@ public:
 		else		
 			return *reinterpret_cast<int*>(((uint8_t*)(_ptr))+sizeof(SafeRefCount));
 	}
-	_FORCE_INLINE_ bool empty() const { return _ptr == 0; }
+	_FORCE_INLINE_ bool empty() const { return size() == 0; }
+	_FORCE_INLINE_ int capacity() const { return _ptr ? *_get_capacity() : 0; }
 	Error resize(int p_size);
+	Error reserve(int p_capacity); // growing up to the capacity does not touch the allocator
 	bool push_back(T p_elem);
 	
 	void remove(int p_index);
@@ -172,7 +191,7 @@ void Vector<T>::_unref(void *p_data) {
 	// clean up
 		
 	int *count = (int*)(src+1);
-	T *data = (T*)(count+1);
+	T *data = (T*)(((uint8_t*)p_data)+_get_header_size());
 	
 	for (int i=0;i<*count;i++) {
 		// call destructors	
@@ -185,19 +204,25 @@ void Vector<T>::_unref(void *p_data) {
 }
 
 template<class T>
-void Vector<T>::_copy_on_write() {
+void Vector<T>::_copy_on_write(int p_min_capacity) {
 
 	if (!_ptr)
 		return;
 	
 	if (_get_refcount()->get() > 1 ) {
 		/* in use by more than me */
-		SafeRefCount *src_new=(SafeRefCount *)memalloc(_get_alloc_size(*_get_size()));
+		int alloc_size=_get_alloc_size(MAX(*_get_size(),p_min_capacity));
+		void *mem_new=memalloc(alloc_size);
+		ERR_FAIL_COND( !mem_new );
+
+		SafeRefCount *src_new=(SafeRefCount *)mem_new;
 		src_new->init();
 		int * _size = (int*)(src_new+1);
 		*_size=*_get_size();
+		int * _capacity = _size+1;
+		*_capacity=_get_capacity_for(alloc_size);
 		
-		T*_data=(T*)(_size+1);
+		T*_data=(T*)(((uint8_t*)mem_new)+_get_header_size());
 		
 		// initialize new elements
 		for (int i=0;i<*_size;i++) {
@@ -206,7 +231,7 @@ void Vector<T>::_copy_on_write() {
 		}
 		
 		_unref(_ptr);
-		_ptr=src_new;
+		_ptr=mem_new;
 	}
 
 }
@@ -244,23 +269,27 @@ Error Vector<T>::resize(int p_size) {
 		return OK;
 	}
 	
-	// possibly changing size, copy on write
-	_copy_on_write();
+	// possibly changing size, copy on write (straight to the needed capacity)
+	_copy_on_write(p_size);
 	
 	if (p_size>size()) {
 
-		if (size()==0) {
+		if (!_ptr) {
 			// alloc from scratch
-			_ptr = (T*)memalloc(_get_alloc_size(p_size));
+			int alloc_size=_get_alloc_size(p_size);
+			_ptr = (T*)memalloc(alloc_size);
 			ERR_FAIL_COND_V( !_ptr ,ERR_OUT_OF_MEMORY);
 			_get_refcount()->init(); // init refcount
 			*_get_size()=0; // init size (currently, none)
+			*_get_capacity()=_get_capacity_for(alloc_size);
 
-		} else {
+		} else if (p_size>*_get_capacity()) {
 			
-			void *_ptrnew = (T*)memrealloc(_ptr,_get_alloc_size(p_size));
+			int alloc_size=_get_alloc_size(p_size);
+			void *_ptrnew = (T*)memrealloc(_ptr,alloc_size);
 			ERR_FAIL_COND_V( !_ptrnew ,ERR_OUT_OF_MEMORY);
 			_ptr=_ptrnew;
+			*_get_capacity()=_get_capacity_for(alloc_size);
 		}
 
 		// construct the newly created elements
@@ -282,15 +311,50 @@ Error Vector<T>::resize(int p_size) {
 			t->~T();
 		}
 
-		void *_ptrnew = (T*)memrealloc(_ptr,_get_alloc_size(p_size));
+		*_get_size()=p_size;
+
+		if (p_size < *_get_capacity()/4) {
+			// mostly unused, give memory back
+			int alloc_size=_get_alloc_size(p_size);
+			void *_ptrnew = (T*)memrealloc(_ptr,alloc_size);
+			ERR_FAIL_COND_V( !_ptrnew ,ERR_OUT_OF_MEMORY);
+			_ptr=_ptrnew;
+			*_get_capacity()=_get_capacity_for(alloc_size);
+		}
+	}
+
+	return OK;
+}
+
+template<class T>
+Error Vector<T>::reserve(int p_capacity) {
+
+	ERR_FAIL_COND_V(p_capacity<0,ERR_INVALID_PARAMETER);
+
+	if (p_capacity<=capacity() && (!_ptr || _get_refcount()->get()==1))
+		return OK;
+
+	if (_ptr && _get_refcount()->get()>1) {
+		_copy_on_write(p_capacity);
+		return OK;
+	}
+
+	int alloc_size=_get_alloc_size(p_capacity);
+
+	if (!_ptr) {
+
+		_ptr = (T*)memalloc(alloc_size);
+		ERR_FAIL_COND_V( !_ptr ,ERR_OUT_OF_MEMORY);
+		_get_refcount()->init();
+		*_get_size()=0;
+	} else {
+
+		void *_ptrnew = (T*)memrealloc(_ptr,alloc_size);
 		ERR_FAIL_COND_V( !_ptrnew ,ERR_OUT_OF_MEMORY);
-		
 		_ptr=_ptrnew;
-		
-		*_get_size()=p_size;
-				
 	}
 
+	*_get_capacity()=_get_capacity_for(alloc_size);
 	return OK;
 }
 
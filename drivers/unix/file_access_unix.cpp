@@ -39,6 +39,10 @@
 #include <sys/statvfs.h>
 #endif
 
+#ifdef UNIX_ENABLED
+#include <sys/mman.h>
+#endif
+
 #ifdef MSVC
  #define S_ISREG(m) ((m)&_S_IFREG)
 #endif
@@ -57,8 +61,19 @@ void FileAccessUnix::check_errors() const {
 
 }
 
+void FileAccessUnix::unmap() {
+
+#ifdef UNIX_ENABLED
+	if (mapping)
+		munmap(mapping,mapping_len);
+#endif
+	mapping=NULL;
+	mapping_len=0;
+}
+
 Error FileAccessUnix::_open(const String& p_path, int p_mode_flags) {
 
+	unmap();
 	if (f)
 		fclose(f);
 	f=NULL;
@@ -112,6 +127,7 @@ void FileAccessUnix::close() {
 
 	if (!f)
 		return;
+	unmap();
 	fclose(f);
 	f = NULL;
 	if (save_path!="") {
@@ -190,6 +206,31 @@ int FileAccessUnix::get_buffer(uint8_t *p_dst, int p_length) const {
 	return read;
 };
 
+const uint8_t *FileAccessUnix::map_read_only() {
+
+	ERR_FAIL_COND_V(!f,NULL);
+#ifdef UNIX_ENABLED
+	if (mapping)
+		return (const uint8_t*)mapping;
+	if (flags!=READ)
+		return NULL;
+
+	struct stat st;
+	if (fstat(fileno(f),&st)!=0 || st.st_size<=0)
+		return NULL;
+
+	void *m = mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fileno(f),0);
+	if (m==MAP_FAILED)
+		return NULL;
+
+	mapping=m;
+	mapping_len=st.st_size;
+	return (const uint8_t*)mapping;
+#else
+	return NULL;
+#endif
+}
+
 Error FileAccessUnix::get_error() const{
 
 	return last_error;
@@ -246,6 +287,8 @@ FileAccessUnix::FileAccessUnix() {
 	f=NULL;
 	flags=0;
 	last_error=OK;
+	mapping=NULL;
+	mapping_len=0;
 
 }
 FileAccessUnix::~FileAccessUnix() {
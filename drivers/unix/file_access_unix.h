@@ -45,6 +45,9 @@ class FileAccessUnix : public FileAccess {
 	void check_errors() const;
 	mutable Error last_error;
 	String save_path;
+	void *mapping;
+	size_t mapping_len;
+	void unmap();
 	
 		static FileAccess* create_libc();
 public:
@@ -62,6 +65,7 @@ public:
 
 	virtual uint8_t get_8() const; ///< get a byte 
 	virtual int get_buffer(uint8_t *p_dst, int p_length) const;
+	virtual const uint8_t *map_read_only();
 
 	virtual Error get_error() const; ///< get last error 
 
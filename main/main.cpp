@@ -77,6 +77,7 @@
 #include "version.h"
 
 #include "performance.h"
+#include "frame_arena.h"
 
 static Globals *globals=NULL;
 static InputMap *input_map=NULL;
@@ -94,6 +95,7 @@ static OS::VideoMode video_mode;
 static int video_driver_idx=-1;
 static int audio_driver_idx=-1;
 static String locale;
+static String script_profile_path;
 
 static String unescape_cmdline(const String& p_str) {
 
@@ -154,6 +156,7 @@ void Main::print_help(const char* p_binary) {
 	OS::get_singleton()->print("\t-rdebug ADDRESS : Remote debug (<ip>:<port> host address).\n");
 	OS::get_singleton()->print("\t-fdelay [msec]: Simulate high CPU load (delay each frame by [msec]).\n");
 	OS::get_singleton()->print("\t-bp : breakpoint list as source::line comma separated pairs, no spaces (%%20,%%2C,etc instead).\n");
+	OS::get_singleton()->print("\t-profile FILE : Profile script functions and save the totals to FILE on exit.\n");
 	OS::get_singleton()->print("\t-v : Verbose stdout mode\n");
 	OS::get_singleton()->print("\t-lang [locale]: Use a specific locale\n");
 	OS::get_singleton()->print("\t-rfs <host/ip>[:<port>] : Remote FileSystem.\n");
@@ -389,6 +392,16 @@ Error Main::setup(const char *execpath,int argc, char *argv[],bool p_second_phas
 			} else {
 				goto error;
 				
+			}
+		} else if (I->get()=="-profile") { // script profiler dump
+
+			if (I->next()) {
+
+				script_profile_path=I->next()->get();
+				N=I->next()->next();
+			} else {
+				goto error;
+
 			}
 		} else if (I->get()=="-bp") { // /breakpoints
 
@@ -769,6 +782,13 @@ Error Main::setup2() {
 	register_script_types();
 	register_driver_types();
 
+	if (script_profile_path!="") {
+
+		for(int i=0;i<ScriptServer::get_language_count();i++) {
+			ScriptServer::get_language(i)->profiling_start();
+		}
+	}
+
 	MAIN_PRINT("Main: Load Translations");
 
 	translation_server->setup(); //register translations, load them, etc.
@@ -1225,6 +1245,8 @@ static uint64_t idle_process_max=0;
 
 bool Main::iteration() {
 
+	performance->frame_begin();
+
 	uint64_t ticks=OS::get_singleton()->get_ticks_usec();
 	uint64_t ticks_elapsed=ticks-last_ticks;
 
@@ -1249,24 +1271,45 @@ bool Main::iteration() {
 
 		uint64_t fixed_begin = OS::get_singleton()->get_ticks_usec();
 
-		PhysicsServer::get_singleton()->sync();
-		PhysicsServer::get_singleton()->flush_queries();
+		PERF_SCOPE("fixed_process");
+
+		{
+			PERF_SCOPE("physics_3d_sync_flush");
+			PhysicsServer::get_singleton()->sync();
+			PhysicsServer::get_singleton()->flush_queries();
+		}
 
-		Physics2DServer::get_singleton()->sync();
-		Physics2DServer::get_singleton()->flush_queries();
+		{
+			PERF_SCOPE("physics_2d_sync_flush");
+			Physics2DServer::get_singleton()->sync();
+			Physics2DServer::get_singleton()->flush_queries();
+		}
 
-		if (OS::get_singleton()->get_main_loop()->iteration( frame_slice )) {
-			exit=true;
-			break;
+		{
+			PERF_SCOPE("main_loop_iteration");
+			if (OS::get_singleton()->get_main_loop()->iteration( frame_slice )) {
+				exit=true;
+				break;
+			}
 		}
 
-		message_queue->flush();
+		{
+			PERF_SCOPE("message_queue_flush");
+			message_queue->flush();
+		}
 
-		PhysicsServer::get_singleton()->step(frame_slice);
-		Physics2DServer::get_singleton()->step(frame_slice);
+		{
+			PERF_SCOPE("physics_step");
+			PhysicsServer::get_singleton()->step(frame_slice);
+			Physics2DServer::get_singleton()->step(frame_slice);
+		}
 
 		time_accum-=frame_slice;
-		message_queue->flush();
+
+		{
+			PERF_SCOPE("message_queue_flush");
+			message_queue->flush();
+		}
 		//if (AudioServer::get_singleton())
 		//	AudioServer::get_singleton()->update();
 
@@ -1276,14 +1319,25 @@ bool Main::iteration() {
 
 	uint64_t idle_begin = OS::get_singleton()->get_ticks_usec();
 
-	OS::get_singleton()->get_main_loop()->idle( step );
-	message_queue->flush();
+	{
+		PERF_SCOPE("idle");
+		OS::get_singleton()->get_main_loop()->idle( step );
+	}
+
+	{
+		PERF_SCOPE("message_queue_flush");
+		message_queue->flush();
+	}
 
-	if (SpatialSoundServer::get_singleton())
-		SpatialSoundServer::get_singleton()->update( step );
-	if (SpatialSound2DServer::get_singleton())
-		SpatialSound2DServer::get_singleton()->update( step );
+	{
+		PERF_SCOPE("spatial_sound_update");
+		if (SpatialSoundServer::get_singleton())
+			SpatialSoundServer::get_singleton()->update( step );
+		if (SpatialSound2DServer::get_singleton())
+			SpatialSound2DServer::get_singleton()->update( step );
+	}
 
+	performance->scope_begin("visual_server_draw");
 
 	if (OS::get_singleton()->can_draw()) {
 
@@ -1302,17 +1356,25 @@ bool Main::iteration() {
 
 	}
 
-	if (AudioServer::get_singleton())
-		AudioServer::get_singleton()->update();
+	performance->scope_end();
 
-	for(int i=0;i<ScriptServer::get_language_count();i++) {
-		ScriptServer::get_language(i)->frame();
+	{
+		PERF_SCOPE("audio_update");
+		if (AudioServer::get_singleton())
+			AudioServer::get_singleton()->update();
 	}
 
 	idle_process_max=MAX(OS::get_singleton()->get_ticks_usec()-idle_begin,idle_process_max);
 
 	if (script_debugger)
-		script_debugger->idle_poll();
+		script_debugger->idle_poll(); //before frame(), so the profiler can still send this frame's data
+
+	{
+		PERF_SCOPE("script_frame");
+		for(int i=0;i<ScriptServer::get_language_count();i++) {
+			ScriptServer::get_language(i)->frame();
+		}
+	}
 
 
 	//	x11_delay_usec(10000);
@@ -1339,6 +1401,10 @@ bool Main::iteration() {
 		frames=0;
 	}
 
+	FrameArena::end_frame();
+
+	performance->frame_end(); //frame delay is not part of the frame
+
 	if (OS::get_singleton()->is_in_low_processor_usage_mode() || !OS::get_singleton()->can_draw())
 		OS::get_singleton()->delay_usec(25000); //apply some delay to force idle time
 	else {
@@ -1356,10 +1422,43 @@ void Main::force_redraw() {
 };
 
 
+static void _save_script_profile(const String& p_path) {
+
+	FileAccess *f = FileAccess::open(p_path,FileAccess::WRITE);
+	if (!f) {
+		ERR_EXPLAIN("Can't save script profile to: "+p_path);
+		ERR_FAIL();
+	}
+
+	Vector<ScriptLanguage::ProfilingInfo> info;
+	info.resize(GLOBAL_DEF("debug/profiler_max_functions",4096));
+
+	f->store_line("function,calls,self_usec,total_usec");
+
+	for(int i=0;i<ScriptServer::get_language_count();i++) {
+
+		ScriptLanguage *lang = ScriptServer::get_language(i);
+		int count = lang->profiling_get_accumulated_data(&info[0],info.size());
+		for(int j=0;j<count;j++) {
+
+			f->store_line(String(info[j].signature)+","+String::num_int64(info[j].call_count)+","+String::num_int64(info[j].self_time)+","+String::num_int64(info[j].total_time));
+		}
+		lang->profiling_stop();
+	}
+
+	memdelete(f);
+}
+
 void Main::cleanup() {
 
 	ERR_FAIL_COND(!_start_success);
 
+	if (script_profile_path!="") {
+
+		_save_script_profile(script_profile_path);
+		script_profile_path=String();
+	}
+
 	if (script_debugger)
 		memdelete(script_debugger);
 
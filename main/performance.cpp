@@ -29,8 +29,11 @@
 #include "performance.h"
 #include "os/os.h"
 #include "servers/visual_server.h"
+#include "servers/audio_server.h"
 #include "message_queue.h"
 #include "scene/main/scene_main_loop.h"
+#include "os/file_access.h"
+#include "frame_arena.h"
 Performance *Performance::singleton=NULL;
 
 
@@ -39,6 +42,10 @@ Performance *Performance::singleton=NULL;
 void Performance::_bind_methods() {
 
 	ObjectTypeDB::bind_method(_MD("get_monitor","monitor"),&Performance::get_monitor);
+	ObjectTypeDB::bind_method(_MD("get_frame_history_size"),&Performance::get_frame_history_size);
+	ObjectTypeDB::bind_method(_MD("get_frame_time","frames_ago"),&Performance::_get_frame_time);
+	ObjectTypeDB::bind_method(_MD("get_frame_scopes","frames_ago"),&Performance::_get_frame_scopes);
+	ObjectTypeDB::bind_method(_MD("save_frame_trace","path"),&Performance::save_frame_trace);
 
 	BIND_CONSTANT( TIME_FPS );
 	BIND_CONSTANT( TIME_PROCESS );
@@ -61,6 +68,11 @@ void Performance::_bind_methods() {
 	BIND_CONSTANT( RENDER_VIDEO_MEM_USED );
 	BIND_CONSTANT( RENDER_TEXTURE_MEM_USED );
 	BIND_CONSTANT( RENDER_VERTEX_MEM_USED );
+	BIND_CONSTANT( OBJECT_STRING_NAME_COUNT );
+	BIND_CONSTANT( OBJECT_STRING_NAME_LONGEST_CHAIN );
+	BIND_CONSTANT( MEMORY_FRAME_ARENA );
+	BIND_CONSTANT( MEMORY_FRAME_ARENA_MAX );
+	BIND_CONSTANT( AUDIO_STREAM_UNDERRUNS );
 	BIND_CONSTANT( MONITOR_MAX );
 
 }
@@ -90,7 +102,12 @@ String Performance::get_monitor_name(Monitor p_monitor) const {
 		"video/video_mem",
 		"video/texure_mem",
 		"video/vertex_mem",
-		"render/mem_max"
+		"render/mem_max",
+		"object/string_names",
+		"object/string_name_chain_max",
+		"memory/frame_arena",
+		"memory/frame_arena_max",
+		"audio/stream_underruns"
 	};
 
 	return names[p_monitor];
@@ -133,6 +150,11 @@ float Performance::get_monitor(Monitor p_monitor) const {
 		case RENDER_TEXTURE_MEM_USED: return VS::get_singleton()->get_render_info(VS::INFO_TEXTURE_MEM_USED);
 		case RENDER_VERTEX_MEM_USED: return VS::get_singleton()->get_render_info(VS::INFO_VERTEX_MEM_USED);
 		case RENDER_USAGE_VIDEO_MEM_TOTAL: return VS::get_singleton()->get_render_info(VS::INFO_USAGE_VIDEO_MEM_TOTAL);
+		case OBJECT_STRING_NAME_COUNT: return StringName::get_table_stats().entries;
+		case OBJECT_STRING_NAME_LONGEST_CHAIN: return StringName::get_table_stats().longest_chain;
+		case MEMORY_FRAME_ARENA: return FrameArena::get_frame_peak();
+		case MEMORY_FRAME_ARENA_MAX: return FrameArena::get_peak();
+		case AUDIO_STREAM_UNDERRUNS: return AudioServer::get_singleton()->get_stream_underrun_count();
 		default: {}
 	}
 
@@ -150,9 +172,108 @@ void Performance::set_fixed_process_time(float p_pt) {
 }
 
 
+void Performance::frame_begin() {
+
+	ERR_FAIL_COND(current_frame);
+
+	current_frame=&frame_history[frame_count%FRAME_HISTORY];
+	current_frame->index=frame_count;
+	current_frame->scope_count=0;
+	current_frame->begin=OS::get_singleton()->get_ticks_usec();
+	current_frame->end=current_frame->begin;
+	scope_depth=0;
+}
+
+void Performance::frame_end() {
+
+	ERR_FAIL_COND(!current_frame);
+	ERR_FAIL_COND(scope_depth!=0);
+
+	current_frame->end=OS::get_singleton()->get_ticks_usec();
+	current_frame=NULL;
+	frame_count++;
+}
+
+int Performance::get_frame_history_size() const {
+
+	return frame_count<FRAME_HISTORY ? frame_count : FRAME_HISTORY;
+}
+
+const Performance::FrameTimes *Performance::get_frame_times(int p_frames_ago) const {
+
+	ERR_FAIL_INDEX_V(p_frames_ago,get_frame_history_size(),NULL);
+	return &frame_history[(frame_count-1-p_frames_ago)%FRAME_HISTORY];
+}
+
+float Performance::_get_frame_time(int p_frames_ago) const {
+
+	const FrameTimes *ft = get_frame_times(p_frames_ago);
+	if (!ft)
+		return 0;
+	return (ft->end-ft->begin)/1000000.0;
+}
+
+Array Performance::_get_frame_scopes(int p_frames_ago) const {
+
+	Array ret;
+	const FrameTimes *ft = get_frame_times(p_frames_ago);
+	if (!ft)
+		return ret;
+
+	for(int i=0;i<ft->scope_count;i++) {
+
+		const FrameScope &s=ft->scopes[i];
+		Dictionary d;
+		d["name"]=s.name;
+		d["depth"]=s.depth;
+		d["begin"]=(s.begin-ft->begin)/1000000.0;
+		d["time"]=(s.end-s.begin)/1000000.0;
+		ret.push_back(d);
+	}
+
+	return ret;
+}
+
+Error Performance::save_frame_trace(const String& p_path) const {
+
+	FileAccess *f = FileAccess::open(p_path,FileAccess::WRITE);
+	if (!f) {
+		ERR_EXPLAIN("Can't open file for writing: "+p_path);
+		ERR_FAIL_V(ERR_CANT_OPEN);
+	}
+
+	//oldest frame first, complete ("X") events with usec timestamps
+	f->store_string("{\"traceEvents\":[\n");
+	bool first=true;
+
+	for(int i=get_frame_history_size()-1;i>=0;i--) {
+
+		const FrameTimes *ft = get_frame_times(i);
+
+		String ev=String(first?"":",\n")+"{\"name\":\"frame "+String::num_int64(ft->index)+"\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":"+String::num_int64(ft->begin)+",\"dur\":"+String::num_int64(ft->end-ft->begin)+"}";
+		first=false;
+
+		for(int j=0;j<ft->scope_count;j++) {
+
+			const FrameScope &s=ft->scopes[j];
+			ev+=",\n{\"name\":\""+String(s.name)+"\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":"+String::num_int64(s.begin)+",\"dur\":"+String::num_int64(s.end-s.begin)+"}";
+		}
+
+		f->store_string(ev);
+	}
+
+	f->store_string("\n]}\n");
+	memdelete(f);
+
+	return OK;
+}
+
 Performance::Performance() {
 
 	_process_time=0;
 	_fixed_process_time=0;
+	frame_count=0;
+	current_frame=NULL;
+	scope_depth=0;
 	singleton=this;
 }
@@ -30,6 +30,7 @@
 #define PERFORMANCE_H
 
 #include "object.h"
+#include "os/os.h"
 
 #define PERF_WARN_OFFLINE_FUNCTION
 #define PERF_WARN_PROCESS_SYNC
@@ -44,6 +45,45 @@ class Performance : public Object {
 
 	float _process_time;
 	float _fixed_process_time;
+
+public:
+
+	/* frame phase timing, main thread only. Scope names must be static strings */
+
+	enum {
+		FRAME_HISTORY=120,
+		MAX_FRAME_SCOPES=64,
+		MAX_SCOPE_DEPTH=16
+	};
+
+	struct FrameScope {
+
+		const char *name;
+		uint64_t begin; //usec
+		uint64_t end;
+		int depth;
+	};
+
+	struct FrameTimes {
+
+		uint64_t index;
+		uint64_t begin;
+		uint64_t end;
+		int scope_count;
+		FrameScope scopes[MAX_FRAME_SCOPES];
+	};
+
+private:
+
+	FrameTimes frame_history[FRAME_HISTORY];
+	uint64_t frame_count; //frames finished
+	FrameTimes *current_frame;
+	int scope_stack[MAX_SCOPE_DEPTH];
+	int scope_depth;
+
+	Array _get_frame_scopes(int p_frames_ago) const;
+	float _get_frame_time(int p_frames_ago) const;
+
 public:
 
 	enum Monitor {
@@ -69,6 +109,11 @@ public:
 		RENDER_TEXTURE_MEM_USED,
 		RENDER_VERTEX_MEM_USED,
 		RENDER_USAGE_VIDEO_MEM_TOTAL,
+		OBJECT_STRING_NAME_COUNT,
+		OBJECT_STRING_NAME_LONGEST_CHAIN,
+		MEMORY_FRAME_ARENA,
+		MEMORY_FRAME_ARENA_MAX,
+		AUDIO_STREAM_UNDERRUNS,
 		//physics
 		MONITOR_MAX
 	};
@@ -80,6 +125,42 @@ public:
 	void set_process_time(float p_pt);
 	void set_fixed_process_time(float p_pt);
 
+	void frame_begin();
+	void frame_end();
+
+	_FORCE_INLINE_ void scope_begin(const char *p_name) {
+
+		if (scope_depth>=MAX_SCOPE_DEPTH) {
+			scope_depth++; //too deep, not recorded but keeps scope_end balanced
+			return;
+		}
+
+		int idx=-1;
+		if (current_frame && current_frame->scope_count<MAX_FRAME_SCOPES) {
+
+			idx=current_frame->scope_count++;
+			FrameScope &s=current_frame->scopes[idx];
+			s.name=p_name;
+			s.begin=OS::get_singleton()->get_ticks_usec();
+			s.end=s.begin;
+			s.depth=scope_depth;
+		}
+		scope_stack[scope_depth++]=idx;
+	}
+
+	_FORCE_INLINE_ void scope_end() {
+
+		ERR_FAIL_COND(scope_depth==0);
+		scope_depth--;
+		if (scope_depth>=MAX_SCOPE_DEPTH || scope_stack[scope_depth]<0 || !current_frame)
+			return;
+		current_frame->scopes[scope_stack[scope_depth]].end=OS::get_singleton()->get_ticks_usec();
+	}
+
+	int get_frame_history_size() const; //frames available, 0 is the last finished one
+	const FrameTimes *get_frame_times(int p_frames_ago) const;
+	Error save_frame_trace(const String& p_path) const; //chrome://tracing JSON
+
 	static Performance *get_singleton() { return singleton; }
 
 	Performance();
@@ -88,5 +169,14 @@ public:
 
 VARIANT_ENUM_CAST( Performance::Monitor );
 
+class PerformanceScope {
+public:
+
+	_FORCE_INLINE_ PerformanceScope(const char *p_name) { Performance::get_singleton()->scope_begin(p_name); }
+	_FORCE_INLINE_ ~PerformanceScope() { Performance::get_singleton()->scope_end(); }
+};
+
+#define PERF_SCOPE(m_name) PerformanceScope _perf_scope_(m_name)
+
 
 #endif // PERFORMANCE_H
@@ -170,8 +170,8 @@ void SceneMainLoop::call_group(uint32_t p_call_flags,const StringName& p_group,c
 		return;
 	}
 
-	Vector<Node*> nodes_copy = g.nodes;
-	Node **nodes = &nodes_copy[0];
+	const Vector<Node*> nodes_copy = g.nodes;
+	Node * const *nodes = &nodes_copy[0];
 	int node_count=nodes_copy.size();
 
 	call_lock++;
@@ -227,8 +227,8 @@ void SceneMainLoop::notify_group(uint32_t p_call_flags,const StringName& p_group
 
 	_update_group_order(g);
 
-	Vector<Node*> nodes_copy = g.nodes;
-	Node **nodes = &nodes_copy[0];
+	const Vector<Node*> nodes_copy = g.nodes;
+	Node * const *nodes = &nodes_copy[0];
 	int node_count=nodes_copy.size();
 
 	call_lock++;
@@ -277,8 +277,8 @@ void SceneMainLoop::set_group(uint32_t p_call_flags,const StringName& p_group,co
 
 	_update_group_order(g);
 
-	Vector<Node*> nodes_copy = g.nodes;
-	Node **nodes = &nodes_copy[0];
+	const Vector<Node*> nodes_copy = g.nodes;
+	Node * const *nodes = &nodes_copy[0];
 	int node_count=nodes_copy.size();
 
 	call_lock++;
@@ -633,10 +633,11 @@ void SceneMainLoop::_call_input_pause(const StringName& p_group,const StringName
 
 	//copy, so copy on write happens in case something is removed from process while being called
 	//performance is not lost because only if something is added/removed the vector is copied.
-	Vector<Node*> nodes_copy = g.nodes;
+	//(nodes must be accessed through the const copy, or operator[] would copy right away)
+	const Vector<Node*> nodes_copy = g.nodes;
 
 	int node_count=nodes_copy.size();
-	Node **nodes = &nodes_copy[0];
+	Node * const *nodes = &nodes_copy[0];
 
 	Variant arg=p_input;
 	const Variant *v[1]={&arg};
@@ -679,10 +680,11 @@ void SceneMainLoop::_notify_group_pause(const StringName& p_group,int p_notifica
 
 	//copy, so copy on write happens in case something is removed from process while being called
 	//performance is not lost because only if something is added/removed the vector is copied.
-	Vector<Node*> nodes_copy = g.nodes;
+	//(nodes must be accessed through the const copy, or operator[] would copy right away)
+	const Vector<Node*> nodes_copy = g.nodes;
 
 	int node_count=nodes_copy.size();
-	Node **nodes = &nodes_copy[0];
+	Node * const *nodes = &nodes_copy[0];
 
 	call_lock++;
 
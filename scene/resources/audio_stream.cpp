@@ -56,6 +56,21 @@ void AudioStream::InternalAudioStream::update() {
 	owner->update();
 }
 
+int AudioStream::InternalAudioStream::get_buffered_usec() const {
+
+	return owner->get_buffered_usec();
+}
+
+int AudioStream::InternalAudioStream::get_buffer_length_usec() const {
+
+	return owner->get_buffer_length_usec();
+}
+
+uint32_t AudioStream::InternalAudioStream::get_underrun_count() const {
+
+	return owner->get_underrun_count();
+}
+
 AudioServer::AudioStream *AudioStream::get_audio_stream() {
 
 	return internal_audio_stream;
@@ -48,6 +48,9 @@ class AudioStream : public Resource {
 		virtual bool mix(int32_t *p_buffer,int p_frames);
 		virtual bool can_update_mt() const;
 		virtual void update();
+		virtual int get_buffered_usec() const;
+		virtual int get_buffer_length_usec() const;
+		virtual uint32_t get_underrun_count() const;
 	};
 
 
@@ -58,6 +61,9 @@ protected:
 	_FORCE_INLINE_ int get_mix_rate() const { return _mix_rate; }
 	virtual int get_channel_count() const=0;
 	virtual bool mix(int32_t *p_buffer, int p_frames)=0;
+	virtual int get_buffered_usec() const { return -1; }
+	virtual int get_buffer_length_usec() const { return -1; }
+	virtual uint32_t get_underrun_count() const { return 0; }
 
 	static void _bind_methods();
 public:
@@ -169,6 +169,7 @@ bool AudioStreamResampled::mix(int32_t *p_dest, int p_frames) {
 	int rb_todo;
 
 	if (write_pos_cache==rb_read_pos) {
+		underruns++; //only the mix thread writes this
 		return false; //out of buffer
 
 	} else if (rb_read_pos<write_pos_cache) {
@@ -234,6 +235,28 @@ bool AudioStreamResampled::mix(int32_t *p_dest, int p_frames) {
 }
 
 
+int AudioStreamResampled::get_buffered_usec() const {
+
+	if (!rb || !mix_rate)
+		return -1;
+
+	int frames=(rb_write_pos-rb_read_pos)&rb_mask;
+	return int64_t(frames)*1000000/mix_rate;
+}
+
+int AudioStreamResampled::get_buffer_length_usec() const {
+
+	if (!rb || !mix_rate)
+		return -1;
+
+	return int64_t(rb_len)*1000000/mix_rate;
+}
+
+uint32_t AudioStreamResampled::get_underrun_count() const {
+
+	return underruns;
+}
+
 Error AudioStreamResampled::_setup(int p_channels,int p_mix_rate,int p_minbuff_needed) {
 
 	ERR_FAIL_COND_V(p_channels!=1 && p_channels!=2 && p_channels!=4 && p_channels!=6,ERR_INVALID_PARAMETER);
@@ -305,6 +328,7 @@ AudioStreamResampled::AudioStreamResampled() {
 	rb=NULL;
 	offset=0;
 	read_buf=NULL;
+	underruns=0;
 }
 
 AudioStreamResampled::~AudioStreamResampled() {
@@ -44,6 +44,7 @@ class AudioStreamResampled : public AudioStream {
 
 	volatile int rb_read_pos;
 	volatile int rb_write_pos;
+	volatile uint32_t underruns;
 
 	int32_t offset; //contains the fractional remainder of the resampler
 	enum {
@@ -88,6 +89,9 @@ protected:
 	//Stream virtual funcs
 	virtual int get_channel_count() const;
 	virtual bool mix(int32_t *p_dest, int p_frames);
+	virtual int get_buffered_usec() const;
+	virtual int get_buffer_length_usec() const;
+	virtual uint32_t get_underrun_count() const;
 
 	_FORCE_INLINE_ void _flush() {
 		rb_read_pos=0;
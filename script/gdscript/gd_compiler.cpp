@@ -49,6 +49,74 @@ void GDCompiler::_set_error(const String& p_error,const GDParser::Node *p_node)
 	err_column=p_node->column;
 }
 
+Variant::Type GDCompiler::_get_expression_type(CodeGen& codegen,const GDParser::Node *p_expression) {
+
+	switch(p_expression->type) {
+
+		case GDParser::Node::TYPE_CONSTANT: {
+
+			return static_cast<const GDParser::ConstantNode*>(p_expression)->value.get_type();
+		} break;
+		case GDParser::Node::TYPE_IDENTIFIER: {
+
+			//only class constants can be proven, same lookup order as _parse_expression
+			StringName identifier = static_cast<const GDParser::IdentifierNode*>(p_expression)->name;
+			if (codegen.stack_identifiers.has(identifier))
+				return Variant::NIL;
+			if ((!codegen.function_node || !codegen.function_node->_static) && codegen.script->member_indices.has(identifier))
+				return Variant::NIL;
+
+			for(GDScript *scr=codegen.script;scr;scr=scr->_base) {
+
+				const Map<StringName,Variant>::Element *E=scr->constants.find(identifier);
+				if (E)
+					return E->get().get_type();
+			}
+		} break;
+		case GDParser::Node::TYPE_OPERATOR: {
+
+			const GDParser::OperatorNode *on = static_cast<const GDParser::OperatorNode*>(p_expression);
+			Variant::Operator op=Variant::OP_MAX;
+
+			switch(on->op) {
+
+				case GDParser::OperatorNode::OP_CALL: {
+					//basic type constructors always return their type
+					if (on->arguments.size() && on->arguments[0]->type==GDParser::Node::TYPE_TYPE)
+						return Variant::Type(static_cast<const GDParser::TypeNode*>(on->arguments[0])->vtype);
+				} break;
+				case GDParser::OperatorNode::OP_NEG: {
+
+					Variant::Type t = _get_expression_type(codegen,on->arguments[0]);
+					if (t==Variant::INT || t==Variant::REAL || t==Variant::VECTOR2 || t==Variant::VECTOR3)
+						return t;
+				} break;
+				case GDParser::OperatorNode::OP_ADD: op=Variant::OP_ADD; break;
+				case GDParser::OperatorNode::OP_SUB: op=Variant::OP_SUBSTRACT; break;
+				case GDParser::OperatorNode::OP_MUL: op=Variant::OP_MULTIPLY; break;
+				case GDParser::OperatorNode::OP_DIV: op=Variant::OP_DIVIDE; break;
+				case GDParser::OperatorNode::OP_EQUAL: op=Variant::OP_EQUAL; break;
+				case GDParser::OperatorNode::OP_NOT_EQUAL: op=Variant::OP_NOT_EQUAL; break;
+				case GDParser::OperatorNode::OP_LESS: op=Variant::OP_LESS; break;
+				case GDParser::OperatorNode::OP_LESS_EQUAL: op=Variant::OP_LESS_EQUAL; break;
+				case GDParser::OperatorNode::OP_GREATER: op=Variant::OP_GREATER; break;
+				case GDParser::OperatorNode::OP_GREATER_EQUAL: op=Variant::OP_GREATER_EQUAL; break;
+				default: {}
+			}
+
+			if (op!=Variant::OP_MAX && on->arguments.size()==2) {
+
+				int typed_op = GDFunction::find_typed_operator(op,_get_expression_type(codegen,on->arguments[0]),_get_expression_type(codegen,on->arguments[1]));
+				if (typed_op>=0)
+					return GDFunction::get_typed_operator_info(typed_op).result;
+			}
+		} break;
+		default: {}
+	}
+
+	return Variant::NIL;
+}
+
 bool GDCompiler::_create_unary_operator(CodeGen& codegen,const GDParser::OperatorNode *on,Variant::Operator op, int p_stack_level) {
 
 	ERR_FAIL_COND_V(on->arguments.size()!=1,false);
@@ -79,9 +147,16 @@ bool GDCompiler::_create_binary_operator(CodeGen& codegen,const GDParser::Operat
 	if (src_address_b<0)
 		return false;
 
+	int typed_op = GDFunction::find_typed_operator(op,_get_expression_type(codegen,on->arguments[0]),_get_expression_type(codegen,on->arguments[1]));
 
-	codegen.opcodes.push_back(GDFunction::OPCODE_OPERATOR); // perform operator
-	codegen.opcodes.push_back(op); //which operator
+	if (typed_op>=0) {
+		//both operand types are known, use the specialized version (it still guards at runtime)
+		codegen.opcodes.push_back(GDFunction::OPCODE_OPERATOR_TYPED);
+		codegen.opcodes.push_back(typed_op);
+	} else {
+		codegen.opcodes.push_back(GDFunction::OPCODE_OPERATOR); // perform operator
+		codegen.opcodes.push_back(op); //which operator
+	}
 	codegen.opcodes.push_back(src_address_a); // argument 1
 	codegen.opcodes.push_back(src_address_b); // argument 2 (unary only takes one parameter)
 	return true;
@@ -490,8 +565,11 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 						codegen.opcodes.push_back(p_root?GDFunction::OPCODE_CALL:GDFunction::OPCODE_CALL_RETURN); // perform operator
 						codegen.opcodes.push_back(on->arguments.size()-2);
 						codegen.alloc_call(on->arguments.size()-2);
-						for(int i=0;i<arguments.size();i++)
+						for(int i=0;i<arguments.size();i++) {
 							codegen.opcodes.push_back(arguments[i]);
+							if (i==1)
+								codegen.opcodes.push_back(codegen.alloc_cache()); //inline cache, after method name
+						}
 					}
 				} break;
 				//indexing operator
@@ -536,6 +614,8 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 					codegen.opcodes.push_back(named?GDFunction::OPCODE_GET_NAMED:GDFunction::OPCODE_GET); // perform operator
 					codegen.opcodes.push_back(from); // argument 1
 					codegen.opcodes.push_back(index); // argument 2 (unary only takes one parameter)
+					if (named)
+						codegen.opcodes.push_back(codegen.alloc_cache()); // inline cache
 
 				} break;
 				case GDParser::OperatorNode::OP_AND: {
@@ -719,6 +799,8 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 							codegen.opcodes.push_back(named ? GDFunction::OPCODE_GET_NAMED : GDFunction::OPCODE_GET);
 							codegen.opcodes.push_back(prev_pos);
 							codegen.opcodes.push_back(key_idx);
+							if (named)
+								codegen.opcodes.push_back(codegen.alloc_cache());
 							slevel++;
 							codegen.alloc_stack(slevel);
 							int dst_pos = (GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS)|slevel;
@@ -770,6 +852,8 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 						codegen.opcodes.push_back(prev_pos);
 						codegen.opcodes.push_back(set_index);
 						codegen.opcodes.push_back(set_value);
+						if (named)
+							codegen.opcodes.push_back(codegen.alloc_cache());
 
 						for(int i=0;i<setchain.size();i+=4) {
 
@@ -778,6 +862,8 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 							codegen.opcodes.push_back(setchain[i+1]);
 							codegen.opcodes.push_back(setchain[i+2]);
 							codegen.opcodes.push_back(setchain[i+3]);
+							if (setchain[i+0]==GDFunction::OPCODE_SET_NAMED)
+								codegen.opcodes.push_back(codegen.alloc_cache());
 						}
 
 						return retval;
@@ -1097,6 +1183,277 @@ Error GDCompiler::_parse_block(CodeGen& codegen,const GDParser::BlockNode *p_blo
 }
 
 
+bool GDCompiler::_verify_address(const GDFunction *p_function,int p_address) const {
+
+	int address = p_address&GDFunction::ADDR_MASK;
+
+	switch((p_address&GDFunction::ADDR_TYPE_MASK)>>GDFunction::ADDR_BITS) {
+
+		case GDFunction::ADDR_TYPE_SELF: return address==0;
+		case GDFunction::ADDR_TYPE_MEMBER: return address<p_function->_script->member_indices.size();
+		case GDFunction::ADDR_TYPE_CLASS_CONSTANT: return address<p_function->_global_names_count;
+		case GDFunction::ADDR_TYPE_LOCAL_CONSTANT: return address<p_function->_constant_count;
+		case GDFunction::ADDR_TYPE_STACK:
+		case GDFunction::ADDR_TYPE_STACK_VARIABLE: return address<p_function->_stack_size;
+		case GDFunction::ADDR_TYPE_GLOBAL: return address<GDScriptLanguage::get_singleton()->get_global_array_size();
+		case GDFunction::ADDR_TYPE_NIL: return true;
+	}
+
+	return false;
+}
+
+Error GDCompiler::_verify_function(const GDFunction *p_function,const GDParser::Node *p_node) {
+
+	/* The VM only checks operands in debug builds, so anything the code
+	   generator emits is validated once here instead of on every execution */
+
+	const int *code = p_function->_code_ptr;
+	int code_size = p_function->_code_size;
+
+	Vector<bool> starts;
+	starts.resize(code_size);
+	for(int i=0;i<code_size;i++)
+		starts[i]=false;
+
+	Vector<int> jumps; //targets, checked once all instruction starts are known
+
+	int ip=0;
+	String error;
+
+#define VERIFY(m_cond,m_err) \
+	if (!(m_cond)) { error=m_err; break; }
+#define VERIFY_SPACE(m_space) \
+	VERIFY(ip+(m_space)<=code_size,"Truncated instruction")
+#define VERIFY_ADDR(m_ofs) \
+	VERIFY(_verify_address(p_function,code[ip+(m_ofs)]),"Invalid address "+itos(code[ip+(m_ofs)]))
+#define VERIFY_ARGC(m_argc) \
+	VERIFY((m_argc)>=0 && (m_argc)<=p_function->_call_size,"Invalid argument count")
+#define VERIFY_NAME(m_ofs) \
+	VERIFY(code[ip+(m_ofs)]>=0 && code[ip+(m_ofs)]<p_function->_global_names_count,"Invalid name index")
+#define VERIFY_CACHE(m_ofs) \
+	VERIFY(code[ip+(m_ofs)]>=0 && code[ip+(m_ofs)]<p_function->_cache_count,"Invalid inline cache index")
+
+	while(ip<code_size) {
+
+		starts[ip]=true;
+		int incr=0;
+
+		switch(code[ip]) {
+
+			case GDFunction::OPCODE_OPERATOR: {
+
+				VERIFY_SPACE(5);
+				VERIFY(code[ip+1]>=0 && code[ip+1]<Variant::OP_MAX,"Invalid operator");
+				VERIFY_ADDR(2);
+				VERIFY_ADDR(3);
+				VERIFY_ADDR(4);
+				incr=5;
+			} break;
+			case GDFunction::OPCODE_OPERATOR_TYPED: {
+
+				VERIFY_SPACE(5);
+				VERIFY(code[ip+1]>=0 && code[ip+1]<GDFunction::TYPED_MAX,"Invalid typed operator");
+				VERIFY_ADDR(2);
+				VERIFY_ADDR(3);
+				VERIFY_ADDR(4);
+				incr=5;
+			} break;
+			case GDFunction::OPCODE_EXTENDS_TEST:
+			case GDFunction::OPCODE_SET:
+			case GDFunction::OPCODE_GET: {
+
+				VERIFY_SPACE(4);
+				VERIFY_ADDR(1);
+				VERIFY_ADDR(2);
+				VERIFY_ADDR(3);
+				incr=4;
+			} break;
+			case GDFunction::OPCODE_SET_NAMED: {
+
+				VERIFY_SPACE(5);
+				VERIFY_ADDR(1);
+				VERIFY_NAME(2);
+				VERIFY_ADDR(3);
+				VERIFY_CACHE(4);
+				incr=5;
+			} break;
+			case GDFunction::OPCODE_GET_NAMED: {
+
+				VERIFY_SPACE(5);
+				VERIFY_ADDR(1);
+				VERIFY_NAME(2);
+				VERIFY_CACHE(3);
+				VERIFY_ADDR(4);
+				incr=5;
+			} break;
+			case GDFunction::OPCODE_ASSIGN: {
+
+				VERIFY_SPACE(3);
+				VERIFY_ADDR(1);
+				VERIFY_ADDR(2);
+				incr=3;
+			} break;
+			case GDFunction::OPCODE_ASSIGN_TRUE:
+			case GDFunction::OPCODE_ASSIGN_FALSE: {
+
+				VERIFY_SPACE(2);
+				VERIFY_ADDR(1);
+				incr=2;
+			} break;
+			case GDFunction::OPCODE_CONSTRUCT: {
+
+				VERIFY_SPACE(4);
+				VERIFY(code[ip+1]>=0 && code[ip+1]<Variant::VARIANT_MAX,"Invalid construct type");
+				int argc=code[ip+2];
+				VERIFY_ARGC(argc);
+				VERIFY_SPACE(4+argc);
+				bool ok=true;
+				for(int i=0;i<=argc;i++)
+					ok = ok && _verify_address(p_function,code[ip+3+i]);
+				VERIFY(ok,"Invalid argument address");
+				incr=4+argc;
+			} break;
+			case GDFunction::OPCODE_CONSTRUCT_ARRAY:
+			case GDFunction::OPCODE_CONSTRUCT_DICTIONARY: {
+
+				VERIFY_SPACE(3);
+				int argc=code[ip+1];
+				VERIFY(argc>=0,"Invalid element count");
+				int elems = code[ip]==GDFunction::OPCODE_CONSTRUCT_ARRAY ? argc : argc*2;
+				VERIFY_SPACE(3+elems);
+				bool ok=true;
+				for(int i=0;i<=elems;i++)
+					ok = ok && _verify_address(p_function,code[ip+2+i]);
+				VERIFY(ok,"Invalid element address");
+				incr=3+elems;
+			} break;
+			case GDFunction::OPCODE_CALL:
+			case GDFunction::OPCODE_CALL_RETURN: {
+
+				VERIFY_SPACE(6);
+				int argc=code[ip+1];
+				VERIFY_ARGC(argc);
+				VERIFY_ADDR(2);
+				VERIFY_NAME(3);
+				VERIFY_CACHE(4);
+				VERIFY_SPACE(6+argc);
+				bool ok=true;
+				for(int i=0;i<=argc;i++)
+					ok = ok && _verify_address(p_function,code[ip+5+i]);
+				VERIFY(ok,"Invalid argument address");
+				incr=6+argc;
+			} break;
+			case GDFunction::OPCODE_CALL_BUILT_IN: {
+
+				VERIFY_SPACE(4);
+				VERIFY(code[ip+1]>=0 && code[ip+1]<GDFunctions::FUNC_MAX,"Invalid built-in function");
+				int argc=code[ip+2];
+				VERIFY_ARGC(argc);
+				VERIFY_SPACE(4+argc);
+				bool ok=true;
+				for(int i=0;i<=argc;i++)
+					ok = ok && _verify_address(p_function,code[ip+3+i]);
+				VERIFY(ok,"Invalid argument address");
+				incr=4+argc;
+			} break;
+			case GDFunction::OPCODE_CALL_SELF_BASE: {
+
+				VERIFY_SPACE(4);
+				VERIFY_NAME(1);
+				int argc=code[ip+2];
+				VERIFY_ARGC(argc);
+				VERIFY_SPACE(4+argc);
+				bool ok=true;
+				for(int i=0;i<=argc;i++)
+					ok = ok && _verify_address(p_function,code[ip+3+i]);
+				VERIFY(ok,"Invalid argument address");
+				incr=4+argc;
+			} break;
+			case GDFunction::OPCODE_JUMP: {
+
+				VERIFY_SPACE(2);
+				jumps.push_back(code[ip+1]);
+				incr=2;
+			} break;
+			case GDFunction::OPCODE_JUMP_IF:
+			case GDFunction::OPCODE_JUMP_IF_NOT: {
+
+				VERIFY_SPACE(3);
+				VERIFY_ADDR(1);
+				jumps.push_back(code[ip+2]);
+				incr=3;
+			} break;
+			case GDFunction::OPCODE_JUMP_TO_DEF_ARGUMENT: {
+
+				for(int i=0;i<p_function->_default_arg_count;i++)
+					jumps.push_back(p_function->_default_arg_ptr[i]);
+				incr=1;
+			} break;
+			case GDFunction::OPCODE_RETURN:
+			case GDFunction::OPCODE_ASSERT: {
+
+				VERIFY_SPACE(2);
+				VERIFY_ADDR(1);
+				incr=2;
+			} break;
+			case GDFunction::OPCODE_ITERATE_BEGIN:
+			case GDFunction::OPCODE_ITERATE: {
+
+				VERIFY_SPACE(5);
+				VERIFY_ADDR(1);
+				VERIFY_ADDR(2);
+				jumps.push_back(code[ip+3]);
+				VERIFY_ADDR(4);
+				incr=5;
+			} break;
+			case GDFunction::OPCODE_LINE: {
+
+				VERIFY_SPACE(2);
+				incr=2;
+			} break;
+			case GDFunction::OPCODE_END: {
+
+				incr=1;
+			} break;
+			default: {
+
+				error="Illegal opcode "+itos(code[ip]);
+			} break;
+		}
+
+		if (error!="")
+			break;
+
+		ip+=incr;
+	}
+
+#undef VERIFY
+#undef VERIFY_SPACE
+#undef VERIFY_ADDR
+#undef VERIFY_ARGC
+#undef VERIFY_NAME
+#undef VERIFY_CACHE
+
+	if (error=="" && (code_size==0 || code[code_size-1]!=GDFunction::OPCODE_END)) {
+		error="Code does not end with OPCODE_END";
+	}
+
+	for(int i=0;error=="" && i<jumps.size();i++) {
+
+		if (jumps[i]<0 || jumps[i]>=code_size || !starts[jumps[i]]) {
+			error="Invalid jump target "+itos(jumps[i]);
+		}
+	}
+
+	if (error!="") {
+
+		_set_error("Compiler bug: "+error+" at address "+itos(ip)+" in function '"+String(p_function->name)+"'.",p_node);
+		return ERR_BUG;
+	}
+
+	return OK;
+}
+
 Error GDCompiler::_parse_function(GDScript *p_script,const GDParser::ClassNode *p_class,const GDParser::FunctionNode *p_func) {
 
 	Vector<int> bytecode;
@@ -1108,6 +1465,7 @@ Error GDCompiler::_parse_function(GDScript *p_script,const GDParser::ClassNode *
 	codegen.stack_max=0;
 	codegen.current_line=0;
 	codegen.call_max=0;
+	codegen.cache_max=0;
 	codegen.debug_stack=ScriptDebugger::get_singleton()!=NULL;
 
 	int stack_level=0;
@@ -1234,6 +1592,17 @@ Error GDCompiler::_parse_function(GDScript *p_script,const GDParser::ClassNode *
 		gdfunc->_code_size=0;
 	}
 
+	if (codegen.cache_max) {
+
+		gdfunc->caches.resize(codegen.cache_max);
+		gdfunc->_cache_ptr=&gdfunc->caches[0];
+		gdfunc->_cache_count=codegen.cache_max;
+	} else {
+
+		gdfunc->_cache_ptr=NULL;
+		gdfunc->_cache_count=0;
+	}
+
 	if (defarg_addr.size()) {
 
 		gdfunc->default_arguments=defarg_addr;
@@ -1262,6 +1631,11 @@ Error GDCompiler::_parse_function(GDScript *p_script,const GDParser::ClassNode *
 	if (is_initializer)
 		p_script->initializer=gdfunc;
 
+	Error verr = _verify_function(gdfunc,p_func ? (const GDParser::Node*)p_func : (const GDParser::Node*)p_class);
+	if (verr)
+		return verr;
+
+	GDScriptLanguage::get_singleton()->profiling_add_function(gdfunc);
 
 	return OK;
 }
@@ -133,10 +133,12 @@ class GDCompiler {
 		Vector<int> opcodes;
 		void alloc_stack(int p_level) { if (p_level >= stack_max) stack_max=p_level+1; }
 		void alloc_call(int p_params) { if (p_params >= call_max) call_max=p_params; }
+		int alloc_cache() { return cache_max++; }
 
         int current_line;
 		int stack_max;
 		int call_max;
+		int cache_max;
 	};
 
 #if 0
@@ -152,6 +154,8 @@ class GDCompiler {
 
 	void _set_error(const String& p_error,const GDParser::Node *p_node);
 
+	Variant::Type _get_expression_type(CodeGen& codegen,const GDParser::Node *p_expression); //NIL when it can't be proven
+
 	bool _create_unary_operator(CodeGen& codegen,const GDParser::OperatorNode *on,Variant::Operator op, int p_stack_level);
 	bool _create_binary_operator(CodeGen& codegen,const GDParser::OperatorNode *on,Variant::Operator op, int p_stack_level);
 
@@ -160,6 +164,8 @@ class GDCompiler {
 	int _parse_expression(CodeGen& codegen,const GDParser::Node *p_expression, int p_stack_level,bool p_root=false);
 	Error _parse_block(CodeGen& codegen,const GDParser::BlockNode *p_block,int p_stack_level=0,int p_break_addr=-1,int p_continue_addr=-1);
 	Error _parse_function(GDScript *p_script,const GDParser::ClassNode *p_class,const GDParser::FunctionNode *p_func);
+	bool _verify_address(const GDFunction *p_function,int p_address) const;
+	Error _verify_function(const GDFunction *p_function,const GDParser::Node *p_node); //catch codegen bugs before the VM trusts the bytecode
 	Error _parse_class(GDScript *p_script,GDScript *p_owner,const GDParser::ClassNode *p_class);
 	int err_line;
 	int err_column;
@@ -31,6 +31,8 @@
 #include "global_constants.h"
 #include "gd_compiler.h"
 #include "os/file_access.h"
+#include "core_string_names.h"
+#include "os/os.h"
 
 /* TODO:
 
@@ -73,7 +75,9 @@ Variant *GDFunction::_get_variant(int p_address,GDInstance *p_instance,GDScript
 
 			//todo change to index!
 			GDScript *s=p_script;
+#ifdef DEBUG_ENABLED
 			ERR_FAIL_INDEX_V(address,_global_names_count,NULL);
+#endif
 			const StringName *sn = &_global_names_ptr[address];
 
 			while(s) {
@@ -89,19 +93,24 @@ Variant *GDFunction::_get_variant(int p_address,GDInstance *p_instance,GDScript
 			ERR_FAIL_V(NULL);
 		} break;
 		case ADDR_TYPE_LOCAL_CONSTANT: {
+			//ranges were checked by the bytecode verifier, only recheck in debug
+#ifdef DEBUG_ENABLED
 			ERR_FAIL_INDEX_V(address,_constant_count,NULL);
+#endif
 			return &_constants_ptr[address];
 		} break;
 		case ADDR_TYPE_STACK:
 		case ADDR_TYPE_STACK_VARIABLE: {
+#ifdef DEBUG_ENABLED
 			ERR_FAIL_INDEX_V(address,_stack_size,NULL);
+#endif
 			return &p_stack[address];
 		} break;
 		case ADDR_TYPE_GLOBAL: {
 
-
+#ifdef DEBUG_ENABLED
 			ERR_FAIL_INDEX_V(address,GDScriptLanguage::get_singleton()->get_global_array_size(),NULL);
-
+#endif
 
 			return &GDScriptLanguage::get_singleton()->get_global_array()[address];
 		} break;
@@ -173,6 +182,408 @@ static String _get_var_type(const Variant* p_type) {
 
 }
 
+const GDFunction::TypedOperatorInfo GDFunction::typed_operator_info[TYPED_MAX]={
+	{Variant::OP_ADD,Variant::INT,Variant::INT,Variant::INT},
+	{Variant::OP_SUBSTRACT,Variant::INT,Variant::INT,Variant::INT},
+	{Variant::OP_MULTIPLY,Variant::INT,Variant::INT,Variant::INT},
+	{Variant::OP_DIVIDE,Variant::INT,Variant::INT,Variant::INT},
+	{Variant::OP_EQUAL,Variant::INT,Variant::INT,Variant::BOOL},
+	{Variant::OP_NOT_EQUAL,Variant::INT,Variant::INT,Variant::BOOL},
+	{Variant::OP_LESS,Variant::INT,Variant::INT,Variant::BOOL},
+	{Variant::OP_LESS_EQUAL,Variant::INT,Variant::INT,Variant::BOOL},
+	{Variant::OP_GREATER,Variant::INT,Variant::INT,Variant::BOOL},
+	{Variant::OP_GREATER_EQUAL,Variant::INT,Variant::INT,Variant::BOOL},
+	{Variant::OP_ADD,Variant::REAL,Variant::REAL,Variant::REAL},
+	{Variant::OP_SUBSTRACT,Variant::REAL,Variant::REAL,Variant::REAL},
+	{Variant::OP_MULTIPLY,Variant::REAL,Variant::REAL,Variant::REAL},
+	{Variant::OP_DIVIDE,Variant::REAL,Variant::REAL,Variant::REAL},
+	{Variant::OP_EQUAL,Variant::REAL,Variant::REAL,Variant::BOOL},
+	{Variant::OP_NOT_EQUAL,Variant::REAL,Variant::REAL,Variant::BOOL},
+	{Variant::OP_LESS,Variant::REAL,Variant::REAL,Variant::BOOL},
+	{Variant::OP_LESS_EQUAL,Variant::REAL,Variant::REAL,Variant::BOOL},
+	{Variant::OP_GREATER,Variant::REAL,Variant::REAL,Variant::BOOL},
+	{Variant::OP_GREATER_EQUAL,Variant::REAL,Variant::REAL,Variant::BOOL},
+	{Variant::OP_ADD,Variant::VECTOR2,Variant::VECTOR2,Variant::VECTOR2},
+	{Variant::OP_SUBSTRACT,Variant::VECTOR2,Variant::VECTOR2,Variant::VECTOR2},
+	{Variant::OP_MULTIPLY,Variant::VECTOR2,Variant::VECTOR2,Variant::VECTOR2},
+	{Variant::OP_MULTIPLY,Variant::VECTOR2,Variant::REAL,Variant::VECTOR2},
+	{Variant::OP_ADD,Variant::VECTOR3,Variant::VECTOR3,Variant::VECTOR3},
+	{Variant::OP_SUBSTRACT,Variant::VECTOR3,Variant::VECTOR3,Variant::VECTOR3},
+	{Variant::OP_MULTIPLY,Variant::VECTOR3,Variant::VECTOR3,Variant::VECTOR3},
+	{Variant::OP_MULTIPLY,Variant::VECTOR3,Variant::REAL,Variant::VECTOR3},
+};
+
+bool GDFunction::_evaluate_typed(int p_op,const Variant& p_a,const Variant& p_b,Variant& r_ret) {
+
+	const TypedOperatorInfo &info=typed_operator_info[p_op];
+	if (p_a.type!=info.type_a || p_b.type!=info.type_b)
+		return false; //guard failed, use the generic evaluate
+
+#define _VEC2(m_v) (*reinterpret_cast<const Vector2*>(m_v._data._mem))
+#define _VEC3(m_v) (*reinterpret_cast<const Vector3*>(m_v._data._mem))
+
+	switch(p_op) {
+
+		case TYPED_INT_ADD: r_ret=p_a._data._int+p_b._data._int; return true;
+		case TYPED_INT_SUBSTRACT: r_ret=p_a._data._int-p_b._data._int; return true;
+		case TYPED_INT_MULTIPLY: r_ret=p_a._data._int*p_b._data._int; return true;
+		case TYPED_INT_DIVIDE: {
+			if (p_b._data._int==0)
+				return false; //evaluate reports division by zero
+			r_ret=p_a._data._int/p_b._data._int;
+			return true;
+		}
+		case TYPED_INT_EQUAL: r_ret=p_a._data._int==p_b._data._int; return true;
+		case TYPED_INT_NOT_EQUAL: r_ret=p_a._data._int!=p_b._data._int; return true;
+		case TYPED_INT_LESS: r_ret=p_a._data._int<p_b._data._int; return true;
+		case TYPED_INT_LESS_EQUAL: r_ret=p_a._data._int<=p_b._data._int; return true;
+		case TYPED_INT_GREATER: r_ret=p_a._data._int>p_b._data._int; return true;
+		case TYPED_INT_GREATER_EQUAL: r_ret=p_a._data._int>=p_b._data._int; return true;
+		case TYPED_REAL_ADD: r_ret=p_a._data._real+p_b._data._real; return true;
+		case TYPED_REAL_SUBSTRACT: r_ret=p_a._data._real-p_b._data._real; return true;
+		case TYPED_REAL_MULTIPLY: r_ret=p_a._data._real*p_b._data._real; return true;
+		case TYPED_REAL_DIVIDE: r_ret=p_a._data._real/p_b._data._real; return true;
+		case TYPED_REAL_EQUAL: r_ret=p_a._data._real==p_b._data._real; return true;
+		case TYPED_REAL_NOT_EQUAL: r_ret=p_a._data._real!=p_b._data._real; return true;
+		case TYPED_REAL_LESS: r_ret=p_a._data._real<p_b._data._real; return true;
+		case TYPED_REAL_LESS_EQUAL: r_ret=p_a._data._real<=p_b._data._real; return true;
+		case TYPED_REAL_GREATER: r_ret=p_a._data._real>p_b._data._real; return true;
+		case TYPED_REAL_GREATER_EQUAL: r_ret=p_a._data._real>=p_b._data._real; return true;
+		case TYPED_VECTOR2_ADD: r_ret=_VEC2(p_a)+_VEC2(p_b); return true;
+		case TYPED_VECTOR2_SUBSTRACT: r_ret=_VEC2(p_a)-_VEC2(p_b); return true;
+		case TYPED_VECTOR2_MULTIPLY: r_ret=_VEC2(p_a)*_VEC2(p_b); return true;
+		case TYPED_VECTOR2_MULTIPLY_REAL: r_ret=_VEC2(p_a)*p_b._data._real; return true;
+		case TYPED_VECTOR3_ADD: r_ret=_VEC3(p_a)+_VEC3(p_b); return true;
+		case TYPED_VECTOR3_SUBSTRACT: r_ret=_VEC3(p_a)-_VEC3(p_b); return true;
+		case TYPED_VECTOR3_MULTIPLY: r_ret=_VEC3(p_a)*_VEC3(p_b); return true;
+		case TYPED_VECTOR3_MULTIPLY_REAL: r_ret=_VEC3(p_a)*p_b._data._real; return true;
+	}
+
+#undef _VEC2
+#undef _VEC3
+
+	return false;
+}
+
+Object *GDFunction::_get_cache_receiver(const Variant *p_base,GDInstance **r_instance) const {
+
+	if (p_base->get_type()!=Variant::OBJECT)
+		return NULL; //built-in types are not cached
+
+	Object *obj = *p_base;
+	if (!obj)
+		return NULL; //let the regular path report the error
+#ifdef DEBUG_ENABLED
+	if (ScriptDebugger::get_singleton() && !p_base->is_ref() && !ObjectDB::instance_validate(obj))
+		return NULL;
+#endif
+
+	ScriptInstance *si = obj->get_script_instance();
+	if (si) {
+		if (si->get_language()!=GDScriptLanguage::get_singleton())
+			return NULL; //other languages can't be resolved ahead of time
+		*r_instance=static_cast<GDInstance*>(si);
+	} else {
+		*r_instance=NULL;
+	}
+
+	return obj;
+}
+
+bool GDFunction::_cached_builtin_call(int p_cache,const Variant *p_base,const StringName& p_method,const Variant **p_args,int p_argcount,Variant *r_ret,Variant::CallError& r_err) {
+
+	Variant::Type type = p_base->get_type();
+	InlineCache &cache = _cache_ptr[p_cache];
+	uint32_t epoch = GDScriptLanguage::get_singleton()->get_inline_cache_epoch();
+	if (cache.epoch!=epoch) {
+		cache.epoch=epoch;
+		cache.count=0;
+	}
+
+	const InlineCache::Entry *entry=NULL;
+
+	for(int i=0;i<cache.count;i++) {
+
+		const InlineCache::Entry &e=cache.entries[i];
+		if (e.kind==InlineCache::KIND_BUILTIN_METHOD && e.builtin_type==type) {
+			entry=&e;
+			break;
+		}
+	}
+
+	if (!entry) {
+
+		if (cache.count==InlineCache::MAX_ENTRIES)
+			return false; //megamorphic
+
+		const Variant::BuiltinMethod *method = Variant::get_builtin_method(type,p_method);
+		if (!method)
+			return false; //not found, let the regular path report it
+
+		InlineCache::Entry &e=cache.entries[cache.count];
+		e.script=NULL;
+		e.kind=InlineCache::KIND_BUILTIN_METHOD;
+		e.function=NULL;
+		e.method=NULL;
+		e.member=-1;
+		e.builtin_type=type;
+		e.builtin=method;
+		entry=&e;
+		cache.count++;
+	}
+
+	//return value may alias the base or an argument, so call into a temporary
+	Variant ret;
+	const_cast<Variant*>(p_base)->call_builtin(entry->builtin,ret,p_args,p_argcount,r_err);
+	if (r_ret)
+		*r_ret=ret;
+
+	return true;
+}
+
+bool GDFunction::_cached_call(int p_cache,const Variant *p_base,const StringName& p_method,const Variant **p_args,int p_argcount,Variant *r_ret,Variant::CallError& r_err) {
+
+	if (p_base->get_type()!=Variant::OBJECT)
+		return _cached_builtin_call(p_cache,p_base,p_method,p_args,p_argcount,r_ret,r_err);
+
+	GDInstance *ins;
+	Object *obj = _get_cache_receiver(p_base,&ins);
+	if (!obj)
+		return false;
+
+	InlineCache &cache = _cache_ptr[p_cache];
+	uint32_t epoch = GDScriptLanguage::get_singleton()->get_inline_cache_epoch();
+	if (cache.epoch!=epoch) {
+		cache.epoch=epoch;
+		cache.count=0;
+	}
+
+	GDScript *script = ins ? ins->script.ptr() : NULL;
+	StringName type;
+	const InlineCache::Entry *entry=NULL;
+
+	for(int i=0;i<cache.count;i++) {
+
+		const InlineCache::Entry &e=cache.entries[i];
+		if (e.script!=script || e.kind==InlineCache::KIND_BUILTIN_METHOD)
+			continue;
+		if (e.kind==InlineCache::KIND_SCRIPT_FUNCTION) {
+			//script functions shadow native ones, type does not matter
+			entry=&e;
+			break;
+		}
+		if (!type)
+			type=obj->get_type_name();
+		if (e.type==type) {
+			entry=&e;
+			break;
+		}
+	}
+
+	if (!entry) {
+
+		if (cache.count==InlineCache::MAX_ENTRIES)
+			return false; //megamorphic
+		if (p_method==CoreStringNames::get_singleton()->_free)
+			return false; //must always go through Object::call
+
+		InlineCache::Entry e;
+		e.script=script;
+		e.function=NULL;
+		e.method=NULL;
+		e.member=-1;
+
+		for(GDScript *sptr=script;sptr;sptr=sptr->_base) {
+
+			Map<StringName,GDFunction>::Element *E = sptr->member_functions.find(p_method);
+			if (E) {
+				e.kind=InlineCache::KIND_SCRIPT_FUNCTION;
+				e.function=&E->get();
+				break;
+			}
+		}
+
+		if (!e.function) {
+
+			if (obj->cast_to<GDScript>())
+				return false; //GDScript::call looks up static functions before native methods
+			if (!type)
+				type=obj->get_type_name();
+			e.method=ObjectTypeDB::get_method(type,p_method);
+			if (!e.method)
+				return false; //not found, let the regular path report it
+			e.kind=InlineCache::KIND_NATIVE_METHOD;
+			e.type=type;
+		}
+
+		cache.entries[cache.count]=e;
+		entry=&cache.entries[cache.count];
+		cache.count++;
+	}
+
+	if (entry->kind==InlineCache::KIND_SCRIPT_FUNCTION) {
+
+		if (r_ret)
+			*r_ret=entry->function->call(ins,p_args,p_argcount,r_err);
+		else
+			entry->function->call(ins,p_args,p_argcount,r_err);
+	} else {
+
+		if (r_ret)
+			*r_ret=entry->method->call(obj,p_args,p_argcount,r_err);
+		else
+			entry->method->call(obj,p_args,p_argcount,r_err);
+	}
+
+	return true;
+}
+
+bool GDFunction::_cached_get(int p_cache,const Variant *p_base,const StringName& p_name,Variant *r_ret) {
+
+	GDInstance *ins;
+	Object *obj = _get_cache_receiver(p_base,&ins);
+	if (!obj)
+		return false;
+
+	InlineCache &cache = _cache_ptr[p_cache];
+	uint32_t epoch = GDScriptLanguage::get_singleton()->get_inline_cache_epoch();
+	if (cache.epoch!=epoch) {
+		cache.epoch=epoch;
+		cache.count=0;
+	}
+
+	GDScript *script = ins ? ins->script.ptr() : NULL;
+	StringName type;
+	if (!script)
+		type=obj->get_type_name();
+
+	const InlineCache::Entry *entry=NULL;
+
+	for(int i=0;i<cache.count;i++) {
+
+		const InlineCache::Entry &e=cache.entries[i];
+		if (e.script==script && (script || e.type==type)) {
+			entry=&e;
+			break;
+		}
+	}
+
+	if (!entry) {
+
+		if (cache.count==InlineCache::MAX_ENTRIES)
+			return false; //megamorphic
+
+		InlineCache::Entry e;
+		e.script=script;
+		e.type=type;
+		e.function=NULL;
+		e.method=NULL;
+		e.member=-1;
+
+		if (script) {
+			//same lookup GDInstance::get does first, anything else may be overriden by _get
+			const Map<StringName,int>::Element *E = script->member_indices.find(p_name);
+			if (!E)
+				return false;
+			e.kind=InlineCache::KIND_MEMBER;
+			e.member=E->get();
+		} else {
+			e.method=ObjectTypeDB::get_property_getter(type,p_name);
+			if (!e.method)
+				return false;
+			e.kind=InlineCache::KIND_NATIVE_METHOD;
+		}
+
+		cache.entries[cache.count]=e;
+		entry=&cache.entries[cache.count];
+		cache.count++;
+	}
+
+	if (entry->kind==InlineCache::KIND_MEMBER) {
+		*r_ret=ins->members[entry->member];
+	} else {
+		Variant::CallError ce;
+		*r_ret=entry->method->call(obj,NULL,0,ce);
+	}
+
+	return true;
+}
+
+bool GDFunction::_cached_set(int p_cache,const Variant *p_base,const StringName& p_name,const Variant& p_value) {
+
+	GDInstance *ins;
+	Object *obj = _get_cache_receiver(p_base,&ins);
+	if (!obj)
+		return false;
+
+	InlineCache &cache = _cache_ptr[p_cache];
+	uint32_t epoch = GDScriptLanguage::get_singleton()->get_inline_cache_epoch();
+	if (cache.epoch!=epoch) {
+		cache.epoch=epoch;
+		cache.count=0;
+	}
+
+	GDScript *script = ins ? ins->script.ptr() : NULL;
+	StringName type;
+	if (!script)
+		type=obj->get_type_name();
+
+	const InlineCache::Entry *entry=NULL;
+
+	for(int i=0;i<cache.count;i++) {
+
+		const InlineCache::Entry &e=cache.entries[i];
+		if (e.script==script && (script || e.type==type)) {
+			entry=&e;
+			break;
+		}
+	}
+
+	if (!entry) {
+
+		if (cache.count==InlineCache::MAX_ENTRIES)
+			return false; //megamorphic
+
+		InlineCache::Entry e;
+		e.script=script;
+		e.type=type;
+		e.function=NULL;
+		e.method=NULL;
+		e.member=-1;
+
+		if (script) {
+			const Map<StringName,int>::Element *E = script->member_indices.find(p_name);
+			if (!E)
+				return false;
+			e.kind=InlineCache::KIND_MEMBER;
+			e.member=E->get();
+		} else {
+			e.method=ObjectTypeDB::get_property_setter(type,p_name);
+			if (!e.method)
+				return false;
+			e.kind=InlineCache::KIND_NATIVE_METHOD;
+		}
+
+		cache.entries[cache.count]=e;
+		entry=&cache.entries[cache.count];
+		cache.count++;
+	}
+
+#ifdef TOOLS_ENABLED
+	obj->set_edited(true); //as Object::set does
+#endif
+
+	if (entry->kind==InlineCache::KIND_MEMBER) {
+		ins->members[entry->member]=p_value;
+	} else {
+		const Variant* arg[1]={&p_value};
+		Variant::CallError ce;
+		entry->method->call(obj,arg,1,ce);
+	}
+
+	return true;
+}
+
 Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_argcount,Variant::CallError& r_err) {
 
 
@@ -264,6 +675,24 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 	int line=_initial_line;
 	String err_text;
 
+	bool main_thread = Thread::get_caller_ID()==Thread::get_main_ID();
+
+	//inline caches are not thread safe, only the main thread uses them
+	bool use_caches = _cache_count && main_thread;
+
+	//profiler, self time excludes time spent in the script functions called from here
+	bool profiling = GDScriptLanguage::get_singleton()->profiling && main_thread;
+	uint64_t profile_start_time=0;
+	uint64_t profile_callee_time=0;
+	uint64_t *profile_caller_time=NULL;
+
+	if (profiling) {
+
+		profile_caller_time=GDScriptLanguage::get_singleton()->_profile_callee_time;
+		GDScriptLanguage::get_singleton()->_profile_callee_time=&profile_callee_time;
+		profile_start_time=OS::get_singleton()->get_ticks_usec();
+	}
+
 
 
 #ifdef DEBUG_ENABLED
@@ -272,40 +701,118 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
         GDScriptLanguage::get_singleton()->enter_function(p_instance,this,stack,&ip,&line);
 
 #define CHECK_SPACE(m_space)\
-	ERR_BREAK((ip+m_space)>_code_size)
+	GD_ERR_BREAK((ip+m_space)>_code_size)
 
 #define GET_VARIANT_PTR(m_v,m_code_ofs) \
 	Variant *m_v; \
 	m_v = _get_variant(_code_ptr[ip+m_code_ofs],p_instance,_class,self,stack,err_text);\
 	if (!m_v)\
-		break;
+		OPCODE_BREAK;
 
+//bytecode was validated by GDCompiler, but keep checking while debugging
+#define GD_ERR_BREAK(m_cond) \
+	{ if (m_cond) { _err_print_error(FUNCTION_STR,__FILE__,__LINE__,"Condition ' " _STR(m_cond) " ' is true. Breaking..:"); OPCODE_BREAK; } }
 
 #else
 #define CHECK_SPACE(m_space)
+//self and member addresses still fail at runtime when there is no instance (static calls)
 #define GET_VARIANT_PTR(m_v,m_code_ofs) \
 	Variant *m_v; \
-	m_v = _get_variant(_code_ptr[ip+m_code_ofs],p_instance,_class,self,stack,err_text);
+	m_v = _get_variant(_code_ptr[ip+m_code_ofs],p_instance,_class,self,stack,err_text);\
+	if (!m_v)\
+		OPCODE_BREAK;
+
+#define GD_ERR_BREAK(m_cond)
 
 #endif
 
+#ifdef GDSCRIPT_THREADED_DISPATCH
+
+	//direct threaded dispatch, each opcode jumps straight to the next one
+	static const void* switch_table_ops[]={
+		&&OPCODE_OPERATOR_LABEL,
+		&&OPCODE_OPERATOR_TYPED_LABEL,
+		&&OPCODE_EXTENDS_TEST_LABEL,
+		&&OPCODE_SET_LABEL,
+		&&OPCODE_GET_LABEL,
+		&&OPCODE_SET_NAMED_LABEL,
+		&&OPCODE_GET_NAMED_LABEL,
+		&&OPCODE_ASSIGN_LABEL,
+		&&OPCODE_ASSIGN_TRUE_LABEL,
+		&&OPCODE_ASSIGN_FALSE_LABEL,
+		&&OPCODE_CONSTRUCT_LABEL,
+		&&OPCODE_CONSTRUCT_ARRAY_LABEL,
+		&&OPCODE_CONSTRUCT_DICTIONARY_LABEL,
+		&&OPCODE_CALL_LABEL,
+		&&OPCODE_CALL_RETURN_LABEL,
+		&&OPCODE_CALL_BUILT_IN_LABEL,
+		&&OPCODE_CALL_SELF_LABEL,
+		&&OPCODE_CALL_SELF_BASE_LABEL,
+		&&OPCODE_JUMP_LABEL,
+		&&OPCODE_JUMP_IF_LABEL,
+		&&OPCODE_JUMP_IF_NOT_LABEL,
+		&&OPCODE_JUMP_TO_DEF_ARGUMENT_LABEL,
+		&&OPCODE_RETURN_LABEL,
+		&&OPCODE_ITERATE_BEGIN_LABEL,
+		&&OPCODE_ITERATE_LABEL,
+		&&OPCODE_ASSERT_LABEL,
+		&&OPCODE_LINE_LABEL,
+		&&OPCODE_END_LABEL
+	};
+	//fails to compile if an opcode was added but not to the table above
+	(void)sizeof(char[(sizeof(switch_table_ops)/sizeof(switch_table_ops[0])==OPCODE_END+1)?1:-1]);
+
+#define OPCODE(m_op) m_op##_LABEL:
+#define OPCODE_WHILE(m_test)
+#define OPCODE_SWITCH(m_test) DISPATCH_OPCODE;
+#define OPCODE_BREAK goto OPSEXIT
+#define OPCODE_OUT goto OPSOUT
+#define OPCODES_END OPSEXIT:
+#define OPCODES_OUT OPSOUT:
 
+#ifdef DEBUG_ENABLED
+#define DISPATCH_OPCODE {\
+	if (ip>=_code_size)\
+		OPCODE_OUT;\
+	last_opcode=_code_ptr[ip];\
+	if (last_opcode<0 || last_opcode>OPCODE_END) {\
+		err_text="Illegal opcode "+itos(last_opcode)+" at address "+itos(ip);\
+		OPCODE_BREAK;\
+	}\
+	goto *switch_table_ops[last_opcode];\
+}
+#else
+#define DISPATCH_OPCODE { last_opcode=_code_ptr[ip]; goto *switch_table_ops[last_opcode]; }
+#endif
+
+#else
+
+#define OPCODE(m_op) case m_op:
+#define OPCODE_WHILE(m_test) while(m_test)
+#define OPCODE_SWITCH(m_test) last_opcode=m_test; switch(m_test)
+#define OPCODE_BREAK break
+#define OPCODE_OUT break
+#define OPCODES_END
+#define OPCODES_OUT
+#define DISPATCH_OPCODE continue
+
+#endif
 
 	bool exit_ok=false;
+	int last_opcode=-1;
 
-	while(ip<_code_size) {
+	OPCODE_WHILE(ip<_code_size) {
 
 
-		int last_opcode=_code_ptr[ip];
-		switch(_code_ptr[ip]) {
+		OPCODE_SWITCH(_code_ptr[ip]) {
 
-			case OPCODE_OPERATOR: {
+			OPCODE(OPCODE_OPERATOR) {
 
 				CHECK_SPACE(5);
 
 				bool valid;
 				Variant::Operator op = (Variant::Operator)_code_ptr[ip+1];
-				ERR_BREAK(op>=Variant::OP_MAX);
+				GD_ERR_BREAK(op>=Variant::OP_MAX);
 
 				GET_VARIANT_PTR(a,2);
 				GET_VARIANT_PTR(b,3);
@@ -319,13 +826,40 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 					} else {
 						err_text="Invalid operands '"+Variant::get_type_name(a->get_type())+"' and '"+Variant::get_type_name(b->get_type())+"' in operator '"+Variant::get_operator_name(op)+"'.";
 					}
-					break;
+					OPCODE_BREAK;
+				}
+
+				ip+=5;
+
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_OPERATOR_TYPED) {
+
+				CHECK_SPACE(5);
+
+				int typed_op = _code_ptr[ip+1];
+				GD_ERR_BREAK(typed_op<0 || typed_op>=TYPED_MAX);
+
+				GET_VARIANT_PTR(a,2);
+				GET_VARIANT_PTR(b,3);
+				GET_VARIANT_PTR(dst,4);
+
+				if (!_evaluate_typed(typed_op,*a,*b,*dst)) {
+					//deoptimize, operands are not what the compiler expected
+					bool valid;
+					Variant::Operator op = typed_operator_info[typed_op].op;
+					Variant::evaluate(op,*a,*b,*dst,valid);
+					if (!valid) {
+						err_text="Invalid operands '"+Variant::get_type_name(a->get_type())+"' and '"+Variant::get_type_name(b->get_type())+"' in operator '"+Variant::get_operator_name(op)+"'.";
+						OPCODE_BREAK;
+					}
 				}
 
 				ip+=5;
 
-			} continue;
-			case OPCODE_EXTENDS_TEST: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_EXTENDS_TEST) {
 
 				CHECK_SPACE(4);
 
@@ -338,13 +872,13 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				if (a->get_type()!=Variant::OBJECT || a->operator Object*()==NULL) {
 
 					err_text="Left operand of 'extends' is not an instance of anything.";
-					break;
+					OPCODE_BREAK;
 
 				}
 				if (b->get_type()!=Variant::OBJECT || b->operator Object*()==NULL) {
 
 					err_text="Right operand of 'extends' is not a class.";
-					break;
+					OPCODE_BREAK;
 
 				}
 #endif
@@ -387,7 +921,7 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 					if (!nc) {
 
 						err_text="Right operand of 'extends' is not a class (type: '"+obj_B->get_type()+"').";
-						break;
+						OPCODE_BREAK;
 					}
 
 					extends_ok=ObjectTypeDB::is_type(obj_A->get_type_name(),nc->get_name());
@@ -396,8 +930,9 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				*dst=extends_ok;
 				ip+=4;
 
-			} continue;
-			case OPCODE_SET: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_SET) {
 
 				CHECK_SPACE(3);
 
@@ -416,12 +951,13 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 						v="of type '"+_get_var_type(index)+"'";
 					}
 					err_text="Invalid set index "+v+" (on base: '"+_get_var_type(dst)+"').";
-					break;
+					OPCODE_BREAK;
 				}
 
 				ip+=4;
-			} continue;
-			case OPCODE_GET: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_GET) {
 
 				CHECK_SPACE(3);
 
@@ -440,57 +976,72 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 						v="of type '"+_get_var_type(index)+"'";
 					}
 					err_text="Invalid get index "+v+" (on base: '"+_get_var_type(src)+"').";
-					break;
+					OPCODE_BREAK;
 				}
 				ip+=4;
-			} continue;
-			case OPCODE_SET_NAMED: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_SET_NAMED) {
 
-				CHECK_SPACE(3);
+				CHECK_SPACE(5);
 
 				GET_VARIANT_PTR(dst,1);
 				GET_VARIANT_PTR(value,3);
 
 				int indexname = _code_ptr[ip+2];
 
-				ERR_BREAK(indexname<0 || indexname>=_global_names_count);
+				GD_ERR_BREAK(indexname<0 || indexname>=_global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
-				bool valid;
-				dst->set_named(*index,*value,&valid);
+				int cache = _code_ptr[ip+4];
+				GD_ERR_BREAK(cache<0 || cache>=_cache_count);
 
-				if (!valid) {
-					String err_type;
-					err_text="Invalid set index '"+String(*index)+"' (on base: '"+_get_var_type(dst)+"').";
-					break;
+				if (!use_caches || !_cached_set(cache,dst,*index,*value)) {
+
+					bool valid;
+					dst->set_named(*index,*value,&valid);
+
+					if (!valid) {
+						String err_type;
+						err_text="Invalid set index '"+String(*index)+"' (on base: '"+_get_var_type(dst)+"').";
+						OPCODE_BREAK;
+					}
 				}
 
-				ip+=4;
-			} continue;
-			case OPCODE_GET_NAMED: {
+				ip+=5;
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_GET_NAMED) {
 
 
-				CHECK_SPACE(3);
+				CHECK_SPACE(5);
 
 				GET_VARIANT_PTR(src,1);
-				GET_VARIANT_PTR(dst,3);
+				GET_VARIANT_PTR(dst,4);
 
 				int indexname = _code_ptr[ip+2];
 
-				ERR_BREAK(indexname<0 || indexname>=_global_names_count);
+				GD_ERR_BREAK(indexname<0 || indexname>=_global_names_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
-				bool valid;
-				*dst = src->get_named(*index,&valid);
+				int cache = _code_ptr[ip+3];
+				GD_ERR_BREAK(cache<0 || cache>=_cache_count);
 
-				if (!valid) {
-					err_text="Invalid get index '"+index->operator String()+"' (on base: '"+_get_var_type(src)+"').";
-					break;
+				if (!use_caches || !_cached_get(cache,src,*index,dst)) {
+
+					bool valid;
+					*dst = src->get_named(*index,&valid);
+
+					if (!valid) {
+						err_text="Invalid get index '"+index->operator String()+"' (on base: '"+_get_var_type(src)+"').";
+						OPCODE_BREAK;
+					}
 				}
 
-				ip+=4;
-			} continue;
-			case OPCODE_ASSIGN: {
+				ip+=5;
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_ASSIGN) {
 
 				CHECK_SPACE(3);
 				GET_VARIANT_PTR(dst,1);
@@ -500,8 +1051,9 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 
 				ip+=3;
 
-			} continue;
-			case OPCODE_ASSIGN_TRUE: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_ASSIGN_TRUE) {
 
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(dst,1);
@@ -509,8 +1061,9 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				*dst = true;
 
 				ip+=2;
-			} continue;
-			case OPCODE_ASSIGN_FALSE: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_ASSIGN_FALSE) {
 
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(dst,1);
@@ -518,8 +1071,9 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				*dst = false;
 
 				ip+=2;
-			} continue;
-			case OPCODE_CONSTRUCT: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_CONSTRUCT) {
 
 				CHECK_SPACE(2);
 				Variant::Type t=Variant::Type(_code_ptr[ip+1]);
@@ -538,13 +1092,14 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				if (err.error!=Variant::CallError::CALL_OK) {
 
 					err_text=_get_call_error(err,"'"+Variant::get_type_name(t)+"' constructor",(const Variant**)argptrs);
-					break;
+					OPCODE_BREAK;
 				}
 
 				ip+=4+argc;
 				//construct a basic type
-			} continue;
-			case OPCODE_CONSTRUCT_ARRAY: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_CONSTRUCT_ARRAY) {
 
 				CHECK_SPACE(1);
 				int argc=_code_ptr[ip+1];
@@ -564,8 +1119,9 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 
 				ip+=3+argc;
 
-			} continue;
-			case OPCODE_CONSTRUCT_DICTIONARY: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_CONSTRUCT_DICTIONARY) {
 
 				CHECK_SPACE(1);
 				int argc=_code_ptr[ip+1];
@@ -587,23 +1143,27 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 
 				ip+=3+argc*2;
 
-			} continue;
-			case OPCODE_CALL_RETURN:
-			case OPCODE_CALL: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_CALL_RETURN)
+			OPCODE(OPCODE_CALL) {
 
 
-				CHECK_SPACE(4);
+				CHECK_SPACE(5);
 				bool call_ret = _code_ptr[ip]==OPCODE_CALL_RETURN;
 
 				int argc=_code_ptr[ip+1];
 				GET_VARIANT_PTR(base,2);
 				int nameg=_code_ptr[ip+3];
 
-				ERR_BREAK(nameg<0 || nameg>=_global_names_count);
+				GD_ERR_BREAK(nameg<0 || nameg>=_global_names_count);
 				const StringName *methodname = &_global_names_ptr[nameg];
 
-				ERR_BREAK(argc<0);
-				ip+=4;
+				int cache=_code_ptr[ip+4];
+				GD_ERR_BREAK(cache<0 || cache>=_cache_count);
+
+				GD_ERR_BREAK(argc<0);
+				ip+=5;
 				CHECK_SPACE(argc+1);
 				Variant **argptrs = call_args;
 
@@ -616,10 +1176,12 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				if (call_ret) {
 
 					GET_VARIANT_PTR(ret,argc);
-					*ret = base->call(*methodname,(const Variant**)argptrs,argc,err);
+					if (!use_caches || !_cached_call(cache,base,*methodname,(const Variant**)argptrs,argc,ret,err))
+						*ret = base->call(*methodname,(const Variant**)argptrs,argc,err);
 				} else {
 
-					base->call(*methodname,(const Variant**)argptrs,argc,err);
+					if (!use_caches || !_cached_call(cache,base,*methodname,(const Variant**)argptrs,argc,NULL,err))
+						base->call(*methodname,(const Variant**)argptrs,argc,err);
 				}
 
 				if (err.error!=Variant::CallError::CALL_OK) {
@@ -637,20 +1199,21 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 						}
 					}
 					err_text=_get_call_error(err,"function '"+methodstr+"' in base '"+basestr+"'",(const Variant**)argptrs);
-					break;
+					OPCODE_BREAK;
 				}
 
 				//_call_func(NULL,base,*methodname,ip,argc,p_instance,stack);
 				ip+=argc+1;
 
-			} continue;
-			case OPCODE_CALL_BUILT_IN: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_CALL_BUILT_IN) {
 
 				CHECK_SPACE(4);
 
 				GDFunctions::Function func = GDFunctions::Function(_code_ptr[ip+1]);
 				int argc=_code_ptr[ip+2];
-				ERR_BREAK(argc<0);
+				GD_ERR_BREAK(argc<0);
 
 				ip+=3;
 				CHECK_SPACE(argc+1);
@@ -672,16 +1235,18 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 
 					String methodstr = GDFunctions::get_func_name(func);
 					err_text=_get_call_error(err,"built-in function '"+methodstr+"'",(const Variant**)argptrs);
-					break;
+					OPCODE_BREAK;
 				}
 				ip+=argc+1;
 
-			} continue;
-			case OPCODE_CALL_SELF: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_CALL_SELF) {
 
 
-			} break;
-			case OPCODE_CALL_SELF_BASE: {
+				OPCODE_BREAK;
+			}
+			OPCODE(OPCODE_CALL_SELF_BASE) {
 
 				CHECK_SPACE(2);
 				int self_fun = _code_ptr[ip+1];
@@ -690,7 +1255,7 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				if (self_fun<0 || self_fun>=_global_names_count) {
 
 					err_text="compiler bug, function name not found";
-					break;
+					OPCODE_BREAK;
 				}
 #endif
 				const StringName *methodname = &_global_names_ptr[self_fun];
@@ -753,22 +1318,24 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 					String methodstr = *methodname;
 					err_text=_get_call_error(err,"function '"+methodstr+"'",(const Variant**)argptrs);
 
-					break;
+					OPCODE_BREAK;
 				}
 
 				ip+=4+argc;
 
-			} continue;
-			case OPCODE_JUMP: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_JUMP) {
 
 				CHECK_SPACE(2);
 				int to = _code_ptr[ip+1];
 
-				ERR_BREAK(to<0 || to>_code_size);
+				GD_ERR_BREAK(to<0 || to>_code_size);
 				ip=to;
 
-			} continue;
-			case OPCODE_JUMP_IF: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_JUMP_IF) {
 
 				CHECK_SPACE(3);
 
@@ -780,18 +1347,19 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				if (!valid) {
 
 					err_text="cannot evaluate conditional expression of type: "+Variant::get_type_name(test->get_type());
-					break;
+					OPCODE_BREAK;
 				}
 #endif
 				if (result) {
 					int to = _code_ptr[ip+2];
-					ERR_BREAK(to<0 || to>_code_size);
+					GD_ERR_BREAK(to<0 || to>_code_size);
 					ip=to;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				ip+=3;
-			} continue;
-			case OPCODE_JUMP_IF_NOT: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_JUMP_IF_NOT) {
 
 				CHECK_SPACE(3);
 
@@ -803,32 +1371,35 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				if (!valid) {
 
 					err_text="cannot evaluate conditional expression of type: "+Variant::get_type_name(test->get_type());
-					break;
+					OPCODE_BREAK;
 				}
 #endif
 				if (!result) {
 					int to = _code_ptr[ip+2];
-					ERR_BREAK(to<0 || to>_code_size);
+					GD_ERR_BREAK(to<0 || to>_code_size);
 					ip=to;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				ip+=3;
-			} continue;
-			case OPCODE_JUMP_TO_DEF_ARGUMENT: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_JUMP_TO_DEF_ARGUMENT) {
 
 				CHECK_SPACE(2);
 				ip=_default_arg_ptr[defarg];
 
-			} continue;
-			case OPCODE_RETURN: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_RETURN) {
 
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(r,1);
 				retvalue=*r;
 				exit_ok=true;
 
-			} break;
-			case OPCODE_ITERATE_BEGIN: {
+				OPCODE_BREAK;
+			}
+			OPCODE(OPCODE_ITERATE_BEGIN) {
 
 				CHECK_SPACE(8); //space for this an regular iterate
 
@@ -839,12 +1410,12 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				if (!container->iter_init(*counter,valid)) {
 					if (!valid) {
 						err_text="Unable to iterate on object of type  "+Variant::get_type_name(container->get_type())+"'.";
-						break;
+						OPCODE_BREAK;
 					}
 					int jumpto=_code_ptr[ip+3];
-					ERR_BREAK(jumpto<0 || jumpto>_code_size);
+					GD_ERR_BREAK(jumpto<0 || jumpto>_code_size);
 					ip=jumpto;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				GET_VARIANT_PTR(iterator,4);
 
@@ -852,14 +1423,15 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				*iterator=container->iter_get(*counter,valid);
 				if (!valid) {
 					err_text="Unable to obtain iterator object of type  "+Variant::get_type_name(container->get_type())+"'.";
-					break;
+					OPCODE_BREAK;
 				}
 
 
 				ip+=5; //skip regular iterate which is always next
 
-			} continue;
-			case OPCODE_ITERATE: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_ITERATE) {
 
 				CHECK_SPACE(4);
 
@@ -870,24 +1442,25 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				if (!container->iter_next(*counter,valid)) {
 					if (!valid) {
 						err_text="Unable to iterate on object of type  "+Variant::get_type_name(container->get_type())+"' (type changed since first iteration?).";
-						break;
+						OPCODE_BREAK;
 					}
 					int jumpto=_code_ptr[ip+3];
-					ERR_BREAK(jumpto<0 || jumpto>_code_size);
+					GD_ERR_BREAK(jumpto<0 || jumpto>_code_size);
 					ip=jumpto;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				GET_VARIANT_PTR(iterator,4);
 
 				*iterator=container->iter_get(*counter,valid);
 				if (!valid) {
 					err_text="Unable to obtain iterator object of type  "+Variant::get_type_name(container->get_type())+"' (but was obtained on first iteration?).";
-					break;
+					OPCODE_BREAK;
 				}
 
 				ip+=5; //loop again
-			} continue;
-			case OPCODE_ASSERT: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_ASSERT) {
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(test,1);
 
@@ -899,21 +1472,22 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 				if (!valid) {
 
 					err_text="cannot evaluate conditional expression of type: "+Variant::get_type_name(test->get_type());
-					break;
+					OPCODE_BREAK;
 				}
 
 
 				if (!result) {
 
 					err_text="Assertion failed.";
-					break;
+					OPCODE_BREAK;
 				}
 
 #endif
 
 				ip+=2;
-			} continue;
-			case OPCODE_LINE: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_LINE) {
 				CHECK_SPACE(2);
 
 				line=_code_ptr[ip+1];
@@ -941,22 +1515,26 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
 					ScriptDebugger::get_singleton()->line_poll();
 
 				}
-			} continue;
-			case OPCODE_END: {
+				DISPATCH_OPCODE;
+			}
+			OPCODE(OPCODE_END) {
 
 				exit_ok=true;
-				break;
-
-			} break;
+				OPCODE_BREAK;
+			}
+#ifndef GDSCRIPT_THREADED_DISPATCH
 			default: {
 
 				err_text="Illegal opcode "+itos(_code_ptr[ip])+" at address "+itos(ip);
 			} break;
+#endif
 
 		}
 
+		OPCODES_END
+
 		if (exit_ok)
-			break;
+			OPCODE_OUT;
 		//error
 		// function, file, line, error, explanation
 		String err_file;
@@ -981,7 +1559,26 @@ Variant GDFunction::call(GDInstance *p_instance,const Variant **p_args, int p_ar
         }
 
 
-		break;
+		OPCODE_OUT;
+	}
+
+	OPCODES_OUT
+
+	if (profiling) {
+
+		uint64_t total_time = OS::get_singleton()->get_ticks_usec()-profile_start_time;
+		uint64_t self_time = total_time>profile_callee_time ? total_time-profile_callee_time : 0;
+
+		GDScriptLanguage::get_singleton()->_profile_callee_time=profile_caller_time;
+		if (profile_caller_time)
+			*profile_caller_time+=total_time;
+
+		profile.call_count++;
+		profile.total_time+=total_time;
+		profile.self_time+=self_time;
+		profile.frame_call_count++;
+		profile.frame_total_time+=total_time;
+		profile.frame_self_time+=self_time;
 	}
 
     if (ScriptDebugger::get_singleton())
@@ -1007,6 +1604,29 @@ int GDFunction::get_code_size() const{
 	return _code_size;
 }
 
+int GDFunction::get_inline_cache_count() const {
+
+	return _cache_count;
+}
+
+const GDFunction::TypedOperatorInfo& GDFunction::get_typed_operator_info(int p_typed_op) {
+
+	ERR_FAIL_INDEX_V(p_typed_op,TYPED_MAX,typed_operator_info[0]);
+	return typed_operator_info[p_typed_op];
+}
+
+int GDFunction::find_typed_operator(Variant::Operator p_op,Variant::Type p_type_a,Variant::Type p_type_b) {
+
+	for(int i=0;i<TYPED_MAX;i++) {
+
+		const TypedOperatorInfo &info=typed_operator_info[i];
+		if (info.op==p_op && info.type_a==p_type_a && info.type_b==p_type_b)
+			return i;
+	}
+
+	return -1;
+}
+
 Variant GDFunction::get_constant(int p_idx) const {
 
 	ERR_FAIL_INDEX_V(p_idx,constants.size(),"<errconst>");
@@ -1136,10 +1756,18 @@ GDFunction::GDFunction() {
 
 	_stack_size=0;
 	_call_size=0;
+	_cache_ptr=NULL;
+	_cache_count=0;
 	name="<anonymous>";
 
 }
 
+GDFunction::~GDFunction() {
+
+	if (GDScriptLanguage::get_singleton())
+		GDScriptLanguage::get_singleton()->profiling_remove_function(this);
+}
+
 GDNativeClass::GDNativeClass(const StringName& p_name) {
 
 	name=p_name;
@@ -1424,6 +2052,8 @@ Error GDScript::reload() {
 
 
 	valid=false;
+	//functions and member indices are about to be rebuilt
+	GDScriptLanguage::get_singleton()->invalidate_inline_caches();
 	GDParser parser;
 	Error err = parser.parse(source,basedir);
 	if (err) {
@@ -1630,6 +2260,13 @@ GDScript::GDScript() {
 	tool=false;
 }
 
+GDScript::~GDScript() {
+
+	//another script could be allocated at the same address
+	if (GDScriptLanguage::get_singleton())
+		GDScriptLanguage::get_singleton()->invalidate_inline_caches();
+}
+
 
 
 
@@ -2056,6 +2693,105 @@ void GDScriptLanguage::frame() {
 
 //	print_line("calls: "+itos(calls));
 	calls=0;
+
+	if (profiling) {
+
+		lock->lock();
+		for(Set<GDFunction*>::Element *E=function_list.front();E;E=E->next()) {
+
+			GDFunction::Profile &p=E->get()->profile;
+			p.frame_call_count=0;
+			p.frame_self_time=0;
+			p.frame_total_time=0;
+		}
+		lock->unlock();
+	}
+}
+
+/* PROFILING FUNCTIONS */
+
+void GDScriptLanguage::profiling_add_function(GDFunction *p_function) {
+
+	p_function->profile.signature=String(p_function->source)+"::"+itos(p_function->_initial_line)+"::"+String(p_function->name);
+
+	lock->lock();
+	function_list.insert(p_function);
+	lock->unlock();
+}
+
+void GDScriptLanguage::profiling_remove_function(GDFunction *p_function) {
+
+	lock->lock();
+	function_list.erase(p_function);
+	lock->unlock();
+}
+
+void GDScriptLanguage::profiling_start() {
+
+	lock->lock();
+	for(Set<GDFunction*>::Element *E=function_list.front();E;E=E->next()) {
+
+		GDFunction::Profile &p=E->get()->profile;
+		p.call_count=0;
+		p.self_time=0;
+		p.total_time=0;
+		p.frame_call_count=0;
+		p.frame_self_time=0;
+		p.frame_total_time=0;
+	}
+	profiling=true;
+	lock->unlock();
+}
+
+void GDScriptLanguage::profiling_stop() {
+
+	lock->lock();
+	profiling=false;
+	lock->unlock();
+}
+
+int GDScriptLanguage::profiling_get_accumulated_data(ProfilingInfo *p_info_arr,int p_info_max) {
+
+	int current=0;
+
+	lock->lock();
+	for(Set<GDFunction*>::Element *E=function_list.front();E && current<p_info_max;E=E->next()) {
+
+		const GDFunction::Profile &p=E->get()->profile;
+		if (p.call_count==0)
+			continue;
+
+		p_info_arr[current].signature=p.signature;
+		p_info_arr[current].call_count=p.call_count;
+		p_info_arr[current].total_time=p.total_time;
+		p_info_arr[current].self_time=p.self_time;
+		current++;
+	}
+	lock->unlock();
+
+	return current;
+}
+
+int GDScriptLanguage::profiling_get_frame_data(ProfilingInfo *p_info_arr,int p_info_max) {
+
+	int current=0;
+
+	lock->lock();
+	for(Set<GDFunction*>::Element *E=function_list.front();E && current<p_info_max;E=E->next()) {
+
+		const GDFunction::Profile &p=E->get()->profile;
+		if (p.frame_call_count==0)
+			continue;
+
+		p_info_arr[current].signature=p.signature;
+		p_info_arr[current].call_count=p.frame_call_count;
+		p_info_arr[current].total_time=p.frame_total_time;
+		p_info_arr[current].self_time=p.frame_self_time;
+		current++;
+	}
+	lock->unlock();
+
+	return current;
 }
 
 /* EDITOR FUNCTIONS */
@@ -2108,6 +2844,10 @@ void GDScriptLanguage::get_reserved_words(List<String> *p_words) const  {
 GDScriptLanguage::GDScriptLanguage() {
 
 	calls=0;
+	_inline_cache_epoch=1;
+	lock=Mutex::create();
+	profiling=false;
+	_profile_callee_time=NULL;
 	ERR_FAIL_COND(singleton);
 	singleton=this;
 	strings._init = StaticCString::create("_init");
@@ -2142,6 +2882,7 @@ GDScriptLanguage::~GDScriptLanguage() {
         memdelete_arr(_call_stack);
     }
     singleton=NULL;
+    memdelete(lock);
 }
 
 /*************** RESOURCE ***************/
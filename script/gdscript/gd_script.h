@@ -33,6 +33,8 @@
 #include "io/resource_loader.h"
 #include "io/resource_saver.h"
 #include "os/thread.h"
+#include "os/mutex.h"
+#include "set.h"
 #include "pair.h"
 class GDInstance;
 class GDScript;
@@ -42,6 +44,7 @@ public:
 
 	enum Opcode {
 		OPCODE_OPERATOR,
+		OPCODE_OPERATOR_TYPED, //operator specialized by the compiler for known operand types
 		OPCODE_EXTENDS_TEST,
 		OPCODE_SET,
 		OPCODE_GET,
@@ -70,6 +73,46 @@ public:
 		OPCODE_END
 	};
 
+	enum TypedOperator {
+		TYPED_INT_ADD,
+		TYPED_INT_SUBSTRACT,
+		TYPED_INT_MULTIPLY,
+		TYPED_INT_DIVIDE,
+		TYPED_INT_EQUAL,
+		TYPED_INT_NOT_EQUAL,
+		TYPED_INT_LESS,
+		TYPED_INT_LESS_EQUAL,
+		TYPED_INT_GREATER,
+		TYPED_INT_GREATER_EQUAL,
+		TYPED_REAL_ADD,
+		TYPED_REAL_SUBSTRACT,
+		TYPED_REAL_MULTIPLY,
+		TYPED_REAL_DIVIDE,
+		TYPED_REAL_EQUAL,
+		TYPED_REAL_NOT_EQUAL,
+		TYPED_REAL_LESS,
+		TYPED_REAL_LESS_EQUAL,
+		TYPED_REAL_GREATER,
+		TYPED_REAL_GREATER_EQUAL,
+		TYPED_VECTOR2_ADD,
+		TYPED_VECTOR2_SUBSTRACT,
+		TYPED_VECTOR2_MULTIPLY,
+		TYPED_VECTOR2_MULTIPLY_REAL,
+		TYPED_VECTOR3_ADD,
+		TYPED_VECTOR3_SUBSTRACT,
+		TYPED_VECTOR3_MULTIPLY,
+		TYPED_VECTOR3_MULTIPLY_REAL,
+		TYPED_MAX
+	};
+
+	struct TypedOperatorInfo {
+
+		Variant::Operator op;
+		Variant::Type type_a;
+		Variant::Type type_b;
+		Variant::Type result;
+	};
+
 	enum Address {
 		ADDR_BITS=24,
 		ADDR_MASK=((1<<ADDR_BITS)-1),
@@ -92,8 +135,56 @@ public:
         StringName identifier;
     };
 
+	//per call-site cache for OPCODE_CALL/OPCODE_GET_NAMED/OPCODE_SET_NAMED,
+	//keyed on the receiver's script (if any) and native type.
+	struct InlineCache {
+
+		enum {
+			MAX_ENTRIES=4 //polymorphic up to this, then the site goes megamorphic and is not cached
+		};
+
+		enum Kind {
+			KIND_SCRIPT_FUNCTION,
+			KIND_NATIVE_METHOD,
+			KIND_BUILTIN_METHOD,
+			KIND_MEMBER
+		};
+
+		struct Entry {
+
+			GDScript *script;
+			StringName type;
+			Kind kind;
+			GDFunction *function;
+			MethodBind *method;
+			int member;
+			Variant::Type builtin_type;
+			const Variant::BuiltinMethod *builtin;
+		};
+
+		uint32_t epoch;
+		int count;
+		Entry entries[MAX_ENTRIES];
+
+		InlineCache() { epoch=0; count=0; }
+	};
+
+	struct Profile {
+
+		StringName signature;
+		uint64_t call_count;
+		uint64_t self_time;
+		uint64_t total_time;
+		uint64_t frame_call_count;
+		uint64_t frame_self_time;
+		uint64_t frame_total_time;
+
+		Profile() { call_count=0; self_time=0; total_time=0; frame_call_count=0; frame_self_time=0; frame_total_time=0; }
+	};
+
 private:
 friend class GDCompiler;
+friend class GDScriptLanguage;
 
 	StringName source;
 
@@ -112,6 +203,8 @@ friend class GDCompiler;
 	int _initial_line;
 	bool _static;
 	GDScript *_script;
+	InlineCache *_cache_ptr;
+	int _cache_count;
 
 	StringName name;
 	Vector<Variant> constants;
@@ -119,12 +212,24 @@ friend class GDCompiler;
 	Vector<int> default_arguments;
 
 	Vector<int> code;
+	Vector<InlineCache> caches;
 
     List<StackDebug> stack_debug;
 
+	Profile profile;
+
 	_FORCE_INLINE_ Variant *_get_variant(int p_address,GDInstance *p_instance,GDScript *p_script,Variant &self,Variant *p_stack,String& r_error) const;
 	_FORCE_INLINE_ String _get_call_error(const Variant::CallError& p_err, const String& p_where,const Variant**argptrs) const;
 
+	_FORCE_INLINE_ Object *_get_cache_receiver(const Variant *p_base,GDInstance **r_instance) const;
+	bool _cached_builtin_call(int p_cache,const Variant *p_base,const StringName& p_method,const Variant **p_args,int p_argcount,Variant *r_ret,Variant::CallError& r_err);
+	bool _cached_call(int p_cache,const Variant *p_base,const StringName& p_method,const Variant **p_args,int p_argcount,Variant *r_ret,Variant::CallError& r_err);
+	bool _cached_get(int p_cache,const Variant *p_base,const StringName& p_name,Variant *r_ret);
+	bool _cached_set(int p_cache,const Variant *p_base,const StringName& p_name,const Variant& p_value);
+
+	static const TypedOperatorInfo typed_operator_info[TYPED_MAX];
+	static _FORCE_INLINE_ bool _evaluate_typed(int p_op,const Variant& p_a,const Variant& p_b,Variant& r_ret);
+
 
 public:
 
@@ -133,6 +238,10 @@ public:
 
 	const int* get_code() const; //used for debug
 	int get_code_size() const;
+	int get_inline_cache_count() const;
+
+	static const TypedOperatorInfo& get_typed_operator_info(int p_typed_op);
+	static int find_typed_operator(Variant::Operator p_op,Variant::Type p_type_a,Variant::Type p_type_b); //-1 if not specialized
 	Variant get_constant(int p_idx) const;
 	StringName get_global_name(int p_idx) const;
 	StringName get_name() const;
@@ -149,6 +258,7 @@ public:
 	Variant call(GDInstance *p_instance,const Variant **p_args, int p_argcount,Variant::CallError& r_err);
 
 	GDFunction();
+	~GDFunction();
 };
 
 
@@ -264,6 +374,7 @@ public:
 	virtual ScriptLanguage *get_language() const;
 
 	GDScript();
+	~GDScript();
 };
 
 class GDInstance : public ScriptInstance {
@@ -335,11 +446,25 @@ class GDScriptLanguage : public ScriptLanguage {
 
 	void _add_global(const StringName& p_name,const Variant& p_value);
 
+	uint32_t _inline_cache_epoch;
+
+	Mutex *lock;
+	Set<GDFunction*> function_list; //every compiled function, for the profiler
+	bool profiling;
+	uint64_t *_profile_callee_time; //where the running script function accumulates time spent in script calls (main thread only)
+
+friend class GDFunction;
 
 public:
 
 	int calls;
 
+	_FORCE_INLINE_ uint32_t get_inline_cache_epoch() const { return _inline_cache_epoch; }
+	_FORCE_INLINE_ void invalidate_inline_caches() { _inline_cache_epoch++; } //call whenever script functions or members may have moved
+
+	void profiling_add_function(GDFunction *p_function);
+	void profiling_remove_function(GDFunction *p_function);
+
     bool debug_break(const String& p_error,bool p_allow_continue=true);
     bool debug_break_parse(const String& p_file, int p_line,const String& p_error);
 
@@ -438,6 +563,14 @@ public:
 	virtual void frame();
 
 	virtual void get_public_functions(List<MethodInfo> *p_functions) const;
+
+	/* PROFILING FUNCTIONS */
+
+	virtual void profiling_start();
+	virtual void profiling_stop();
+	virtual bool is_profiling() const { return profiling; }
+	virtual int profiling_get_accumulated_data(ProfilingInfo *p_info_arr,int p_info_max);
+	virtual int profiling_get_frame_data(ProfilingInfo *p_info_arr,int p_info_max);
 	/* LOADER FUNCTIONS */
 
 	virtual void get_recognized_extensions(List<String> *p_extensions) const;
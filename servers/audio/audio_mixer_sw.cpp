@@ -35,6 +35,108 @@
 #define NO_REVERB
 #endif
 
+/* vector helpers for do_resample_simd, 4 floats per register */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+
+#include <emmintrin.h>
+#define AUDIO_MIXER_SIMD
+
+typedef __m128 MixVec;
+typedef __m128i MixVecInt;
+
+static _FORCE_INLINE_ MixVec _mix_vec_set(float p_v) { return _mm_set1_ps(p_v); }
+static _FORCE_INLINE_ MixVec _mix_vec_from_int(int32_t a, int32_t b, int32_t c, int32_t d) { return _mm_cvtepi32_ps(_mm_setr_epi32(a,b,c,d)); }
+static _FORCE_INLINE_ MixVec _mix_vec_add(MixVec a, MixVec b) { return _mm_add_ps(a,b); }
+static _FORCE_INLINE_ MixVec _mix_vec_mul(MixVec a, MixVec b) { return _mm_mul_ps(a,b); }
+static _FORCE_INLINE_ MixVec _mix_vec_clamp(MixVec a, MixVec p_min, MixVec p_max) { return _mm_min_ps(_mm_max_ps(a,p_min),p_max); }
+
+static _FORCE_INLINE_ MixVecInt _mix_vec_int_ramp(int32_t p_from, int32_t p_inc) { return _mm_set_epi32(p_from+p_inc*3,p_from+p_inc*2,p_from+p_inc,p_from); }
+static _FORCE_INLINE_ MixVecInt _mix_vec_int_set(int32_t p_v) { return _mm_set1_epi32(p_v); }
+static _FORCE_INLINE_ MixVecInt _mix_vec_int_add(MixVecInt a, MixVecInt b) { return _mm_add_epi32(a,b); }
+//fixed point to float, truncated like the scalar path
+template<int shift> static _FORCE_INLINE_ MixVec _mix_vec_int_shift(MixVecInt a) { return _mm_cvtepi32_ps(_mm_srai_epi32(a,shift)); }
+
+//interleave left/right and add 4 stereo frames to dst
+static _FORCE_INLINE_ void _mix_vec_accum_stereo(int32_t *p_dst, MixVec l, MixVec r) {
+
+	__m128i *d=(__m128i*)p_dst;
+	_mm_storeu_si128(d,_mm_add_epi32(_mm_loadu_si128(d),_mm_cvttps_epi32(_mm_unpacklo_ps(l,r))));
+	_mm_storeu_si128(d+1,_mm_add_epi32(_mm_loadu_si128(d+1),_mm_cvttps_epi32(_mm_unpackhi_ps(l,r))));
+}
+
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+
+#include <arm_neon.h>
+#define AUDIO_MIXER_SIMD
+
+typedef float32x4_t MixVec;
+typedef int32x4_t MixVecInt;
+
+static _FORCE_INLINE_ MixVec _mix_vec_set(float p_v) { return vdupq_n_f32(p_v); }
+static _FORCE_INLINE_ MixVec _mix_vec_from_int(int32_t a, int32_t b, int32_t c, int32_t d) {
+
+	int32x4_t v = vdupq_n_s32(a);
+	v=vsetq_lane_s32(b,v,1);
+	v=vsetq_lane_s32(c,v,2);
+	v=vsetq_lane_s32(d,v,3);
+	return vcvtq_f32_s32(v);
+}
+static _FORCE_INLINE_ MixVec _mix_vec_add(MixVec a, MixVec b) { return vaddq_f32(a,b); }
+static _FORCE_INLINE_ MixVec _mix_vec_mul(MixVec a, MixVec b) { return vmulq_f32(a,b); }
+static _FORCE_INLINE_ MixVec _mix_vec_clamp(MixVec a, MixVec p_min, MixVec p_max) { return vminq_f32(vmaxq_f32(a,p_min),p_max); }
+
+static _FORCE_INLINE_ MixVecInt _mix_vec_int_ramp(int32_t p_from, int32_t p_inc) { int32_t v[4]={p_from,p_from+p_inc,p_from+p_inc*2,p_from+p_inc*3}; return vld1q_s32(v); }
+static _FORCE_INLINE_ MixVecInt _mix_vec_int_set(int32_t p_v) { return vdupq_n_s32(p_v); }
+static _FORCE_INLINE_ MixVecInt _mix_vec_int_add(MixVecInt a, MixVecInt b) { return vaddq_s32(a,b); }
+template<int shift> static _FORCE_INLINE_ MixVec _mix_vec_int_shift(MixVecInt a) { return vcvtq_f32_s32(vshrq_n_s32(a,shift)); }
+
+static _FORCE_INLINE_ void _mix_vec_accum_stereo(int32_t *p_dst, MixVec l, MixVec r) {
+
+	float32x4x2_t lr = vzipq_f32(l,r);
+	vst1q_s32(p_dst,vaddq_s32(vld1q_s32(p_dst),vcvtq_s32_f32(lr.val[0])));
+	vst1q_s32(p_dst+4,vaddq_s32(vld1q_s32(p_dst+4),vcvtq_s32_f32(lr.val[1])));
+}
+
+#endif
+
+#ifdef AUDIO_MIXER_SIMD
+
+//fetch and interpolate one frame in fixed point, as do_resample does
+template<class Depth,bool is_stereo,bool linear,int frac_bits>
+static _FORCE_INLINE_ void _mix_fetch_frame(const Depth* p_src, int32_t p_pos, int32_t &r_l, int32_t &r_r) {
+
+	int32_t idx=p_pos >> frac_bits;
+	if (is_stereo)
+		idx<<=1;
+
+	int32_t l=p_src[idx];
+	int32_t r=is_stereo?p_src[idx+1]:0;
+	if (sizeof(Depth)==1) {
+		l<<=8;
+		r<<=8;
+	}
+
+	if (linear) {
+
+		int32_t next_l=p_src[idx+(is_stereo?2:1)];
+		int32_t next_r=is_stereo?p_src[idx+3]:0;
+		if (sizeof(Depth)==1) {
+			next_l<<=8;
+			next_r<<=8;
+		}
+		int32_t frac=p_pos&((1<<frac_bits)-1);
+		l=l+((next_l-l)*frac >> frac_bits);
+		if (is_stereo)
+			r=r+((next_r-r)*frac >> frac_bits);
+	}
+
+	r_l=l;
+	r_r=is_stereo?r:l;
+}
+
+#endif
+
 template<class Depth,bool is_stereo,bool use_filter,bool use_fx,AudioMixerSW::InterpolationType type,AudioMixerSW::MixChannels mix_mode>
 void AudioMixerSW::do_resample(const Depth* p_src, int32_t *p_dst, ResamplerState *p_state) {
 
@@ -169,8 +271,91 @@ void AudioMixerSW::do_resample(const Depth* p_src, int32_t *p_dst, ResamplerStat
 	}
 }
 
+#ifdef AUDIO_MIXER_SIMD
+
+template<class Depth,bool is_stereo,bool use_fx,AudioMixerSW::InterpolationType type>
+void AudioMixerSW::do_resample_simd(const Depth* p_src, int32_t *p_dst, ResamplerState *p_state) {
+
+	// same as do_resample, 4 frames at a time. Samples are fetched and
+	// interpolated in fixed point, volume is applied in float. Each block is
+	// converted (saturated) to int before being added to the buffer, so the
+	// result does not depend on the order voices are mixed in.
+
+	int blocks = p_state->amount>>2;
+	int32_t *reverb_dst = p_state->reverb_buffer;
+
+	if (blocks) {
+
+		const MixVec out_scale = _mix_vec_set(1.0/float(1<<MIX_VOL_MOVE_TO_24));
+		const MixVec sat_min = _mix_vec_set(-2147483520.0);
+		const MixVec sat_max = _mix_vec_set(2147483520.0);
+
+		// volumes ramp in fixed point, exactly like the scalar path
+		MixVecInt vol[2],vol_step[2],rvol[2],rvol_step[2];
+		for(int i=0;i<2;i++) {
+			vol[i]=_mix_vec_int_ramp(p_state->vol[i],p_state->vol_inc[i]);
+			vol_step[i]=_mix_vec_int_set(p_state->vol_inc[i]<<2);
+			if (use_fx) {
+				rvol[i]=_mix_vec_int_ramp(p_state->reverb_vol[i],p_state->reverb_vol_inc[i]);
+				rvol_step[i]=_mix_vec_int_set(p_state->reverb_vol_inc[i]<<2);
+			}
+		}
+
+		int32_t pos=p_state->pos;
+		const int32_t increment=p_state->increment;
+
+		for(int b=0;b<blocks;b++) {
 
-void AudioMixerSW::mix_channel(Channel& c) {
+			int32_t l0,r0,l1,r1,l2,r2,l3,r3;
+			_mix_fetch_frame<Depth,is_stereo,type==INTERPOLATION_LINEAR,MIX_FRAC_BITS>(p_src,pos,l0,r0);
+			_mix_fetch_frame<Depth,is_stereo,type==INTERPOLATION_LINEAR,MIX_FRAC_BITS>(p_src,pos+increment,l1,r1);
+			_mix_fetch_frame<Depth,is_stereo,type==INTERPOLATION_LINEAR,MIX_FRAC_BITS>(p_src,pos+increment*2,l2,r2);
+			_mix_fetch_frame<Depth,is_stereo,type==INTERPOLATION_LINEAR,MIX_FRAC_BITS>(p_src,pos+increment*3,l3,r3);
+			pos+=increment*4;
+
+			MixVec l = _mix_vec_mul(_mix_vec_from_int(l0,l1,l2,l3),out_scale);
+			MixVec r = is_stereo ? _mix_vec_mul(_mix_vec_from_int(r0,r1,r2,r3),out_scale) : l;
+
+			_mix_vec_accum_stereo(p_dst,
+				_mix_vec_clamp(_mix_vec_mul(l,_mix_vec_int_shift<MIX_VOLRAMP_FRAC_BITS>(vol[0])),sat_min,sat_max),
+				_mix_vec_clamp(_mix_vec_mul(r,_mix_vec_int_shift<MIX_VOLRAMP_FRAC_BITS>(vol[1])),sat_min,sat_max));
+			p_dst+=8;
+			vol[0]=_mix_vec_int_add(vol[0],vol_step[0]);
+			vol[1]=_mix_vec_int_add(vol[1],vol_step[1]);
+
+			if (use_fx) {
+				_mix_vec_accum_stereo(reverb_dst,
+					_mix_vec_clamp(_mix_vec_mul(l,_mix_vec_int_shift<MIX_VOLRAMP_FRAC_BITS>(rvol[0])),sat_min,sat_max),
+					_mix_vec_clamp(_mix_vec_mul(r,_mix_vec_int_shift<MIX_VOLRAMP_FRAC_BITS>(rvol[1])),sat_min,sat_max));
+				reverb_dst+=8;
+				rvol[0]=_mix_vec_int_add(rvol[0],rvol_step[0]);
+				rvol[1]=_mix_vec_int_add(rvol[1],rvol_step[1]);
+			}
+		}
+
+		int frames=blocks<<2;
+		p_state->pos=pos;
+		p_state->amount-=frames;
+		for(int i=0;i<2;i++) {
+			p_state->vol[i]+=p_state->vol_inc[i]*frames;
+			if (use_fx)
+				p_state->reverb_vol[i]+=p_state->reverb_vol_inc[i]*frames;
+		}
+	}
+
+	if (p_state->amount>0) {
+		//leftover frames
+		int32_t *reverb_buffer = p_state->reverb_buffer;
+		p_state->reverb_buffer=reverb_dst;
+		do_resample<Depth,is_stereo,false,use_fx,type,MIX_STEREO>(p_src,p_dst,p_state);
+		p_state->reverb_buffer=reverb_buffer;
+	}
+}
+
+#endif
+
+
+void AudioMixerSW::mix_channel(Channel& c,MixTarget& p_target) {
 
 
 	if (!sample_manager->is_sample(c.sample)) {
@@ -301,10 +486,10 @@ void AudioMixerSW::mix_channel(Channel& c) {
 	/* audio data */
 
 	const void *data=sample_manager->sample_get_data_ptr(c.sample);
-	int32_t *dst_buff=mix_buffer;
+	int32_t *dst_buff=p_target.buffer;
 
 #ifndef NO_REVERB
-	rstate.reverb_buffer=reverb_state[c.reverb_room].buffer;
+	rstate.reverb_buffer=p_target.reverb_buffer[c.reverb_room];
 #endif
 
 	/* @TODO validar loops al registrar? */
@@ -440,6 +625,50 @@ void AudioMixerSW::mix_channel(Channel& c) {
 
 
 
+#ifdef AUDIO_MIXER_SIMD
+
+/* vector path has no filter or quad output, cubic is not implemented by either path so it maps to raw */
+
+#define CALL_RESAMPLE_SIMD_FUNC( m_depth, m_stereo, m_use_fx, m_interp)\
+	do_resample_simd<m_depth,m_stereo,m_use_fx,m_interp>(\
+		src_ptr,\
+		dst_buff,&rstate);
+
+#define CALL_RESAMPLE_SIMD_INTERP( m_depth, m_stereo, m_use_fx, m_interp)\
+	if(m_interp==INTERPOLATION_LINEAR) {\
+		CALL_RESAMPLE_SIMD_FUNC(m_depth,m_stereo,m_use_fx,INTERPOLATION_LINEAR);\
+	} else {\
+		CALL_RESAMPLE_SIMD_FUNC(m_depth,m_stereo,m_use_fx,INTERPOLATION_RAW);\
+	}\
+
+#define CALL_RESAMPLE_SIMD_FX( m_depth, m_stereo, m_use_fx, m_interp)\
+	if(m_use_fx) {\
+		CALL_RESAMPLE_SIMD_INTERP(m_depth,m_stereo,true,m_interp);\
+	} else {\
+		CALL_RESAMPLE_SIMD_INTERP(m_depth,m_stereo,false,m_interp);\
+	}\
+
+#define CALL_RESAMPLE_SIMD_STEREO( m_depth, m_stereo, m_use_fx, m_interp)\
+	if(m_stereo) {\
+		CALL_RESAMPLE_SIMD_FX(m_depth,true,m_use_fx,m_interp);\
+	} else {\
+		CALL_RESAMPLE_SIMD_FX(m_depth,false,m_use_fx,m_interp);\
+	}\
+
+		if (simd_enabled && !use_filter && mix_channels==MIX_STEREO) {
+
+			if (format==AS::SAMPLE_FORMAT_PCM8) {
+
+				int8_t *src_ptr =  &((int8_t*)data)[(c.mix.offset >> MIX_FRAC_BITS)<<(is_stereo?1:0) ];
+				CALL_RESAMPLE_SIMD_STEREO(int8_t,is_stereo,use_fx,interpolation_type);
+
+			} else if (format==AS::SAMPLE_FORMAT_PCM16) {
+				int16_t *src_ptr =  &((int16_t*)data)[(c.mix.offset >> MIX_FRAC_BITS)<<(is_stereo?1:0) ];
+				CALL_RESAMPLE_SIMD_STEREO(int16_t,is_stereo,use_fx,interpolation_type);
+
+			}
+		} else
+#endif
 		if (format==AS::SAMPLE_FORMAT_PCM8) {
 
 			int8_t *src_ptr =  &((int8_t*)data)[(c.mix.offset >> MIX_FRAC_BITS)<<(is_stereo?1:0) ];
@@ -472,49 +701,62 @@ void AudioMixerSW::mix_chunk() {
 	}
 #ifndef NO_REVERB
 	for(int i=0;i<max_reverbs;i++)
-		reverb_state[i].used_in_chunk=false;
+		mix_targets[0].reverb_used[i]=false;
 #endif
 
-
 	audio_mixer_chunk_call(mix_chunk_size);
 
-	int ac=0;
+	active_channel_count=0;
 	for (int i=0;i<MAX_CHANNELS;i++) {
 
-		if (!channels[i].active)
-			continue;
-		ac++;
+		if (channels[i].active)
+			active_channels[active_channel_count++]=i;
+	}
 
-		/* process volume */
-		Channel&c=channels[i];
-#ifndef NO_REVERB
-		bool has_reverb = c.reverb_send>CMP_EPSILON && fx_enabled;
-		if (has_reverb || c.had_prev_reverb) {
+	mix_partitions=MIN(mix_target_count,active_channel_count/MIX_VOICES_PER_PARTITION);
 
-			if (!reverb_state[c.reverb_room].used_in_chunk) {
-				//zero the room
-				int32_t *buff = reverb_state[c.reverb_room].buffer;
-				int len = mix_chunk_size*mix_channels;
-				for (int j=0;j<len;j++) {
+	if (mix_partitions>1) {
 
-					buff[j]=0; // buffer in use, clear it for appending
-				}
-				reverb_state[c.reverb_room].used_in_chunk=true;
-			}
-		}
-#else
-		bool has_reverb = false;
-#endif
-		bool has_chorus = c.chorus_send>CMP_EPSILON && fx_enabled;
+		mix_pool.do_work(mix_partitions,_mix_partition_work,this);
 
+		// sum the partitions, integer adds so the order does not change the result
+		int len = mix_chunk_size*mix_channels;
+		MixTarget &main = mix_targets[0];
+		for(int p=1;p<mix_partitions;p++) {
 
-		mix_channel(c);
+			const MixTarget &t = mix_targets[p];
+			for(int i=0;i<len;i++)
+				main.buffer[i]+=t.buffer[i];
 
-		c.had_prev_reverb=has_reverb;
-		c.had_prev_chorus=has_chorus;
+#ifndef NO_REVERB
+			for(int r=0;r<max_reverbs;r++) {
+
+				if (!t.reverb_used[r])
+					continue;
+				int32_t *dst=main.reverb_buffer[r];
+				const int32_t *src=t.reverb_buffer[r];
+				if (main.reverb_used[r]) {
+					for(int i=0;i<len;i++)
+						dst[i]+=src[i];
+				} else {
+					for(int i=0;i<len;i++)
+						dst[i]=src[i];
+					main.reverb_used[r]=true;
+				}
+			}
+#endif
+		}
+	} else {
 
+		mix_partitions=1;
+		_mix_partition(0);
 	}
 
+#ifndef NO_REVERB
+	for(int i=0;i<max_reverbs;i++)
+		reverb_state[i].used_in_chunk=mix_targets[0].reverb_used[i];
+#endif
+
 	//process reverb
 #ifndef NO_REVERB
 	if (fx_enabled) {
@@ -563,6 +805,61 @@ void AudioMixerSW::mix_chunk() {
 	inside_mix=false;
 }
 
+void AudioMixerSW::_mix_partition(int p_partition) {
+
+	MixTarget &t = mix_targets[p_partition];
+	int len = mix_chunk_size*mix_channels;
+
+	if (p_partition>0) {
+		//partition 0 uses mix_buffer, which was cleared by mix_chunk
+		for (int i=0;i<len;i++) {
+
+			t.buffer[i]=0;
+		}
+#ifndef NO_REVERB
+		for(int i=0;i<max_reverbs;i++)
+			t.reverb_used[i]=false;
+#endif
+	}
+
+	for (int i=p_partition;i<active_channel_count;i+=mix_partitions) {
+
+		/* process volume */
+		Channel&c=channels[active_channels[i]];
+#ifndef NO_REVERB
+		bool has_reverb = c.reverb_send>CMP_EPSILON && fx_enabled;
+		if (has_reverb || c.had_prev_reverb) {
+
+			if (!t.reverb_used[c.reverb_room]) {
+				//zero the room
+				int32_t *buff = t.reverb_buffer[c.reverb_room];
+				for (int j=0;j<len;j++) {
+
+					buff[j]=0; // buffer in use, clear it for appending
+				}
+				t.reverb_used[c.reverb_room]=true;
+			}
+		}
+#else
+		bool has_reverb = false;
+#endif
+		bool has_chorus = c.chorus_send>CMP_EPSILON && fx_enabled;
+
+
+		mix_channel(c,t);
+
+		c.had_prev_reverb=has_reverb;
+		c.had_prev_chorus=has_chorus;
+
+	}
+}
+
+void AudioMixerSW::_mix_partition_work(void *p_userdata,int p_index) {
+
+	AudioMixerSW *self=(AudioMixerSW*)p_userdata;
+	self->_mix_partition(p_index);
+}
+
 int AudioMixerSW::mix(int32_t *p_buffer,int p_frames) {
 
 	int todo=p_frames;
@@ -999,7 +1296,7 @@ void AudioMixerSW::channel_free(ChannelID p_channel) {
 		c.vol=0;
 		c.reverb_send=0;
 		c.chorus_send=0;
-		mix_channel(c);
+		mix_channel(c,mix_targets[0]);
 	}
 	/* @TODO RAMP DOWN ON STOP */
 	c.active=false;
@@ -1060,7 +1357,13 @@ AudioMixerSW::AudioMixerSW(SampleManagerSW *p_sample_manager,int p_desired_laten
 	channel_id_count=1;
 	inside_mix=false;
 	channel_nrg=1.0;
+	simd_enabled=has_simd();
 
+	mix_targets=NULL;
+	mix_target_count=0;
+	mix_partitions=1;
+	active_channel_count=0;
+	set_mix_threads(0);
 }
 
 void AudioMixerSW::set_mixer_volume(float p_volume) {
@@ -1068,8 +1371,85 @@ void AudioMixerSW::set_mixer_volume(float p_volume) {
 	channel_nrg=p_volume;
 }
 
+bool AudioMixerSW::has_simd() {
+
+#ifdef AUDIO_MIXER_SIMD
+	return true;
+#else
+	return false;
+#endif
+}
+
+void AudioMixerSW::set_simd_enabled(bool p_enabled) {
+
+	simd_enabled=p_enabled && has_simd();
+}
+
+bool AudioMixerSW::is_simd_enabled() const {
+
+	return simd_enabled;
+}
+
+void AudioMixerSW::_free_mix_targets() {
+
+	if (!mix_targets)
+		return;
+
+	for(int i=1;i<mix_target_count;i++) {
+
+		memdelete_arr(mix_targets[i].buffer);
+#ifndef NO_REVERB
+		for(int j=0;j<max_reverbs;j++)
+			memdelete_arr(mix_targets[i].reverb_buffer[j]);
+#endif
+	}
+	memdelete_arr(mix_targets);
+	mix_targets=NULL;
+	mix_target_count=0;
+}
+
+void AudioMixerSW::set_mix_threads(int p_threads) {
+
+	ERR_FAIL_COND(inside_mix);
+
+	_free_mix_targets();
+	mix_pool.finish();
+
+	if (p_threads<0)
+		p_threads=OS::get_singleton()->get_processor_count()-1;
+	// more partitions than this would never get enough voices
+	p_threads=MIN(p_threads,MAX_CHANNELS/MIX_VOICES_PER_PARTITION-1);
+	mix_pool.init(p_threads);
+
+	mix_target_count=mix_pool.get_thread_count()+1;
+	mix_targets=memnew_arr(MixTarget,mix_target_count);
+
+	int len=mix_chunk_size*mix_channels;
+	for(int i=0;i<mix_target_count;i++) {
+
+		MixTarget &t=mix_targets[i];
+		t.buffer = i==0 ? mix_buffer : memnew_arr(int32_t,len);
+		for(int j=0;j<MAX_REVERBS;j++) {
+			t.reverb_buffer[j]=NULL;
+			t.reverb_used[j]=false;
+		}
+#ifndef NO_REVERB
+		for(int j=0;j<max_reverbs;j++)
+			t.reverb_buffer[j] = i==0 ? reverb_state[j].buffer : memnew_arr(int32_t,len);
+#endif
+	}
+}
+
+int AudioMixerSW::get_mix_threads() const {
+
+	return mix_pool.get_thread_count();
+}
+
 AudioMixerSW::~AudioMixerSW() {
 
+	mix_pool.finish();
+	_free_mix_targets();
+
 	memdelete_arr(mix_buffer);
 
 #ifndef NO_REVERB
@@ -33,6 +33,7 @@
 #include "servers/audio/sample_manager_sw.h"
 #include "servers/audio/audio_filter_sw.h"
 #include "servers/audio/reverb_sw.h"
+#include "os/thread_work_pool.h"
 
 class AudioMixerSW : public AudioMixer {
 public:
@@ -70,7 +71,8 @@ private:
 		MIX_FILTER_FRAC_BITS=16,
 		MIX_FILTER_RAMP_FRAC_BITS=8,
 		MIX_VOL_MOVE_TO_24=4,
-		MAX_REVERBS=4
+		MAX_REVERBS=4,
+		MIX_VOICES_PER_PARTITION=8 // fewer voices than this per thread are not worth splitting
 	};
 
 	struct Channel {
@@ -176,9 +178,34 @@ private:
 	template<class Depth,bool is_stereo,bool use_filter,bool use_fx,InterpolationType type,MixChannels>
 	_FORCE_INLINE_ void do_resample(const Depth* p_src, int32_t *p_dst, ResamplerState *p_state);
 
+	// 4 frames per step, stereo output without filter only
+	template<class Depth,bool is_stereo,bool use_fx,InterpolationType type>
+	void do_resample_simd(const Depth* p_src, int32_t *p_dst, ResamplerState *p_state);
+	bool simd_enabled;
+
 	MixChannels mix_channels;
 
-	void mix_channel(Channel& p_channel);
+	// voices are split in partitions, each mixed into its own buffers and
+	// summed afterwards. Partition 0 mixes straight into mix_buffer.
+	struct MixTarget {
+
+		int32_t *buffer;
+		int32_t *reverb_buffer[MAX_REVERBS];
+		bool reverb_used[MAX_REVERBS];
+	};
+
+	MixTarget *mix_targets;
+	int mix_target_count;
+	int mix_partitions;
+	int active_channels[MAX_CHANNELS];
+	int active_channel_count;
+	ThreadWorkPool mix_pool;
+
+	void _mix_partition(int p_partition);
+	static void _mix_partition_work(void *p_userdata,int p_index);
+	void _free_mix_targets();
+
+	void mix_channel(Channel& p_channel,MixTarget& p_target);
 	int mix_chunk_left;
 	void mix_chunk();	
 
@@ -241,6 +268,13 @@ public:
 
 	virtual void set_mixer_volume(float p_volume);
 
+	void set_mix_threads(int p_threads); // extra threads used to mix voices, -1 for one per extra core
+	int get_mix_threads() const;
+
+	static bool has_simd();
+	void set_simd_enabled(bool p_enabled); // has no effect if has_simd() is false
+	bool is_simd_enabled() const;
+
 	AudioMixerSW(SampleManagerSW *p_sample_manager,int p_desired_latency_ms,int p_mix_rate,MixChannels p_mix_channels,bool p_use_fx=true,InterpolationType p_interp=INTERPOLATION_LINEAR,MixStepCallback p_step_callback=NULL,void *p_callback_udata=NULL);
 	~AudioMixerSW();
 };
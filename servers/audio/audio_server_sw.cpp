@@ -29,6 +29,7 @@
 #include "audio_server_sw.h"
 #include "globals.h"
 #include "os/os.h"
+#include "safe_refcount.h"
 
 struct _AudioDriverLock {
 
@@ -213,7 +214,10 @@ void AudioServerSW::driver_process_chunk(int p_frames,int32_t *p_buffer) {
 		int channels=as->get_channel_count();
 		if (channels==0)
 			continue; // does not want mix
-		if (!as->mix(stream_buffer,p_frames))
+		bool mixed=as->mix(stream_buffer,p_frames);
+		if (as->can_update_mt())
+			_check_stream_buffer(E->get(),mixed);
+		if (!mixed)
 			continue; //nothing was mixed!!
 
 		int32_t stream_vol_scale=(stream_volume*stream_volume_scale*E->get()->volume_scale)*(1<<STREAM_SCALE_BITS);
@@ -664,6 +668,7 @@ RID AudioServerSW::audio_stream_create(AudioStream *p_stream) {
 	s->active=false;
 	s->E=NULL;
 	s->volume_scale=1.0;
+	s->underruns=p_stream->get_underrun_count();
 	p_stream->set_mix_rate(AudioDriverSW::get_singleton()->get_mix_rate());
 
 	return stream_owner.make_rid(s);
@@ -678,6 +683,7 @@ RID AudioServerSW::event_stream_create(EventStream *p_stream) {
 	s->active=false;
 	s->E=NULL;
 	s->volume_scale=1.0;
+	s->underruns=0;
 	//p_stream->set_mix_rate(AudioDriverSW::get_singleton()->get_mix_rate());
 
 	return stream_owner.make_rid(s);
@@ -765,12 +771,45 @@ void AudioServerSW::_thread_func(void *self) {
 	AudioServerSW *as=(AudioServerSW *)self;
 
 	while (!as->exit_update_thread) {
-		as->_update_streams(true);
-		OS::get_singleton()->delay_usec(5000);
+
+		if (as->stream_update_sem) {
+			as->stream_update_sem->wait();
+			if (as->exit_update_thread)
+				break;
+			// clear before updating, so streams running low meanwhile wake us again
+			atomic_exchange(&as->stream_update_pending,0);
+			as->_update_streams(true);
+		} else {
+			//no semaphores on this platform, poll
+			as->_update_streams(true);
+			OS::get_singleton()->delay_usec(5000);
+		}
 	}
 
 }
 
+void AudioServerSW::_check_stream_buffer(Stream *p_stream,bool p_mixed) {
+
+	//called from the mix thread
+	AudioStream *as=p_stream->audio_stream;
+
+	uint32_t underruns=as->get_underrun_count();
+	bool underrun=underruns!=p_stream->underruns;
+	if (underrun) {
+		atomic_add(&stream_underruns,underruns-p_stream->underruns);
+		p_stream->underruns=underruns;
+	} else if (!p_mixed) {
+		return; // stopped or paused, nothing was consumed
+	}
+
+	int buffered=as->get_buffered_usec();
+	if (buffered>=0 && buffered>as->get_buffer_length_usec()*stream_low_watermark)
+		return; // enough audio left
+
+	if (stream_update_sem && atomic_exchange(&stream_update_pending,1)==0)
+		stream_update_sem->post();
+}
+
 void AudioServerSW::init() {
 
 	int latency = GLOBAL_DEF("audio/mixer_latency",10);
@@ -792,6 +831,8 @@ void AudioServerSW::init() {
 	}
 
 	mixer = memnew( AudioMixerSW( sample_manager, latency, AudioDriverSW::get_singleton()->get_mix_rate(),mix_chans,mixer_use_fx,mixer_interp,_mixer_callback,this ) );
+	mixer->set_simd_enabled(GLOBAL_DEF("audio/mixer_simd",true));
+	mixer->set_mix_threads(GLOBAL_DEF("audio/mixer_threads",-1));
 	mixer_step_usecs=mixer->get_step_usecs();
 
 	stream_volume=0.3;
@@ -800,6 +841,8 @@ void AudioServerSW::init() {
 		AudioDriverSW::get_singleton()->start();
 
 #ifndef NO_THREADS
+	stream_update_pool.init(GLOBAL_DEF("audio/stream_decode_threads",1));
+	stream_update_sem = Semaphore::create();
 	exit_update_thread=false;
 	thread = Thread::create(_thread_func,this);
 #endif
@@ -810,8 +853,15 @@ void AudioServerSW::finish() {
 
 #ifndef NO_THREADS
 	exit_update_thread=true;
+	if (stream_update_sem)
+		stream_update_sem->post();
 	Thread::wait_to_finish(thread);
 	memdelete(thread);
+	if (stream_update_sem) {
+		memdelete(stream_update_sem);
+		stream_update_sem=NULL;
+	}
+	stream_update_pool.finish();
 #endif
 
 	if (AudioDriverSW::get_singleton())
@@ -823,13 +873,40 @@ void AudioServerSW::finish() {
 
 }
 
+void AudioServerSW::_stream_update_work(void *p_userdata,int p_index) {
+
+	const AudioServerSW *self=(const AudioServerSW*)p_userdata;
+	self->stream_update_work[p_index].stream->update();
+}
+
 void AudioServerSW::_update_streams(bool p_thread) {
 
 	_THREAD_SAFE_METHOD_
+
+	stream_update_work.clear();
 	for(List<Stream*>::Element *E=active_audio_streams.front();E;E=E->next()) {
 
-		if (E->get()->audio_stream && p_thread == E->get()->audio_stream->can_update_mt())
-			E->get()->audio_stream->update();
+		AudioStream *as=E->get()->audio_stream;
+		if (!as || p_thread != as->can_update_mt())
+			continue;
+
+		StreamUpdate su;
+		su.stream=as;
+		su.buffered_usec=MAX(as->get_buffered_usec(),0);
+		stream_update_work.push_back(su);
+	}
+
+	if (stream_update_work.empty())
+		return;
+
+	// streams closest to running out decode first
+	stream_update_work.sort();
+
+	if (p_thread && stream_update_work.size()>1 && stream_update_pool.get_thread_count()>0) {
+		stream_update_pool.do_work(stream_update_work.size(),_stream_update_work,this);
+	} else {
+		for(int i=0;i<stream_update_work.size();i++)
+			stream_update_work[i].stream->update();
 	}
 
 }
@@ -915,6 +992,11 @@ double AudioServerSW::get_mix_time() const {
 	return AudioDriverSW::get_singleton()->get_mix_time();
 }
 
+uint32_t AudioServerSW::get_stream_underrun_count() const {
+
+	return stream_underruns;
+}
+
 uint32_t AudioServerSW::read_output_peak() const {
 
 	uint32_t val = max_peak;
@@ -938,7 +1020,11 @@ AudioServerSW::AudioServerSW(SampleManagerSW *p_sample_manager) {
 	stream_volume_scale=GLOBAL_DEF("audio/stream_volume_scale",1.0);
 	fx_volume_scale=GLOBAL_DEF("audio/fx_volume_scale",1.0);
 	event_voice_volume_scale=GLOBAL_DEF("audio/event_voice_volume_scale",0.5);
+	stream_low_watermark=GLOBAL_DEF("audio/stream_low_watermark",0.5); // fraction of the stream buffer
 	max_peak=0;
+	stream_update_sem=NULL;
+	stream_update_pending=0;
+	stream_underruns=0;
 
 
 }
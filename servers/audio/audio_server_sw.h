@@ -35,6 +35,8 @@
 #include "self_list.h"
 #include "os/thread_safe.h"
 #include "os/thread.h"
+#include "os/semaphore.h"
+#include "os/thread_work_pool.h"
 class AudioServerSW : public AudioServer {
 
 	OBJ_TYPE( AudioServerSW, AudioServer );
@@ -73,6 +75,7 @@ class AudioServerSW : public AudioServer {
 		AudioStream *audio_stream;
 		EventStream *event_stream;
 		float volume_scale;
+		uint32_t underruns; // last count seen from audio_stream
 	};
 
 	List<Stream*> active_audio_streams;
@@ -98,6 +101,24 @@ class AudioServerSW : public AudioServer {
 	Thread *thread;
 	static void _thread_func(void *self);
 
+	// the update thread sleeps until the mix finds a stream running low
+	Semaphore *stream_update_sem;
+	volatile uint32_t stream_update_pending;
+	float stream_low_watermark;
+	volatile uint32_t stream_underruns;
+
+	struct StreamUpdate {
+
+		int buffered_usec;
+		AudioStream *stream;
+		bool operator<(const StreamUpdate& p_b) const { return buffered_usec<p_b.buffered_usec; }
+	};
+
+	Vector<StreamUpdate> stream_update_work;
+	ThreadWorkPool stream_update_pool;
+	static void _stream_update_work(void *p_userdata,int p_index);
+
+	void _check_stream_buffer(Stream *p_stream,bool p_mixed);
 	void _update_streams(bool p_thread);
 	void driver_process_chunk(int p_frames,int32_t *p_buffer);
 
@@ -203,6 +224,7 @@ public:
 	virtual float get_event_voice_global_volume_scale() const;
 
 	virtual uint32_t read_output_peak() const;
+	virtual uint32_t get_stream_underrun_count() const;
 
 	virtual double get_mix_time() const; //useful for video -> audio sync
 
@@ -137,6 +137,10 @@ public:
 		virtual bool mix(int32_t *p_buffer,int p_frames)=0;
 		virtual void update()=0;
 		virtual bool can_update_mt() const { return true; }
+		//buffered streams report their fill level, so they are only updated when running low
+		virtual int get_buffered_usec() const { return -1; } ///< -1 if not buffered
+		virtual int get_buffer_length_usec() const { return -1; }
+		virtual uint32_t get_underrun_count() const { return 0; }
 		virtual ~AudioStream() {}
 	};
 
@@ -270,6 +274,7 @@ public:
 	virtual float get_event_voice_global_volume_scale() const=0;
 
 	virtual uint32_t read_output_peak() const=0;
+	virtual uint32_t get_stream_underrun_count() const=0;
 
 	static AudioServer *get_singleton();
 
@@ -305,6 +305,10 @@ void BodyPairSW::solve(float p_step) {
 	if (!collided)
 		return;
 
+	// static and kinematic bodies take no impulses. skipping them also means islands
+	// solved in parallel only read the static bodies they share
+	bool dynamic_A=A->get_inv_mass()!=0;
+	bool dynamic_B=B->get_inv_mass()!=0;
 
 	for(int i=0;i<contact_count;i++) {
 
@@ -331,8 +335,10 @@ void BodyPairSW::solve(float p_step) {
 			Vector3 jb = c.normal * (c.acc_bias_impulse - jbnOld);
 
 
-			A->apply_bias_impulse(c.rA,-jb);
-			B->apply_bias_impulse(c.rB, jb);
+			if (dynamic_A)
+				A->apply_bias_impulse(c.rA,-jb);
+			if (dynamic_B)
+				B->apply_bias_impulse(c.rB, jb);
 
 			c.active=true;
 		}
@@ -356,8 +362,10 @@ void BodyPairSW::solve(float p_step) {
 			Vector3 j =c.normal * (c.acc_normal_impulse - jnOld);
 
 
-			A->apply_impulse(c.rA,-j);
-			B->apply_impulse(c.rB, j);
+			if (dynamic_A)
+				A->apply_impulse(c.rA,-j);
+			if (dynamic_B)
+				B->apply_impulse(c.rB, j);
 
 			c.active=true;
 		}
@@ -403,8 +411,10 @@ void BodyPairSW::solve(float p_step) {
 			jt = c.acc_tangent_impulse - jtOld;
 
 
-			A->apply_impulse( c.rA, -jt );
-			B->apply_impulse( c.rB, jt );
+			if (dynamic_A)
+				A->apply_impulse( c.rA, -jt );
+			if (dynamic_B)
+				B->apply_impulse( c.rB, jt );
 
 			c.active=true;
 
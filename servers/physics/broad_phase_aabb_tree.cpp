@@ -0,0 +1,706 @@
+/*************************************************************************/
+/*  broad_phase_aabb_tree.cpp                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "broad_phase_aabb_tree.h"
+
+static _FORCE_INLINE_ AABB _aabb_merge(const AABB& p_a,const AABB& p_b) {
+
+	Vector3 min( MIN(p_a.pos.x,p_b.pos.x), MIN(p_a.pos.y,p_b.pos.y), MIN(p_a.pos.z,p_b.pos.z) );
+	Vector3 max( MAX(p_a.pos.x+p_a.size.x,p_b.pos.x+p_b.size.x), MAX(p_a.pos.y+p_a.size.y,p_b.pos.y+p_b.size.y), MAX(p_a.pos.z+p_a.size.z,p_b.pos.z+p_b.size.z) );
+	return AABB(min,max-min);
+}
+
+static _FORCE_INLINE_ real_t _aabb_cost(const AABB& p_aabb) {
+
+	//surface area, the probability of a random ray or box hitting it
+	return p_aabb.size.x*p_aabb.size.y + p_aabb.size.y*p_aabb.size.z + p_aabb.size.z*p_aabb.size.x;
+}
+
+/* TREE */
+
+int BroadPhaseAABBTree::Tree::_alloc_node() {
+
+	if (free_node==-1) {
+
+		int new_capacity = node_capacity ? node_capacity*2 : 64;
+		nodes = (Node*)memrealloc(nodes,sizeof(Node)*new_capacity);
+		for(int i=node_capacity;i<new_capacity;i++) {
+			nodes[i].parent = (i+1<new_capacity) ? i+1 : -1;
+		}
+		free_node=node_capacity;
+		node_capacity=new_capacity;
+	}
+
+	int node = free_node;
+	free_node=nodes[node].parent;
+
+	Node &n=nodes[node];
+	n.parent=-1;
+	n.children[0]=-1;
+	n.children[1]=-1;
+	n.height=0;
+	n.element=0;
+	return node;
+}
+
+void BroadPhaseAABBTree::Tree::_free_node(int p_node) {
+
+	nodes[p_node].parent=free_node;
+	nodes[p_node].height=-1;
+	free_node=p_node;
+}
+
+void BroadPhaseAABBTree::Tree::_insert_leaf(int p_leaf) {
+
+	if (root==-1) {
+		root=p_leaf;
+		nodes[root].parent=-1;
+		return;
+	}
+
+	AABB leaf_aabb = nodes[p_leaf].aabb;
+
+	// descend choosing the child whose bounds grow the least
+	int index=root;
+	while(!nodes[index].is_leaf()) {
+
+		const Node &n = nodes[index];
+		real_t cost_here = _aabb_cost(n.aabb);
+		real_t combined_cost = _aabb_cost(_aabb_merge(n.aabb,leaf_aabb));
+
+		real_t cost = 2.0*combined_cost; //cost of making a new parent here
+		real_t inherited = 2.0*(combined_cost-cost_here); //cost pushed down to the children
+
+		real_t child_cost[2];
+		for(int i=0;i<2;i++) {
+
+			const Node &c = nodes[n.children[i]];
+			real_t merged = _aabb_cost(_aabb_merge(c.aabb,leaf_aabb));
+			child_cost[i] = (c.is_leaf() ? merged : merged - _aabb_cost(c.aabb)) + inherited;
+		}
+
+		if (cost<child_cost[0] && cost<child_cost[1])
+			break;
+
+		index = child_cost[0]<child_cost[1] ? n.children[0] : n.children[1];
+	}
+
+	int sibling=index;
+	int old_parent=nodes[sibling].parent;
+	int new_parent=_alloc_node(); //may reallocate nodes, no references held above
+
+	nodes[new_parent].parent=old_parent;
+	nodes[new_parent].aabb=_aabb_merge(leaf_aabb,nodes[sibling].aabb);
+	nodes[new_parent].height=nodes[sibling].height+1;
+	nodes[new_parent].children[0]=sibling;
+	nodes[new_parent].children[1]=p_leaf;
+	nodes[sibling].parent=new_parent;
+	nodes[p_leaf].parent=new_parent;
+
+	if (old_parent!=-1) {
+
+		Node &op=nodes[old_parent];
+		op.children[ op.children[0]==sibling ? 0 : 1 ] = new_parent;
+	} else {
+		root=new_parent;
+	}
+
+	// refit and rebalance ancestors
+	index=nodes[p_leaf].parent;
+	while(index!=-1) {
+
+		index=_balance(index);
+		Node &n=nodes[index];
+		const Node &c0=nodes[n.children[0]];
+		const Node &c1=nodes[n.children[1]];
+		n.height=1+MAX(c0.height,c1.height);
+		n.aabb=_aabb_merge(c0.aabb,c1.aabb);
+		index=n.parent;
+	}
+}
+
+void BroadPhaseAABBTree::Tree::_remove_leaf(int p_leaf) {
+
+	if (p_leaf==root) {
+		root=-1;
+		return;
+	}
+
+	int parent=nodes[p_leaf].parent;
+	int grand_parent=nodes[parent].parent;
+	int sibling = nodes[parent].children[0]==p_leaf ? nodes[parent].children[1] : nodes[parent].children[0];
+
+	_free_node(parent);
+
+	if (grand_parent==-1) {
+
+		root=sibling;
+		nodes[sibling].parent=-1;
+		return;
+	}
+
+	Node &gp=nodes[grand_parent];
+	gp.children[ gp.children[0]==parent ? 0 : 1 ] = sibling;
+	nodes[sibling].parent=grand_parent;
+
+	int index=grand_parent;
+	while(index!=-1) {
+
+		index=_balance(index);
+		Node &n=nodes[index];
+		const Node &c0=nodes[n.children[0]];
+		const Node &c1=nodes[n.children[1]];
+		n.height=1+MAX(c0.height,c1.height);
+		n.aabb=_aabb_merge(c0.aabb,c1.aabb);
+		index=n.parent;
+	}
+}
+
+int BroadPhaseAABBTree::Tree::_balance(int p_node) {
+
+	// single rotation promoting the taller grandchild, keeps height O(log n)
+
+	int iA=p_node;
+	Node *A=&nodes[iA];
+	if (A->is_leaf() || A->height<2)
+		return iA;
+
+	int iB=A->children[0];
+	int iC=A->children[1];
+	Node *B=&nodes[iB];
+	Node *C=&nodes[iC];
+
+	int balance = C->height - B->height;
+
+	if (balance>1) {
+
+		// rotate C up
+		int iF=C->children[0];
+		int iG=C->children[1];
+		Node *F=&nodes[iF];
+		Node *G=&nodes[iG];
+
+		C->children[0]=iA;
+		C->parent=A->parent;
+		A->parent=iC;
+
+		if (C->parent!=-1) {
+			Node &p=nodes[C->parent];
+			p.children[ p.children[0]==iA ? 0 : 1 ]=iC;
+		} else {
+			root=iC;
+		}
+
+		if (F->height>G->height) {
+			C->children[1]=iF;
+			A->children[1]=iG;
+			G->parent=iA;
+			A->aabb=_aabb_merge(B->aabb,G->aabb);
+			C->aabb=_aabb_merge(A->aabb,F->aabb);
+			A->height=1+MAX(B->height,G->height);
+			C->height=1+MAX(A->height,F->height);
+		} else {
+			C->children[1]=iG;
+			A->children[1]=iF;
+			F->parent=iA;
+			A->aabb=_aabb_merge(B->aabb,F->aabb);
+			C->aabb=_aabb_merge(A->aabb,G->aabb);
+			A->height=1+MAX(B->height,F->height);
+			C->height=1+MAX(A->height,G->height);
+		}
+
+		return iC;
+	}
+
+	if (balance<-1) {
+
+		// rotate B up
+		int iD=B->children[0];
+		int iE=B->children[1];
+		Node *D=&nodes[iD];
+		Node *E=&nodes[iE];
+
+		B->children[0]=iA;
+		B->parent=A->parent;
+		A->parent=iB;
+
+		if (B->parent!=-1) {
+			Node &p=nodes[B->parent];
+			p.children[ p.children[0]==iA ? 0 : 1 ]=iB;
+		} else {
+			root=iB;
+		}
+
+		if (D->height>E->height) {
+			B->children[1]=iD;
+			A->children[0]=iE;
+			E->parent=iA;
+			A->aabb=_aabb_merge(C->aabb,E->aabb);
+			B->aabb=_aabb_merge(A->aabb,D->aabb);
+			A->height=1+MAX(C->height,E->height);
+			B->height=1+MAX(A->height,D->height);
+		} else {
+			B->children[1]=iE;
+			A->children[0]=iD;
+			D->parent=iA;
+			A->aabb=_aabb_merge(C->aabb,D->aabb);
+			B->aabb=_aabb_merge(A->aabb,E->aabb);
+			A->height=1+MAX(C->height,D->height);
+			B->height=1+MAX(A->height,E->height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+int BroadPhaseAABBTree::Tree::create_leaf(const AABB& p_aabb,ID p_element) {
+
+	int leaf=_alloc_node();
+	nodes[leaf].aabb=p_aabb;
+	nodes[leaf].element=p_element;
+	_insert_leaf(leaf);
+	return leaf;
+}
+
+void BroadPhaseAABBTree::Tree::erase_leaf(int p_leaf) {
+
+	_remove_leaf(p_leaf);
+	_free_node(p_leaf);
+}
+
+void BroadPhaseAABBTree::Tree::move_leaf(int p_leaf,const AABB& p_aabb) {
+
+	_remove_leaf(p_leaf);
+	nodes[p_leaf].aabb=p_aabb;
+	_insert_leaf(p_leaf);
+}
+
+template<class C>
+void BroadPhaseAABBTree::Tree::cull_aabb(const AABB& p_aabb,C& p_cull) const {
+
+	if (root==-1)
+		return;
+
+	int stack[MAX_CULL_STACK];
+	int sp=0;
+	stack[sp++]=root;
+
+	while(sp) {
+
+		const Node &n=nodes[stack[--sp]];
+		if (!n.aabb.intersects(p_aabb))
+			continue;
+
+		if (n.is_leaf()) {
+			if (!p_cull(n.element))
+				return;
+		} else {
+			ERR_FAIL_COND(sp+2>MAX_CULL_STACK);
+			stack[sp++]=n.children[0];
+			stack[sp++]=n.children[1];
+		}
+	}
+}
+
+template<class C>
+void BroadPhaseAABBTree::Tree::cull_segment(const Vector3& p_from,const Vector3& p_to,C& p_cull) const {
+
+	if (root==-1)
+		return;
+
+	int stack[MAX_CULL_STACK];
+	int sp=0;
+	stack[sp++]=root;
+
+	while(sp) {
+
+		const Node &n=nodes[stack[--sp]];
+		if (!n.aabb.intersects_segment(p_from,p_to))
+			continue;
+
+		if (n.is_leaf()) {
+			if (!p_cull(n.element))
+				return;
+		} else {
+			ERR_FAIL_COND(sp+2>MAX_CULL_STACK);
+			stack[sp++]=n.children[0];
+			stack[sp++]=n.children[1];
+		}
+	}
+}
+
+BroadPhaseAABBTree::Tree::Tree() {
+
+	nodes=NULL;
+	node_capacity=0;
+	free_node=-1;
+	root=-1;
+}
+
+BroadPhaseAABBTree::Tree::~Tree() {
+
+	if (nodes)
+		memfree(nodes);
+}
+
+/* CULLERS */
+
+struct BroadPhaseAABBTree::PairQuery {
+
+	BroadPhaseAABBTree *self;
+	ID id;
+	Element *elem;
+
+	_FORCE_INLINE_ bool operator()(ID p_other) {
+
+		if (p_other==id)
+			return true;
+		Element *other=self->elements[p_other-1];
+		if (other->owner==elem->owner || !other->aabb.intersects(elem->aabb))
+			return true;
+		if (!elem->pairs.has(p_other))
+			self->_pair(id,elem,p_other,other);
+		return true;
+	}
+};
+
+struct BroadPhaseAABBTree::CullAABB {
+
+	const BroadPhaseAABBTree *self;
+	AABB aabb;
+	CollisionObjectSW** results;
+	int *result_indices;
+	int max_results;
+	int count;
+
+	_FORCE_INLINE_ bool operator()(ID p_id) {
+
+		const Element *e=self->elements[p_id-1];
+		if (!e->aabb.intersects(aabb))
+			return true;
+		results[count]=e->owner;
+		if (result_indices)
+			result_indices[count]=e->subindex;
+		count++;
+		return count<max_results;
+	}
+};
+
+struct BroadPhaseAABBTree::CullSegment {
+
+	const BroadPhaseAABBTree *self;
+	Vector3 from;
+	Vector3 to;
+	CollisionObjectSW** results;
+	int *result_indices;
+	int max_results;
+	int count;
+
+	_FORCE_INLINE_ bool operator()(ID p_id) {
+
+		const Element *e=self->elements[p_id-1];
+		if (!e->aabb.intersects_segment(from,to))
+			return true;
+		results[count]=e->owner;
+		if (result_indices)
+			result_indices[count]=e->subindex;
+		count++;
+		return count<max_results;
+	}
+};
+
+/* BROADPHASE */
+
+AABB BroadPhaseAABBTree::_fatten(const AABB& p_aabb,const AABB& p_prev) const {
+
+	AABB fat=p_aabb.grow(margin);
+
+	// stretch towards the direction of motion, so steady movers rarely leave their leaf
+	Vector3 motion=(p_aabb.pos-p_prev.pos)*2.0;
+	for(int i=0;i<3;i++) {
+		if (motion[i]<0) {
+			fat.pos[i]+=motion[i];
+			fat.size[i]-=motion[i];
+		} else {
+			fat.size[i]+=motion[i];
+		}
+	}
+
+	return fat;
+}
+
+void BroadPhaseAABBTree::_pair(ID p_A,Element *p_elem_A,ID p_B,Element *p_elem_B) {
+
+	void *data=NULL;
+	if (pair_callback)
+		data=pair_callback(p_elem_A->owner,p_elem_A->subindex,p_elem_B->owner,p_elem_B->subindex,pair_userdata);
+	p_elem_A->pairs[p_B]=data;
+	p_elem_B->pairs[p_A]=data;
+}
+
+void BroadPhaseAABBTree::_unpair(ID p_A,Element *p_elem_A,ID p_B,Element *p_elem_B) {
+
+	Map<ID,void*>::Element *E=p_elem_A->pairs.find(p_B);
+	ERR_FAIL_COND(!E);
+	if (unpair_callback)
+		unpair_callback(p_elem_A->owner,p_elem_A->subindex,p_elem_B->owner,p_elem_B->subindex,E->get(),unpair_userdata);
+	p_elem_A->pairs.erase(E);
+	p_elem_B->pairs.erase(p_A);
+}
+
+void BroadPhaseAABBTree::_mark_moved(ID p_id,Element *p_elem) {
+
+	if (p_elem->moved)
+		return;
+	p_elem->moved=true;
+	moved.push_back(p_id);
+}
+
+void BroadPhaseAABBTree::_update_pairs(ID p_id,Element *p_elem) {
+
+	// drop pairs that no longer overlap
+	Map<ID,void*>::Element *P=p_elem->pairs.front();
+	while(P) {
+
+		Map<ID,void*>::Element *N=P->next();
+		Element *other=elements[P->key()-1];
+		if (!_pair_ok(p_elem,other))
+			_unpair(p_id,p_elem,P->key(),other);
+		P=N;
+	}
+
+	if (p_elem->leaf==-1)
+		return;
+
+	// find new ones, static elements only pair against dynamic ones
+	PairQuery query;
+	query.self=this;
+	query.id=p_id;
+	query.elem=p_elem;
+
+	trees[TREE_DYNAMIC].cull_aabb(p_elem->aabb,query);
+	if (!p_elem->_static)
+		trees[TREE_STATIC].cull_aabb(p_elem->aabb,query);
+}
+
+BroadPhaseSW::ID BroadPhaseAABBTree::create(CollisionObjectSW *p_object_, int p_subindex) {
+
+	ERR_FAIL_COND_V(p_object_==NULL,0);
+
+	Element *e = memnew( Element );
+	e->owner=p_object_;
+	e->subindex=p_subindex;
+	e->_static=false;
+	e->moved=false;
+	e->leaf=-1;
+
+	ID id;
+	if (free_ids.size()) {
+		id=free_ids[free_ids.size()-1];
+		free_ids.resize(free_ids.size()-1);
+		elements[id-1]=e;
+	} else {
+		elements.push_back(e);
+		id=elements.size();
+	}
+
+	return id;
+}
+
+void BroadPhaseAABBTree::move(ID p_id, const AABB& p_aabb) {
+
+	Element *e=_get(p_id);
+	ERR_FAIL_COND(!e);
+
+	Tree &tree=trees[e->_static?TREE_STATIC:TREE_DYNAMIC];
+
+	if (e->leaf==-1) {
+		e->leaf=tree.create_leaf(p_aabb.grow(margin),p_id);
+	} else if (!tree.nodes[e->leaf].aabb.encloses(p_aabb)) {
+		tree.move_leaf(e->leaf,_fatten(p_aabb,e->aabb));
+	}
+
+	e->aabb=p_aabb;
+	_mark_moved(p_id,e);
+}
+
+void BroadPhaseAABBTree::set_static(ID p_id, bool p_static) {
+
+	Element *e=_get(p_id);
+	ERR_FAIL_COND(!e);
+
+	if (e->_static==p_static)
+		return;
+
+	if (e->leaf!=-1) {
+
+		Tree &from=trees[e->_static?TREE_STATIC:TREE_DYNAMIC];
+		Tree &to=trees[p_static?TREE_STATIC:TREE_DYNAMIC];
+		AABB fat=from.nodes[e->leaf].aabb;
+		from.erase_leaf(e->leaf);
+		e->leaf=to.create_leaf(fat,p_id);
+	}
+
+	e->_static=p_static;
+	_mark_moved(p_id,e);
+}
+
+void BroadPhaseAABBTree::remove(ID p_id) {
+
+	Element *e=_get(p_id);
+	ERR_FAIL_COND(!e);
+
+	//unpair must be done immediately on removal to avoid potential invalid pointers
+	while(e->pairs.front()) {
+
+		ID other=e->pairs.front()->key();
+		_unpair(p_id,e,other,elements[other-1]);
+	}
+
+	if (e->leaf!=-1)
+		trees[e->_static?TREE_STATIC:TREE_DYNAMIC].erase_leaf(e->leaf);
+
+	memdelete(e);
+	elements[p_id-1]=NULL;
+	removed_ids.push_back(p_id);
+}
+
+CollisionObjectSW *BroadPhaseAABBTree::get_object(ID p_id) const {
+
+	const Element *e=_get(p_id);
+	ERR_FAIL_COND_V(!e,NULL);
+	return e->owner;
+}
+
+bool BroadPhaseAABBTree::is_static(ID p_id) const {
+
+	const Element *e=_get(p_id);
+	ERR_FAIL_COND_V(!e,false);
+	return e->_static;
+}
+
+int BroadPhaseAABBTree::get_subindex(ID p_id) const {
+
+	const Element *e=_get(p_id);
+	ERR_FAIL_COND_V(!e,-1);
+	return e->subindex;
+}
+
+int BroadPhaseAABBTree::cull_segment(const Vector3& p_from, const Vector3& p_to,CollisionObjectSW** p_results,int p_max_results,int *p_result_indices) {
+
+	if (p_max_results<=0)
+		return 0;
+
+	CullSegment cull;
+	cull.self=this;
+	cull.from=p_from;
+	cull.to=p_to;
+	cull.results=p_results;
+	cull.result_indices=p_result_indices;
+	cull.max_results=p_max_results;
+	cull.count=0;
+
+	for(int i=0;i<TREE_MAX && cull.count<p_max_results;i++)
+		trees[i].cull_segment(p_from,p_to,cull);
+
+	return cull.count;
+}
+
+int BroadPhaseAABBTree::cull_aabb(const AABB& p_aabb,CollisionObjectSW** p_results,int p_max_results,int *p_result_indices) {
+
+	if (p_max_results<=0)
+		return 0;
+
+	CullAABB cull;
+	cull.self=this;
+	cull.aabb=p_aabb;
+	cull.results=p_results;
+	cull.result_indices=p_result_indices;
+	cull.max_results=p_max_results;
+	cull.count=0;
+
+	for(int i=0;i<TREE_MAX && cull.count<p_max_results;i++)
+		trees[i].cull_aabb(p_aabb,cull);
+
+	return cull.count;
+}
+
+void BroadPhaseAABBTree::set_pair_callback(PairCallback p_pair_callback,void *p_userdata) {
+
+	pair_callback=p_pair_callback;
+	pair_userdata=p_userdata;
+}
+
+void BroadPhaseAABBTree::set_unpair_callback(UnpairCallback p_unpair_callback,void *p_userdata) {
+
+	unpair_callback=p_unpair_callback;
+	unpair_userdata=p_userdata;
+}
+
+void BroadPhaseAABBTree::update() {
+
+	for(int i=0;i<moved.size();i++) {
+
+		ID id=moved[i];
+		Element *e=elements[id-1];
+		if (!e || !e->moved)
+			continue; //removed since it moved
+		e->moved=false;
+		_update_pairs(id,e);
+	}
+
+	moved.resize(0);
+
+	for(int i=0;i<removed_ids.size();i++)
+		free_ids.push_back(removed_ids[i]);
+	removed_ids.resize(0);
+}
+
+BroadPhaseSW *BroadPhaseAABBTree::_create() {
+
+	return memnew( BroadPhaseAABBTree );
+}
+
+BroadPhaseAABBTree::BroadPhaseAABBTree() {
+
+	margin=0.1;
+	pair_callback=NULL;
+	pair_userdata=NULL;
+	unpair_callback=NULL;
+	unpair_userdata=NULL;
+}
+
+BroadPhaseAABBTree::~BroadPhaseAABBTree() {
+
+	for(int i=0;i<elements.size();i++) {
+		if (elements[i])
+			memdelete(elements[i]);
+	}
+}
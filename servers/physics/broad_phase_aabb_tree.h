@@ -0,0 +1,160 @@
+/*************************************************************************/
+/*  broad_phase_aabb_tree.h                                              */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#ifndef BROAD_PHASE_AABB_TREE_H
+#define BROAD_PHASE_AABB_TREE_H
+
+#include "broad_phase_sw.h"
+#include "map.h"
+#include "vector.h"
+
+/* Dynamic AABB tree broadphase. Leaves hold a fattened copy of each element's
+   AABB so small motions don't touch the tree; static and dynamic elements live
+   in separate trees so pair search for a moving element never has to look at
+   static vs static overlap. Pairs are only recomputed for elements that moved
+   since the last update(). */
+
+class BroadPhaseAABBTree : public BroadPhaseSW {
+
+	enum {
+		TREE_DYNAMIC,
+		TREE_STATIC,
+		TREE_MAX,
+		MAX_CULL_STACK=256
+	};
+
+	struct Node {
+
+		AABB aabb;
+		int parent; // next free node when unused
+		int children[2];
+		int height;
+		ID element;
+
+		_FORCE_INLINE_ bool is_leaf() const { return children[0]==-1; }
+	};
+
+	struct Tree {
+
+		Node *nodes;
+		int node_capacity;
+		int free_node;
+		int root;
+
+		int _alloc_node();
+		void _free_node(int p_node);
+		void _insert_leaf(int p_leaf);
+		void _remove_leaf(int p_leaf);
+		int _balance(int p_node);
+
+		int create_leaf(const AABB& p_aabb,ID p_element);
+		void erase_leaf(int p_leaf);
+		void move_leaf(int p_leaf,const AABB& p_aabb);
+
+		template<class C>
+		void cull_aabb(const AABB& p_aabb,C& p_cull) const;
+		template<class C>
+		void cull_segment(const Vector3& p_from,const Vector3& p_to,C& p_cull) const;
+
+		Tree();
+		~Tree();
+	};
+
+	struct Element {
+
+		CollisionObjectSW *owner;
+		int subindex;
+		bool _static;
+		bool moved;
+		AABB aabb;
+		int leaf; // -1 until the first move
+		Map<ID,void*> pairs;
+	};
+
+	struct PairQuery;
+	struct CullAABB;
+	struct CullSegment;
+
+	Tree trees[TREE_MAX];
+
+	Vector<Element*> elements;
+	Vector<ID> free_ids;
+	Vector<ID> removed_ids; //recycled on update, they may still be in the moved list
+	Vector<ID> moved;
+
+	real_t margin;
+
+	PairCallback pair_callback;
+	void *pair_userdata;
+	UnpairCallback unpair_callback;
+	void *unpair_userdata;
+
+	_FORCE_INLINE_ Element *_get(ID p_id) const {
+
+		ERR_FAIL_COND_V(p_id==0 || p_id>(ID)elements.size(),NULL);
+		return elements[p_id-1];
+	}
+
+	_FORCE_INLINE_ bool _pair_ok(const Element *p_A,const Element *p_B) const {
+
+		return p_A->leaf!=-1 && p_B->leaf!=-1 && (!p_A->_static || !p_B->_static) && p_A->aabb.intersects(p_B->aabb);
+	}
+
+	_FORCE_INLINE_ AABB _fatten(const AABB& p_aabb,const AABB& p_prev) const;
+
+	void _pair(ID p_A,Element *p_elem_A,ID p_B,Element *p_elem_B);
+	void _unpair(ID p_A,Element *p_elem_A,ID p_B,Element *p_elem_B);
+	void _mark_moved(ID p_id,Element *p_elem);
+	void _update_pairs(ID p_id,Element *p_elem);
+
+public:
+
+	// 0 is an invalid ID
+	virtual ID create(CollisionObjectSW *p_object_, int p_subindex=0);
+	virtual void move(ID p_id, const AABB& p_aabb);
+	virtual void set_static(ID p_id, bool p_static);
+	virtual void remove(ID p_id);
+
+	virtual CollisionObjectSW *get_object(ID p_id) const;
+	virtual bool is_static(ID p_id) const;
+	virtual int get_subindex(ID p_id) const;
+
+	virtual int cull_segment(const Vector3& p_from, const Vector3& p_to,CollisionObjectSW** p_results,int p_max_results,int *p_result_indices=NULL);
+	virtual int cull_aabb(const AABB& p_aabb,CollisionObjectSW** p_results,int p_max_results,int *p_result_indices=NULL);
+
+	virtual void set_pair_callback(PairCallback p_pair_callback,void *p_userdata);
+	virtual void set_unpair_callback(UnpairCallback p_unpair_callback,void *p_userdata);
+
+	virtual void update();
+
+	static BroadPhaseSW *_create();
+	BroadPhaseAABBTree();
+	~BroadPhaseAABBTree();
+};
+
+#endif // BROAD_PHASE_AABB_TREE_H
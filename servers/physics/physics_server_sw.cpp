@@ -29,6 +29,8 @@
 #include "physics_server_sw.h"
 #include "broad_phase_basic.h"
 #include "broad_phase_octree.h"
+#include "broad_phase_aabb_tree.h"
+#include "globals.h"
 
 RID PhysicsServerSW::shape_create(ShapeType p_shape) {
 
@@ -1037,7 +1039,14 @@ void PhysicsServerSW::finish() {
 
 PhysicsServerSW::PhysicsServerSW() {
 
-	BroadPhaseSW::create_func=BroadPhaseOctree::_create;
+	String broad_phase = GLOBAL_DEF("physics/broad_phase","octree");
+	Globals::get_singleton()->set_custom_property_info("physics/broad_phase",PropertyInfo(Variant::STRING,"physics/broad_phase",PROPERTY_HINT_ENUM,"octree,aabb_tree,basic"));
+	if (broad_phase=="aabb_tree")
+		BroadPhaseSW::create_func=BroadPhaseAABBTree::_create;
+	else if (broad_phase=="basic")
+		BroadPhaseSW::create_func=BroadPhaseBasic::_create;
+	else
+		BroadPhaseSW::create_func=BroadPhaseOctree::_create;
 
 	active=true;
 
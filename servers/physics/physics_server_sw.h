@@ -52,10 +52,10 @@ friend class PhysicsDirectSpaceStateSW;
 
 	PhysicsDirectBodyStateSW *direct_state;
 
-	mutable RID_Owner<ShapeSW> shape_owner;
+	mutable RID_SlotOwner<ShapeSW> shape_owner;
 	mutable RID_Owner<SpaceSW> space_owner;
-	mutable RID_Owner<AreaSW> area_owner;
-	mutable RID_Owner<BodySW> body_owner;
+	mutable RID_SlotOwner<AreaSW> area_owner;
+	mutable RID_SlotOwner<BodySW> body_owner;
 	mutable RID_Owner<JointSW> joint_owner;
 
 //	void _clear_query(QuerySW *p_query);
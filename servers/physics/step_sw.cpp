@@ -27,6 +27,7 @@
 /* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
 /*************************************************************************/
 #include "step_sw.h"
+#include "globals.h"
 
 
 void StepSW::_populate_island(BodySW* p_body,BodySW** p_island,ConstraintSW **p_constraint_island) {
@@ -78,6 +79,12 @@ void StepSW::_solve_island(ConstraintSW *p_island,int p_iterations,float p_delta
 	}
 }
 
+void StepSW::_solve_island_work(void *p_userdata,int p_index) {
+
+	StepSW *step=(StepSW*)p_userdata;
+	step->_solve_island(step->island_work[p_index],step->solve_iterations,step->solve_delta);
+}
+
 void StepSW::_check_suspend(BodySW *p_island,float p_delta) {
 
 
@@ -194,13 +201,29 @@ void StepSW::step(SpaceSW* p_space,float p_delta,int p_iterations) {
 
 	/* SOLVE CONSTRAINT ISLANDS */
 
-	{
+	if (work_pool.get_thread_count()==0) {
+
 		ConstraintSW *ci=constraint_island_list;
 		while(ci) {
 			//iterating each island separatedly improves cache efficiency
 			_solve_island(ci,p_iterations,p_delta);
 			ci=ci->get_island_list_next();
 		}
+	} else {
+
+		// islands share no dynamic bodies and the solvers apply no impulses to the
+		// static ones they do share, so they can be solved in parallel.
+		// setup stays serial above, as it reports contacts to static bodies and areas.
+		island_work.resize(0);
+		ConstraintSW *ci=constraint_island_list;
+		while(ci) {
+			island_work.push_back(ci);
+			ci=ci->get_island_list_next();
+		}
+
+		solve_iterations=p_iterations;
+		solve_delta=p_delta;
+		work_pool.do_work(island_work.size(),_solve_island_work,this);
 	}
 
 	/* INTEGRATE VELOCITIES */
@@ -234,4 +257,12 @@ void StepSW::step(SpaceSW* p_space,float p_delta,int p_iterations) {
 StepSW::StepSW() {
 
 	_step=1;
+	solve_iterations=0;
+	solve_delta=0;
+	work_pool.init(GLOBAL_DEF("physics/solver_threads",-1)); // -1: one per extra processor, 0: solve on the physics thread
+}
+
+StepSW::~StepSW() {
+
+	work_pool.finish();
 }
@@ -30,19 +30,28 @@
 #define STEP_SW_H
 
 #include "space_sw.h"
+#include "os/thread_work_pool.h"
 
 class StepSW {
 
 	uint64_t _step;
 
+	ThreadWorkPool work_pool;
+	Vector<ConstraintSW*> island_work;
+	int solve_iterations;
+	float solve_delta;
+
 	void _populate_island(BodySW* p_body,BodySW** p_island,ConstraintSW **p_constraint_island);
 	void _setup_island(ConstraintSW *p_island,float p_delta);
 	void _solve_island(ConstraintSW *p_island,int p_iterations,float p_delta);
 	void _check_suspend(BodySW *p_island,float p_delta);
+
+	static void _solve_island_work(void *p_userdata,int p_index);
 public:
 
 	void step(SpaceSW* p_space,float p_delta,int p_iterations);
 	StepSW();
+	~StepSW();
 };
 
 #endif // STEP__SW_H
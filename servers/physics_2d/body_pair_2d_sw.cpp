@@ -354,6 +354,11 @@ void BodyPair2DSW::solve(float p_step) {
 	if (!collided)
 		return;
 
+	// static and kinematic bodies take no impulses. skipping them also means islands
+	// solved in parallel only read the static bodies they share
+	bool dynamic_A=A->get_inv_mass()!=0;
+	bool dynamic_B=B->get_inv_mass()!=0;
+
 	for (int i = 0; i < contact_count; ++i) {
 
 		Contact& c = contacts[i];
@@ -385,8 +390,10 @@ void BodyPair2DSW::solve(float p_step) {
 
 		Vector2 jb = c.normal * (c.acc_bias_impulse - jbnOld);
 
-		A->apply_bias_impulse(c.rA,-jb);
-		B->apply_bias_impulse(c.rB, jb);
+		if (dynamic_A)
+			A->apply_bias_impulse(c.rA,-jb);
+		if (dynamic_B)
+			B->apply_bias_impulse(c.rB, jb);
 
 		real_t bounce=0;
 		real_t jn = -(bounce + vn)*c.mass_normal;
@@ -404,8 +411,10 @@ void BodyPair2DSW::solve(float p_step) {
 		Vector2 j =c.normal * (c.acc_normal_impulse - jnOld) + tangent * ( c.acc_tangent_impulse - jtOld );
 
 
-		A->apply_impulse(c.rA,-j);
-		B->apply_impulse(c.rB, j);
+		if (dynamic_A)
+			A->apply_impulse(c.rA,-j);
+		if (dynamic_B)
+			B->apply_impulse(c.rB, j);
 
 
 	}
@@ -29,44 +29,73 @@
 #include "broad_phase_2d_hash_grid.h"
 #include "globals.h"
 
-void BroadPhase2DHashGrid::_pair_attempt(Element *p_elem, Element* p_with) {
+BroadPhase2DHashGrid::PairData *BroadPhase2DHashGrid::_alloc_pair() {
+
+	if (!free_pairs) {
 
-	Map<Element*,PairData*>::Element *E=p_elem->paired.find(p_with);
+		PairData *block = memnew_arr( PairData, PAIR_POOL_BLOCK );
+		for(int i=0;i<PAIR_POOL_BLOCK;i++) {
+			block[i].next_free = (i+1<PAIR_POOL_BLOCK) ? &block[i+1] : NULL;
+		}
+		pair_blocks.push_back(block);
+		free_pairs=block;
+	}
+
+	PairData *pd=free_pairs;
+	free_pairs=pd->next_free;
+
+	pd->colliding=false;
+	pd->rc=1;
+	pd->ud=NULL;
+	return pd;
+}
+
+void BroadPhase2DHashGrid::_free_pair(PairData *p_pair) {
+
+	p_pair->next_free=free_pairs;
+	free_pairs=p_pair;
+}
+
+void BroadPhase2DHashGrid::_pair_attempt(Element *p_elem, Element* p_with) {
 
 	ERR_FAIL_COND(p_elem->_static && p_with->_static);
 
-	if (!E) {
+	bool is_new;
+	PairData **pd=p_elem->paired.insert(p_with,is_new);
+
+	if (is_new) {
 
-		PairData *pd = memnew( PairData );
-		p_elem->paired[p_with]=pd;
-		p_with->paired[p_elem]=pd;
+		*pd = _alloc_pair();
+		bool with_new;
+		*p_with->paired.insert(p_elem,with_new)=*pd;
 	} else {
-		E->get()->rc++;
+		(*pd)->rc++;
 	}
 
 }
 
 void BroadPhase2DHashGrid::_unpair_attempt(Element *p_elem, Element* p_with) {
 
-	Map<Element*,PairData*>::Element *E=p_elem->paired.find(p_with);
+	PairData **pdp=p_elem->paired.getptr(p_with);
 
-	ERR_FAIL_COND(!E); //this should really be paired..
+	ERR_FAIL_COND(!pdp); //this should really be paired..
 
-	E->get()->rc--;
+	PairData *pd=*pdp;
+	pd->rc--;
 
-	if (E->get()->rc==0) {
+	if (pd->rc==0) {
 
-		if (E->get()->colliding) {
+		if (pd->colliding) {
 			//uncollide
 			if (unpair_callback) {
-				unpair_callback(p_elem->owner,p_elem->subindex,p_with->owner,p_with->subindex,E->get()->ud,unpair_userdata);
+				unpair_callback(p_elem->owner,p_elem->subindex,p_with->owner,p_with->subindex,pd->ud,unpair_userdata);
 			}
 
 
 		}
 
-		memdelete(E->get());
-		p_elem->paired.erase(E);
+		_free_pair(pd);
+		p_elem->paired.erase(p_with);
 		p_with->paired.erase(p_elem);
 	}
 
@@ -75,26 +104,29 @@ void BroadPhase2DHashGrid::_unpair_attempt(Element *p_elem, Element* p_with) {
 
 void BroadPhase2DHashGrid::_check_motion(Element *p_elem) {
 
-	for (Map<Element*,PairData*>::Element *E=p_elem->paired.front();E;E=E->next()) {
+	FLAT_MAP_FOREACH(p_elem->paired,i) {
 
-		bool pairing = p_elem->aabb.intersects( E->key()->aabb );
+		Element *with=p_elem->paired.keys[i];
+		PairData *pd=p_elem->paired.values[i];
 
-		if (pairing!=E->get()->colliding) {
+		bool pairing = p_elem->aabb.intersects( with->aabb );
+
+		if (pairing!=pd->colliding) {
 
 			if (pairing) {
 
 				if (pair_callback) {
-					E->get()->ud=pair_callback(p_elem->owner,p_elem->subindex,E->key()->owner,E->key()->subindex,pair_userdata);
+					pd->ud=pair_callback(p_elem->owner,p_elem->subindex,with->owner,with->subindex,pair_userdata);
 				}
 			} else {
 
 				if (unpair_callback) {
-					unpair_callback(p_elem->owner,p_elem->subindex,E->key()->owner,E->key()->subindex,E->get()->ud,unpair_userdata);
+					unpair_callback(p_elem->owner,p_elem->subindex,with->owner,with->subindex,pd->ud,unpair_userdata);
 				}
 
 			}
 
-			E->get()->colliding=pairing;
+			pd->colliding=pairing;
 		}
 	}
 }
@@ -114,58 +146,46 @@ void BroadPhase2DHashGrid::_enter_grid( Element* p_elem, const Rect2& p_rect,boo
 			pk.x=i;
 			pk.y=j;
 
-			uint32_t idx = pk.hash() % hash_table_size;
-			PosBin *pb = hash_table[idx];
-
-			while (pb) {
+			bool new_bin;
+			PosBin **pbp = cells.insert(pk.key,new_bin);
 
-				if (pb->key == pk) {
-					break;
+			if (new_bin) {
+				//does not exist, create or recycle one
+				if (free_bins) {
+					*pbp=free_bins;
+					free_bins=free_bins->next_free;
+				} else {
+					*pbp=memnew( PosBin );
 				}
-
-				pb=pb->next;
 			}
 
+			PosBin *pb=*pbp;
 
-			bool entered=false;
-
-			if (!pb) {
-				//does not exist, create!
-				pb = memnew( PosBin );
-				pb->key=pk;
-				pb->next=hash_table[idx];
-				hash_table[idx]=pb;
-			}
-
-
-
-			if (p_static) {
-				if (pb->static_object_set[p_elem].inc()==1) {
-					entered=true;
-				}
-			} else {
-				if (pb->object_set[p_elem].inc()==1) {
-
-					entered=true;
-				}
-			}
+			bool entered;
+			int *rc = (p_static ? pb->static_object_set : pb->object_set).insert(p_elem,entered);
+			if (entered)
+				*rc=1;
+			else
+				(*rc)++;
 
 			if (entered) {
 
-				for(Map<Element*,RC>::Element *E=pb->object_set.front();E;E=E->next()) {
+				FLAT_MAP_FOREACH(pb->object_set,k) {
 
-					if (E->key()->owner==p_elem->owner)
+					Element *with=pb->object_set.keys[k];
+					if (with->owner==p_elem->owner)
 						continue;
-					_pair_attempt(p_elem,E->key());
+					_pair_attempt(p_elem,with);
 				}
 
 				if (!p_static) {
 
-					for(Map<Element*,RC>::Element *E=pb->static_object_set.front();E;E=E->next()) {
+					FLAT_MAP_FOREACH(pb->static_object_set,k) {
 
-						if (E->key()->owner==p_elem->owner)
+						Element *with=pb->static_object_set.keys[k];
+						if (with->owner==p_elem->owner)
 							continue;
-						_pair_attempt(p_elem,E->key());
+						_pair_attempt(p_elem,with);
 					}
 				}
 			}
@@ -174,7 +194,8 @@ void BroadPhase2DHashGrid::_enter_grid( Element* p_elem, const Rect2& p_rect,boo
 
 	}
 
-
+	extent_sum+=_get_extent(p_rect);
+	extent_count++;
 }
 
 
@@ -192,114 +213,177 @@ void BroadPhase2DHashGrid::_exit_grid( Element* p_elem, const Rect2& p_rect,bool
 			pk.x=i;
 			pk.y=j;
 
-			uint32_t idx = pk.hash() % hash_table_size;
-			PosBin *pb = hash_table[idx];
+			PosBin **pbp = cells.getptr(pk.key);
 
-			while (pb) {
+			ERR_CONTINUE(!pbp); //should exist!!
 
-				if (pb->key == pk) {
-					break;
-				}
+			PosBin *pb=*pbp;
 
-				pb=pb->next;
-			}
+			FlatMap<Element*,int> &set = p_static ? pb->static_object_set : pb->object_set;
+			int *rc = set.getptr(p_elem);
 
-			ERR_CONTINUE(!pb); //should exist!!
+			ERR_CONTINUE(!rc);
 
 			bool exited=false;
 
+			(*rc)--;
+			if (*rc==0) {
 
-			if (p_static) {
-				if (pb->static_object_set[p_elem].dec()==0) {
-
-					pb->static_object_set.erase(p_elem);
-					exited=true;
-
-				}
-			} else {
-				if (pb->object_set[p_elem].dec()==0) {
-
-					pb->object_set.erase(p_elem);
-					exited=true;
-
-				}
+				set.erase(p_elem);
+				exited=true;
 			}
 
 			if (exited) {
 
-				for(Map<Element*,RC>::Element *E=pb->object_set.front();E;E=E->next()) {
+				FLAT_MAP_FOREACH(pb->object_set,k) {
 
-					if (E->key()->owner==p_elem->owner)
+					Element *with=pb->object_set.keys[k];
+					if (with->owner==p_elem->owner)
 						continue;
-					_unpair_attempt(p_elem,E->key());
+					_unpair_attempt(p_elem,with);
 
 				}
 
 				if (!p_static) {
 
-					for(Map<Element*,RC>::Element *E=pb->static_object_set.front();E;E=E->next()) {
+					FLAT_MAP_FOREACH(pb->static_object_set,k) {
 
-						if (E->key()->owner==p_elem->owner)
+						Element *with=pb->static_object_set.keys[k];
+						if (with->owner==p_elem->owner)
 							continue;
-						_unpair_attempt(p_elem,E->key());
+						_unpair_attempt(p_elem,with);
 					}
 				}
 			}
 
 			if (pb->object_set.empty() && pb->static_object_set.empty()) {
 
-				if (hash_table[idx]==pb) {
-					hash_table[idx]=pb->next;
-				} else {
+				cells.erase(pk.key);
+				pb->next_free=free_bins;
+				free_bins=pb;
+			}
+		}
 
-					PosBin *px = hash_table[idx];
+	}
 
-					while (px) {
+	extent_sum-=_get_extent(p_rect);
+	extent_count--;
+}
 
-						if (px->next==pb) {
-							px->next=pb->next;
-							break;
-						}
+int BroadPhase2DHashGrid::_get_adapted_cell_size() const {
 
-						px=px->next;
-					}
+	if (extent_count==0)
+		return cell_size;
 
-					ERR_CONTINUE(!px);
-				}
+	// aim for cells about twice the average object extent, in powers of two
+	// and within a factor of 4 of the configured size
+	int target = nearest_power_of_2(MAX(1,int(extent_sum/extent_count*2.0)));
+	return CLAMP(target,MAX(1,base_cell_size/4),base_cell_size*4);
+}
 
-				memdelete(pb);
+void BroadPhase2DHashGrid::_rebuild_grid(int p_cell_size) {
 
-			}
+	// move every cell to the free list and forget pair refcounts, keeping the
+	// pair data itself so colliding pairs stay alive across the rebuild
+
+	FLAT_MAP_FOREACH(cells,i) {
+
+		PosBin *pb=cells.values[i];
+		pb->object_set.clear();
+		pb->static_object_set.clear();
+		pb->next_free=free_bins;
+		free_bins=pb;
+	}
+	cells.clear();
+
+	for(int i=0;i<elements.size();i++) {
+
+		Element *e=elements[i];
+		if (!e)
+			continue;
+		FLAT_MAP_FOREACH(e->paired,j) {
+			e->paired.values[j]->rc=0;
 		}
+	}
+
+	cell_size=p_cell_size;
+	extent_sum=0;
+	extent_count=0;
 
+	for(int i=0;i<elements.size();i++) {
+
+		Element *e=elements[i];
+		if (!e || e->aabb==Rect2())
+			continue;
+
+		//pairs found again get their refcount back, new ones start at 1
+		_enter_grid(e,e->aabb,e->_static);
 	}
 
-}
+	// drop pairs that no longer share a cell
+	for(int i=0;i<elements.size();i++) {
+
+		Element *e=elements[i];
+		if (!e)
+			continue;
+
+		uint32_t j=0;
+		while(j<e->paired.capacity) {
+
+			if (!e->paired.hashes[j] || e->paired.values[j]->rc>0) {
+				j++;
+				continue;
+			}
+
+			Element *with=e->paired.keys[j];
+			PairData *pd=e->paired.values[j];
+			if (pd->colliding && unpair_callback)
+				unpair_callback(e->owner,e->subindex,with->owner,with->subindex,pd->ud,unpair_userdata);
+			_free_pair(pd);
+			with->paired.erase(e);
+			e->paired.erase(with); //may shift another entry into j, look at it again
+		}
 
+		_check_motion(e);
+	}
+}
 
 BroadPhase2DHashGrid::ID BroadPhase2DHashGrid::create(CollisionObject2DSW *p_object, int p_subindex) {
 
-	current++;
+	Element *e;
+	if (free_elements) {
+		e=free_elements;
+		free_elements=e->next_free;
+	} else {
+		e=memnew( Element );
+	}
 
-	Element e;
-	e.owner=p_object;
-	e._static=false;
-	e.subindex=p_subindex;
-	e.self=current;
-	e.pass=0;
+	e->owner=p_object;
+	e->_static=false;
+	e->subindex=p_subindex;
+	e->pass=0;
+	e->aabb=Rect2();
+	e->next_free=NULL;
+
+	if (free_ids.size()) {
+		e->self=free_ids[free_ids.size()-1];
+		free_ids.resize(free_ids.size()-1);
+		elements[e->self-1]=e;
+	} else {
+		elements.push_back(e);
+		e->self=elements.size();
+	}
 
-	element_map[current]=e;
-	return current;
+	return e->self;
 
 }
 
 void BroadPhase2DHashGrid::move(ID p_id, const Rect2& p_aabb) {
 
-
-	Map<ID,Element>::Element *E=element_map.find(p_id);
+	Element *E=_get(p_id);
 	ERR_FAIL_COND(!E);
 
-	Element &e=E->get();
+	Element &e=*E;
 
 	if (p_aabb==e.aabb)
 		return;
@@ -324,10 +408,10 @@ void BroadPhase2DHashGrid::move(ID p_id, const Rect2& p_aabb) {
 }
 void BroadPhase2DHashGrid::set_static(ID p_id, bool p_static) {
 
-	Map<ID,Element>::Element *E=element_map.find(p_id);
+	Element *E=_get(p_id);
 	ERR_FAIL_COND(!E);
 
-	Element &e=E->get();
+	Element &e=*E;
 
 	if (e._static==p_static)
 		return;
@@ -345,89 +429,93 @@ void BroadPhase2DHashGrid::set_static(ID p_id, bool p_static) {
 }
 void BroadPhase2DHashGrid::remove(ID p_id) {
 
-	Map<ID,Element>::Element *E=element_map.find(p_id);
+	Element *E=_get(p_id);
 	ERR_FAIL_COND(!E);
 
-	Element &e=E->get();
+	Element &e=*E;
 
 	if (e.aabb!=Rect2())
 		_exit_grid(&e,e.aabb,e._static);
 
-	element_map.erase(p_id);
+	elements[p_id-1]=NULL;
+	free_ids.push_back(p_id);
+	e.paired.clear();
+	e.next_free=free_elements;
+	free_elements=&e;
 
 }
 
 CollisionObject2DSW *BroadPhase2DHashGrid::get_object(ID p_id) const {
 
-	const Map<ID,Element>::Element *E=element_map.find(p_id);
+	const Element *E=_get(p_id);
 	ERR_FAIL_COND_V(!E,NULL);
-	return E->get().owner;
+	return E->owner;
 
 }
 bool BroadPhase2DHashGrid::is_static(ID p_id) const {
 
-	const Map<ID,Element>::Element *E=element_map.find(p_id);
+	const Element *E=_get(p_id);
 	ERR_FAIL_COND_V(!E,false);
-	return E->get()._static;
+	return E->_static;
 
 }
 int BroadPhase2DHashGrid::get_subindex(ID p_id) const {
 
-	const Map<ID,Element>::Element *E=element_map.find(p_id);
+	const Element *E=_get(p_id);
 	ERR_FAIL_COND_V(!E,-1);
-	return E->get().subindex;
+	return E->subindex;
 }
 
-void BroadPhase2DHashGrid::_cull(const Point2i p_cell,CollisionObject2DSW** p_results,int p_max_results,int *p_result_indices,int &index) {
+void BroadPhase2DHashGrid::_cull(const Point2i p_cell,const Rect2& p_aabb,CollisionObject2DSW** p_results,int p_max_results,int *p_result_indices,int &index) {
 
 
 	PosKey pk;
 	pk.x=p_cell.x;
 	pk.y=p_cell.y;
 
-	uint32_t idx = pk.hash() % hash_table_size;
-	PosBin *pb = hash_table[idx];
-
-	while (pb) {
-
-		if (pb->key == pk) {
-			break;
-		}
-
-		pb=pb->next;
-	}
+	PosBin **pbp = cells.getptr(pk.key);
 
-	if (!pb)
+	if (!pbp)
 		return;
 
+	PosBin *pb=*pbp;
 
+	// an empty p_aabb means a segment query, which only needs the cell
 
-	for(Map<Element*,RC>::Element *E=pb->object_set.front();E;E=E->next()) {
+	FLAT_MAP_FOREACH(pb->object_set,k) {
 
 
 		if (index>=p_max_results)
 			break;
-		if (E->key()->pass==pass)
+		Element *e=pb->object_set.keys[k];
+		if (e->pass==pass)
 			continue;
 
-		E->key()->pass=pass;
-		p_results[index]=E->key()->owner;
-		p_result_indices[index]=E->key()->subindex;
+		e->pass=pass;
+		if (p_aabb!=Rect2() && !p_aabb.intersects(e->aabb))
+			continue;
+
+		p_results[index]=e->owner;
+		p_result_indices[index]=e->subindex;
 		index++;
 
 	}
 
-	for(Map<Element*,RC>::Element *E=pb->static_object_set.front();E;E=E->next()) {
+	FLAT_MAP_FOREACH(pb->static_object_set,k) {
 
 
 		if (index>=p_max_results)
 			break;
-		if (E->key()->pass==pass)
+		Element *e=pb->static_object_set.keys[k];
+		if (e->pass==pass)
+			continue;
+
+		e->pass=pass;
+		if (p_aabb!=Rect2() && !p_aabb.intersects(e->aabb))
 			continue;
 
-		E->key()->pass=pass;
-		p_results[index]=E->key()->owner;
-		p_result_indices[index]=E->key()->subindex;
+		p_results[index]=e->owner;
+		p_result_indices[index]=e->subindex;
 		index++;
 
 	}
@@ -468,7 +556,7 @@ int BroadPhase2DHashGrid::cull_segment(const Vector2& p_from, const Vector2& p_t
 		max.y= (Math::floor(pos.y + 1)*cell_size - p_from.y) / dir.y;
 
 	int cullcount=0;
-	_cull(pos,p_results,p_max_results,p_result_indices,cullcount);
+	_cull(pos,Rect2(),p_results,p_max_results,p_result_indices,cullcount);
 
 	bool reached_x=false;
 	bool reached_y=false;
@@ -502,7 +590,7 @@ int BroadPhase2DHashGrid::cull_segment(const Vector2& p_from, const Vector2& p_t
 			reached_y=true;
 		}
 
-		_cull(pos,p_results,p_max_results,p_result_indices,cullcount);
+		_cull(pos,Rect2(),p_results,p_max_results,p_result_indices,cullcount);
 
 		if (reached_x && reached_y)
 			break;
@@ -515,8 +603,21 @@ int BroadPhase2DHashGrid::cull_segment(const Vector2& p_from, const Vector2& p_t
 
 int BroadPhase2DHashGrid::cull_aabb(const Rect2& p_aabb,CollisionObject2DSW** p_results,int p_max_results,int *p_result_indices) {
 
+	pass++;
+
+	Point2i from = (p_aabb.pos/cell_size).floor();
+	Point2i to = ((p_aabb.pos+p_aabb.size)/cell_size).floor();
+	int cullcount=0;
 
-	return 0;
+	for(int i=from.x;i<=to.x;i++) {
+
+		for(int j=from.y;j<=to.y;j++) {
+
+			_cull(Point2i(i,j),p_aabb,p_results,p_max_results,p_result_indices,cullcount);
+		}
+	}
+
+	return cullcount;
 }
 
 void BroadPhase2DHashGrid::set_pair_callback(PairCallback p_pair_callback,void *p_userdata) {
@@ -534,7 +635,16 @@ void BroadPhase2DHashGrid::set_unpair_callback(UnpairCallback p_unpair_callback,
 
 void BroadPhase2DHashGrid::update() {
 
+	if (!adaptive_cell_size)
+		return;
+
+	if (--adapt_check_countdown>0)
+		return;
+	adapt_check_countdown=ADAPT_CHECK_INTERVAL;
 
+	int new_cell_size = _get_adapted_cell_size();
+	if (new_cell_size!=cell_size)
+		_rebuild_grid(new_cell_size);
 }
 
 BroadPhase2DSW *BroadPhase2DHashGrid::_create() {
@@ -545,31 +655,52 @@ BroadPhase2DSW *BroadPhase2DHashGrid::_create() {
 
 BroadPhase2DHashGrid::BroadPhase2DHashGrid() {
 
-	hash_table_size = GLOBAL_DEF("physics_2d/bp_hash_table_size",4096);
-	hash_table_size = Math::larger_prime(hash_table_size);
-	hash_table = memnew_arr( PosBin*, hash_table_size);
+	uint32_t hash_table_size = GLOBAL_DEF("physics_2d/bp_hash_table_size",4096);
+	cells._resize(nearest_power_of_2(hash_table_size));
 
 	cell_size = GLOBAL_DEF("physics_2d/cell_size",128);
-
-	for(int i=0;i<hash_table_size;i++)
-		hash_table[i]=NULL;
+	base_cell_size = cell_size;
+	adaptive_cell_size = GLOBAL_DEF("physics_2d/cell_size_adaptive",true);
+	adapt_check_countdown=ADAPT_CHECK_INTERVAL;
+	extent_sum=0;
+	extent_count=0;
+
+	free_elements=NULL;
+	free_pairs=NULL;
+	free_bins=NULL;
 	pass=1;
 
-	current=0;
+	pair_callback=NULL;
+	pair_userdata=NULL;
+	unpair_callback=NULL;
+	unpair_userdata=NULL;
 }
 
 BroadPhase2DHashGrid::~BroadPhase2DHashGrid() {
 
-	for(int i=0;i<hash_table_size;i++) {
-		while(hash_table[i]) {
-			PosBin *pb=hash_table[i];
-			hash_table[i]=pb->next;
-			memdelete(pb);
-		}
+	FLAT_MAP_FOREACH(cells,i) {
+		memdelete(cells.values[i]);
+	}
+
+	while(free_bins) {
+		PosBin *pb=free_bins;
+		free_bins=pb->next_free;
+		memdelete(pb);
 	}
 
-	memdelete_arr( hash_table );
+	for(int i=0;i<elements.size();i++) {
+		if (elements[i])
+			memdelete(elements[i]);
+	}
+
+	while(free_elements) {
+		Element *e=free_elements;
+		free_elements=e->next_free;
+		memdelete(e);
+	}
 
+	for(int i=0;i<pair_blocks.size();i++)
+		memdelete_arr(pair_blocks[i]);
 
 }
 
@@ -30,17 +30,183 @@
 #define BROAD_PHASE_2D_HASH_GRID_H
 
 #include "broad_phase_2d_sw.h"
-#include "map.h"
+#include "vector.h"
+#include "os/memory.h"
 
 class BroadPhase2DHashGrid : public BroadPhase2DSW {
 
 
+	static _FORCE_INLINE_ uint32_t _hash64(uint64_t p_key) {
+
+		uint64_t k=p_key;
+		k = (~k) + (k << 18); // k = (k << 18) - k - 1;
+		k = k ^ (k >> 31);
+		k = k * 21; // k = (k + (k << 2)) + (k << 4);
+		k = k ^ (k >> 11);
+		k = k + (k << 6);
+		k = k ^ (k >> 22);
+		return k;
+	}
+
+	/* Small open addressed table (linear probing, backward shift erase) for
+	   POD keys and values. Storage is only allocated on first insert, and
+	   clear() keeps it, so recycled cells and elements don't allocate. */
+
+	template<class K,class V>
+	struct FlatMap {
+
+		uint32_t *hashes; // 0 means empty
+		K *keys;
+		V *values;
+		uint32_t capacity;
+		uint32_t count;
+
+		_FORCE_INLINE_ static uint32_t _hash(const K& p_key) {
+
+			uint32_t h = _hash64((uint64_t)p_key);
+			return h ? h : 1;
+		}
+
+		void _resize(uint32_t p_capacity) {
+
+			uint32_t *old_hashes=hashes;
+			K *old_keys=keys;
+			V *old_values=values;
+			uint32_t old_capacity=capacity;
+
+			capacity=p_capacity;
+			hashes=(uint32_t*)memalloc(sizeof(uint32_t)*capacity);
+			keys=(K*)memalloc(sizeof(K)*capacity);
+			values=(V*)memalloc(sizeof(V)*capacity);
+			for(uint32_t i=0;i<capacity;i++)
+				hashes[i]=0;
+
+			for(uint32_t i=0;i<old_capacity;i++) {
+
+				if (!old_hashes[i])
+					continue;
+				uint32_t idx=old_hashes[i]&(capacity-1);
+				while(hashes[idx])
+					idx=(idx+1)&(capacity-1);
+				hashes[idx]=old_hashes[i];
+				keys[idx]=old_keys[i];
+				values[idx]=old_values[i];
+			}
+
+			if (old_hashes) {
+				memfree(old_hashes);
+				memfree(old_keys);
+				memfree(old_values);
+			}
+		}
+
+		_FORCE_INLINE_ V* getptr(const K& p_key) const {
+
+			if (!count)
+				return NULL;
+			uint32_t h=_hash(p_key);
+			uint32_t idx=h&(capacity-1);
+			while(hashes[idx]) {
+				if (hashes[idx]==h && keys[idx]==p_key)
+					return &values[idx];
+				idx=(idx+1)&(capacity-1);
+			}
+			return NULL;
+		}
+
+		// returns the value slot for p_key, r_new tells if it was just added (value is uninitialized)
+		_FORCE_INLINE_ V* insert(const K& p_key,bool &r_new) {
+
+			uint32_t h=_hash(p_key);
+
+			if (count) {
+				uint32_t idx=h&(capacity-1);
+				while(hashes[idx]) {
+					if (hashes[idx]==h && keys[idx]==p_key) {
+						r_new=false;
+						return &values[idx];
+					}
+					idx=(idx+1)&(capacity-1);
+				}
+			}
+
+			if ((count+1)*4 > capacity*3)
+				_resize(capacity ? capacity*2 : 8);
+
+			uint32_t idx=h&(capacity-1);
+			while(hashes[idx])
+				idx=(idx+1)&(capacity-1);
+
+			hashes[idx]=h;
+			keys[idx]=p_key;
+			count++;
+			r_new=true;
+			return &values[idx];
+		}
+
+		bool erase(const K& p_key) {
+
+			if (!count)
+				return false;
+
+			uint32_t mask=capacity-1;
+			uint32_t h=_hash(p_key);
+			uint32_t idx=h&mask;
+			while(true) {
+				if (!hashes[idx])
+					return false;
+				if (hashes[idx]==h && keys[idx]==p_key)
+					break;
+				idx=(idx+1)&mask;
+			}
+
+			// shift back following entries that probed past the hole
+			uint32_t hole=idx;
+			uint32_t next=(hole+1)&mask;
+			while(hashes[next]) {
+
+				uint32_t ideal=hashes[next]&mask;
+				if (((next-ideal)&mask) >= ((next-hole)&mask)) {
+					hashes[hole]=hashes[next];
+					keys[hole]=keys[next];
+					values[hole]=values[next];
+					hole=next;
+				}
+				next=(next+1)&mask;
+			}
+
+			hashes[hole]=0;
+			count--;
+			return true;
+		}
+
+		_FORCE_INLINE_ bool empty() const { return count==0; }
+
+		void clear() {
+
+			for(uint32_t i=0;i<capacity;i++)
+				hashes[i]=0;
+			count=0;
+		}
+
+		_FORCE_INLINE_ FlatMap() { hashes=NULL; keys=NULL; values=NULL; capacity=0; count=0; }
+		~FlatMap() {
+			if (hashes) {
+				memfree(hashes);
+				memfree(keys);
+				memfree(values);
+			}
+		}
+	};
+
+#define FLAT_MAP_FOREACH(m_map,m_idx) for(uint32_t m_idx=0;m_idx<(m_map).capacity;m_idx++) if ((m_map).hashes[m_idx])
+
 	struct PairData {
 
 		bool colliding;
 		int rc;
 		void *ud;
-		PairData() { colliding=false; rc=1; ud=NULL; }
+		PairData *next_free;
 	};
 
 	struct Element {
@@ -51,41 +217,35 @@ class BroadPhase2DHashGrid : public BroadPhase2DSW {
 		Rect2 aabb;
 		int subindex;
 		uint64_t pass;
-		Map<Element*,PairData*> paired;
-
+		FlatMap<Element*,PairData*> paired;
+		Element *next_free;
 	};
 
-
-	Map<ID,Element> element_map;
-
-	ID current;
+	Vector<Element*> elements; // indexed by ID-1, NULL when free
+	Element *free_elements;
+	Vector<ID> free_ids;
 
 	uint64_t pass;
 
-
-	struct PairKey {
-
-		union {
-			struct {
-				ID a;
-				ID b;
-			};
-			uint64_t key;
-		};
-
-		_FORCE_INLINE_ bool operator<(const PairKey& p_key) const {
-			return key < p_key.key;
-		}
-
-		PairKey() { key=0; }
-		PairKey(ID p_a, ID p_b) { if (p_a>p_b) { a=p_b; b=p_a; } else { a=p_a; b=p_b; }}
-
+	enum {
+		PAIR_POOL_BLOCK=256,
+		ADAPT_CHECK_INTERVAL=60 // updates between cell size checks
 	};
 
+	Vector<PairData*> pair_blocks;
+	PairData *free_pairs;
 
-	Map<PairKey,PairData> pair_map;
+	_FORCE_INLINE_ PairData *_alloc_pair();
+	_FORCE_INLINE_ void _free_pair(PairData *p_pair);
 
 	int cell_size;
+	int base_cell_size;
+	bool adaptive_cell_size;
+	int adapt_check_countdown;
+
+	// sum of element extents currently in the grid, drives adaptive cell sizing
+	real_t extent_sum;
+	int extent_count;
 
 	PairCallback pair_callback;
 	void *pair_userdata;
@@ -94,7 +254,7 @@ class BroadPhase2DHashGrid : public BroadPhase2DSW {
 
 	void _enter_grid(Element* p_elem, const Rect2& p_rect,bool p_static);
 	void _exit_grid(Element* p_elem, const Rect2& p_rect,bool p_static);
-	_FORCE_INLINE_ void _cull(const Point2i p_cell,CollisionObject2DSW** p_results,int p_max_results,int *p_result_indices,int &index);
+	_FORCE_INLINE_ void _cull(const Point2i p_cell,const Rect2& p_aabb,CollisionObject2DSW** p_results,int p_max_results,int *p_result_indices,int &index);
 
 
 	struct PosKey {
@@ -106,60 +266,32 @@ class BroadPhase2DHashGrid : public BroadPhase2DSW {
 			};
 			uint64_t key;
 		};
-
-
-		_FORCE_INLINE_ uint32_t hash() const {
-			uint64_t k=key;
-			k = (~k) + (k << 18); // k = (k << 18) - k - 1;
-			k = k ^ (k >> 31);
-			k = k * 21; // k = (k + (k << 2)) + (k << 4);
-			k = k ^ (k >> 11);
-			k = k + (k << 6);
-			k = k ^ (k >> 22);
-			return k;
-		}
-
-		bool operator==(const PosKey& p_key) const { return key==p_key.key; }
-		_FORCE_INLINE_ bool operator<(const PosKey& p_key) const {
-			return key < p_key.key;
-		}
-
-	};
-
-	struct RC {
-
-		int ref;
-
-		_FORCE_INLINE_ int inc() {
-			ref++;
-			return ref;
-		}
-		_FORCE_INLINE_ int dec() {
-			ref--;
-			return ref;
-		}
-
-		_FORCE_INLINE_ RC() {
-			ref=0;
-		}
 	};
 
 	struct PosBin {
 
-		PosKey key;
-		Map<Element*,RC> object_set;
-		Map<Element*,RC> static_object_set;
-		PosBin *next;
+		FlatMap<Element*,int> object_set;
+		FlatMap<Element*,int> static_object_set;
+		PosBin *next_free;
 	};
 
-
-	uint32_t hash_table_size;
-	PosBin **hash_table;
+	FlatMap<uint64_t,PosBin*> cells;
+	PosBin *free_bins;
 
 	void _pair_attempt(Element *p_elem, Element* p_with);
 	void _unpair_attempt(Element *p_elem, Element* p_with);
 	void _check_motion(Element *p_elem);
 
+	_FORCE_INLINE_ Element *_get(ID p_id) const {
+
+		ERR_FAIL_COND_V(p_id==0 || p_id>(ID)elements.size(),NULL);
+		return elements[p_id-1];
+	}
+
+	_FORCE_INLINE_ real_t _get_extent(const Rect2& p_rect) const { return MAX(p_rect.size.x,p_rect.size.y); }
+
+	int _get_adapted_cell_size() const;
+	void _rebuild_grid(int p_cell_size);
 
 public:
 
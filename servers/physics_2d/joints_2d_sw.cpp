@@ -271,8 +271,10 @@ void PinJoint2DSW::solve(float p_step){
 
 	Vector2 impulse = M.basis_xform(bias - rel_vel - Vector2(softness,softness) * P);
 
-	A->apply_impulse(rA,-impulse);
-	if (B)
+	//no impulses on static bodies, other islands may be reading them
+	if (A->get_inv_mass())
+		A->apply_impulse(rA,-impulse);
+	if (B && B->get_inv_mass())
 		B->apply_impulse(rB,impulse);
 
 
@@ -426,8 +428,11 @@ void GrooveJoint2DSW::solve(float p_step){
 
 	j = jn_acc - jOld;
 
-	A->apply_impulse(rA,-j);
-	B->apply_impulse(rB,j);
+	//no impulses on static bodies, other islands may be reading them
+	if (A->get_inv_mass())
+		A->apply_impulse(rA,-j);
+	if (B->get_inv_mass())
+		B->apply_impulse(rB,j);
 }
 
 
@@ -499,8 +504,11 @@ void DampedSpringJoint2DSW::solve(float p_step) {
 	target_vrn = vrn + v_damp;
 	Vector2 j=n*v_damp*n_mass;
 
-	A->apply_impulse(rA,-j);
-	B->apply_impulse(rB,j);
+	//no impulses on static bodies, other islands may be reading them
+	if (A->get_inv_mass())
+		A->apply_impulse(rA,-j);
+	if (B->get_inv_mass())
+		B->apply_impulse(rB,j);
 
 }
 
@@ -52,10 +52,10 @@ friend class Physics2DDirectSpaceStateSW;
 
 	Physics2DDirectBodyStateSW *direct_state;
 
-	mutable RID_Owner<Shape2DSW> shape_owner;
+	mutable RID_SlotOwner<Shape2DSW> shape_owner;
 	mutable RID_Owner<Space2DSW> space_owner;
-	mutable RID_Owner<Area2DSW> area_owner;
-	mutable RID_Owner<Body2DSW> body_owner;
+	mutable RID_SlotOwner<Area2DSW> area_owner;
+	mutable RID_SlotOwner<Body2DSW> body_owner;
 	mutable RID_Owner<Joint2DSW> joint_owner;
 
 //	void _clear_query(Query2DSW *p_query);
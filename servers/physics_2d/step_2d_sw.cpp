@@ -27,6 +27,7 @@
 /* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
 /*************************************************************************/
 #include "step_2d_sw.h"
+#include "globals.h"
 
 
 void Step2DSW::_populate_island(Body2DSW* p_body,Body2DSW** p_island,Constraint2DSW **p_constraint_island) {
@@ -79,6 +80,12 @@ void Step2DSW::_solve_island(Constraint2DSW *p_island,int p_iterations,float p_d
 	}
 }
 
+void Step2DSW::_solve_island_work(void *p_userdata,int p_index) {
+
+	Step2DSW *step=(Step2DSW*)p_userdata;
+	step->_solve_island(step->island_work[p_index],step->solve_iterations,step->solve_delta);
+}
+
 void Step2DSW::_check_suspend(Body2DSW *p_island,float p_delta) {
 
 
@@ -196,13 +203,29 @@ void Step2DSW::step(Space2DSW* p_space,float p_delta,int p_iterations) {
 
 	/* SOLVE CONSTRAINT ISLANDS */
 
-	{
+	if (work_pool.get_thread_count()==0) {
+
 		Constraint2DSW *ci=constraint_island_list;
 		while(ci) {
 			//iterating each island separatedly improves cache efficiency
 			_solve_island(ci,p_iterations,p_delta);
 			ci=ci->get_island_list_next();
 		}
+	} else {
+
+		// islands share no dynamic bodies and the solvers apply no impulses to the
+		// static ones they do share, so they can be solved in parallel.
+		// setup stays serial above, as it reports contacts to static bodies and areas.
+		island_work.resize(0);
+		Constraint2DSW *ci=constraint_island_list;
+		while(ci) {
+			island_work.push_back(ci);
+			ci=ci->get_island_list_next();
+		}
+
+		solve_iterations=p_iterations;
+		solve_delta=p_delta;
+		work_pool.do_work(island_work.size(),_solve_island_work,this);
 	}
 
 	/* INTEGRATE VELOCITIES */
@@ -236,4 +259,12 @@ void Step2DSW::step(Space2DSW* p_space,float p_delta,int p_iterations) {
 Step2DSW::Step2DSW() {
 
 	_step=1;
+	solve_iterations=0;
+	solve_delta=0;
+	work_pool.init(GLOBAL_DEF("physics_2d/solver_threads",-1)); // -1: one per extra processor, 0: solve on the physics thread
+}
+
+Step2DSW::~Step2DSW() {
+
+	work_pool.finish();
 }
@@ -30,19 +30,28 @@
 #define STEP_2D_SW_H
 
 #include "space_2d_sw.h"
+#include "os/thread_work_pool.h"
 
 class Step2DSW {
 
 	uint64_t _step;
 
+	ThreadWorkPool work_pool;
+	Vector<Constraint2DSW*> island_work;
+	int solve_iterations;
+	float solve_delta;
+
 	void _populate_island(Body2DSW* p_body,Body2DSW** p_island,Constraint2DSW **p_constraint_island);
 	void _setup_island(Constraint2DSW *p_island,float p_delta);
 	void _solve_island(Constraint2DSW *p_island,int p_iterations,float p_delta);
 	void _check_suspend(Body2DSW *p_island,float p_delta);
+
+	static void _solve_island_work(void *p_userdata,int p_index);
 public:
 
 	void step(Space2DSW* p_space,float p_delta,int p_iterations);
 	Step2DSW();
+	~Step2DSW();
 };
 
 #endif // STEP_2D_SW_H
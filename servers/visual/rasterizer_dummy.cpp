@@ -1363,8 +1363,7 @@ bool RasterizerDummy::render_target_renedered_in_frame(RID p_render_target){
 
 void RasterizerDummy::begin_frame() {
 
-
-
+	canvas_draw_calls=0;
 }
 
 void RasterizerDummy::capture_viewport(Image* r_capture) {
@@ -1486,31 +1485,26 @@ void RasterizerDummy::canvas_end_rect() {
 
 void RasterizerDummy::canvas_draw_line(const Point2& p_from, const Point2& p_to,const Color& p_color,float p_width) {
 
-
-
+	canvas_draw_calls++;
 }
 
 void RasterizerDummy::canvas_draw_rect(const Rect2& p_rect, int p_flags, const Rect2& p_source,RID p_texture,const Color& p_modulate) {
 
-
-
-
+	canvas_draw_calls++;
 }
 void RasterizerDummy::canvas_draw_style_box(const Rect2& p_rect, RID p_texture,const float *p_margin, bool p_draw_center,const Color& p_modulate) {
 
-
+	canvas_draw_calls++;
 }
 void RasterizerDummy::canvas_draw_primitive(const Vector<Point2>& p_points, const Vector<Color>& p_colors,const Vector<Point2>& p_uvs, RID p_texture,float p_width) {
 
-
-
+	canvas_draw_calls++;
 }
 
 
 void RasterizerDummy::canvas_draw_polygon(int p_vertex_count, const int* p_indices, const Vector2* p_vertices, const Vector2* p_uvs, const Color* p_colors,const RID& p_texture,bool p_singlecolor) {
 
-
-
+	canvas_draw_calls++;
 }
 
 void RasterizerDummy::canvas_set_transform(const Matrix32& p_transform) {
@@ -1760,6 +1754,8 @@ void RasterizerDummy::finish() {
 
 int RasterizerDummy::get_render_info(VS::RenderInfo p_info) {
 
+	if (p_info==VS::INFO_DRAW_CALLS_IN_FRAME)
+		return canvas_draw_calls;
 	return 0;
 }
 
@@ -1778,6 +1774,7 @@ bool RasterizerDummy::has_feature(VS::Features p_feature) const {
 
 RasterizerDummy::RasterizerDummy() {
 
+	canvas_draw_calls=0;
 };
 
 RasterizerDummy::~RasterizerDummy() {
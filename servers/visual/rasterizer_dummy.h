@@ -374,6 +374,8 @@ class RasterizerDummy : public Rasterizer {
 	mutable RID_Owner<Light> light_owner;
 	mutable RID_Owner<LightInstance> light_instance_owner;
 
+	int canvas_draw_calls; // so tests can count what the canvas submits
+
 
 	RID default_material;
 
@@ -31,6 +31,7 @@
 #include "globals.h"
 #include "default_mouse_cursor.xpm"
 #include "sort.h"
+#include "frame_arena.h"
 // careful, these may run in different threads than the visual server
 
 BalloonAllocator<> *VisualServerRaster::OctreeAllocator::allocator=NULL;
@@ -2251,38 +2252,15 @@ float VisualServerRaster::instance_geometry_get_draw_range_max(RID p_instance) c
 
 }
 
-void VisualServerRaster::_update_instance(Instance *p_instance) {
+// only touches the instance itself, so it can run on several threads at once
+void VisualServerRaster::_update_instance_transform(Instance *p_instance) {
 
-	p_instance->version++;
-
-	if (p_instance->base_type == INSTANCE_LIGHT) {
-	
-		rasterizer->light_instance_set_transform( p_instance->light_info->instance, p_instance->data.transform );
-		
-	}
+	if (p_instance->update_aabb)
+		_update_instance_aabb(p_instance);
 
 	if (p_instance->aabb.has_no_surface())
 		return;
 
-
-	if (p_instance->base_type == INSTANCE_PARTICLES) {
-	
-		rasterizer->particles_instance_set_transform( p_instance->particles_info->instance, p_instance->data.transform );
-	}
-		
-
-	if (p_instance->base_type&INSTANCE_GEOMETRY_MASK) {
-
-		//make sure lights are updated
-		InstanceSet::Element *E=p_instance->lights.front();
-		while(E) {
-
-			E->get()->version++;
-			E=E->next();
-		}
-
-	}
-
 	if (p_instance->base_type == INSTANCE_ROOM) {
 
 		p_instance->room_info->affine_inverse=p_instance->data.transform.affine_inverse();
@@ -2324,14 +2302,42 @@ void VisualServerRaster::_update_instance(Instance *p_instance) {
 		new_aabb = p_instance->data.transform.xform(p_instance->aabb);
 	}
 
+	p_instance->transformed_aabb=new_aabb;
+}
 
+void VisualServerRaster::_update_instance_work(void *p_userdata,int p_index) {
+
+	VisualServerRaster *vsr=(VisualServerRaster*)p_userdata;
+	vsr->_update_instance_transform(vsr->instance_update_work[p_index]);
+}
+
+// rasterizer, lights and octree, expects _update_instance_transform to have run
+void VisualServerRaster::_update_instance(Instance *p_instance) {
+
+	p_instance->version++;
+
+	if (p_instance->base_type == INSTANCE_LIGHT) {
+	
+		rasterizer->light_instance_set_transform( p_instance->light_info->instance, p_instance->data.transform );
+		
+	}
+
+	if (p_instance->aabb.has_no_surface())
+		return;
+
+
+	if (p_instance->base_type == INSTANCE_PARTICLES) {
+	
+		rasterizer->particles_instance_set_transform( p_instance->particles_info->instance, p_instance->data.transform );
+	}
+
+	//make sure lights are updated
 	for(InstanceSet::Element *E=p_instance->lights.front();E;E=E->next()) {
 		Instance *light = E->get();
 		light->version++;
 	}
 
-
-	p_instance->transformed_aabb=new_aabb;
+	const AABB &new_aabb=p_instance->transformed_aabb;
 
 	if (!p_instance->scenario) {
 
@@ -2470,21 +2476,47 @@ void VisualServerRaster::_update_instance_aabb(Instance *p_instance) {
 
 void VisualServerRaster::_update_instances() {
 
+	if (!instance_update_list)
+		return;
+
+	uint64_t begin=OS::get_singleton()->get_ticks_usec();
+
+	instance_update_work.resize(0);
+	for(Instance *instance=instance_update_list;instance;instance=instance->update_next)
+		instance_update_work.push_back(instance);
+
+	int count=instance_update_work.size();
+
+	if (instance_update_pool.get_thread_count()==0 || count<INSTANCE_UPDATE_MIN_PARALLEL) {
+
+		for(int i=0;i<count;i++)
+			_update_instance_transform(instance_update_work[i]);
+	} else {
+
+		instance_update_pool.do_work(count,_update_instance_work,this);
+	}
+
+	uint64_t transformed=OS::get_singleton()->get_ticks_usec();
+
+	// octree, pairing and room/portal changes are not thread safe, apply them in a single pass
 	while(instance_update_list) {
 	
 		Instance *instance=instance_update_list;
 
 		instance_update_list=instance_update_list->update_next;
-		
-		if (instance->update_aabb)
-			_update_instance_aabb(instance);
-			
+
 		_update_instance(instance);
 		
 		instance->update=false;
 		instance->update_aabb=false;
 		instance->update_next=0;
 	}
+
+	uint64_t end=OS::get_singleton()->get_ticks_usec();
+
+	instance_update_info.instances+=count;
+	instance_update_info.transform_usec+=transformed-begin;
+	instance_update_info.octree_usec+=end-transformed;
 }
 
 /****** CANVAS *********/
@@ -2547,9 +2579,11 @@ void VisualServerRaster::canvas_item_set_parent(RID p_item,RID p_parent) {
 
 			CanvasItem *item_owner = canvas_item_owner.get(canvas_item->parent);
 			item_owner->child_items.erase(canvas_item);
+			item_owner->subtree_changed();
 		}
 
 		canvas_item->parent=RID();
+		canvas_item->parent_item=NULL;
 	}
 
 
@@ -2564,6 +2598,8 @@ void VisualServerRaster::canvas_item_set_parent(RID p_item,RID p_parent) {
 
 			CanvasItem *item_owner = canvas_item_owner.get(p_parent);
 			item_owner->child_items.push_back(canvas_item);
+			canvas_item->parent_item=item_owner;
+			item_owner->subtree_changed();
 
 		} else {
 
@@ -2594,7 +2630,11 @@ void VisualServerRaster::canvas_item_set_visible(RID p_item,bool p_visible) {
 	CanvasItem *canvas_item = canvas_item_owner.get( p_item );
 	ERR_FAIL_COND(!canvas_item);
 
+	if (canvas_item->visible==p_visible)
+		return;
+
 	canvas_item->visible=p_visible;
+	canvas_item->subtree_changed();
 }
 
 
@@ -2633,6 +2673,8 @@ void VisualServerRaster::canvas_item_attach_viewport(RID p_canvas_item, RID p_vi
 	VS_CHANGED;
 
 	canvas_item->viewport=p_viewport;
+	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 }
 
@@ -2652,6 +2694,8 @@ void VisualServerRaster::canvas_item_set_clip(RID p_item, bool p_clip) {
 	ERR_FAIL_COND(!canvas_item);
 	
 	canvas_item->clip=p_clip;
+	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 }
 
 const Rect2& VisualServerRaster::CanvasItem::get_rect() const {
@@ -2778,6 +2822,40 @@ const Rect2& VisualServerRaster::CanvasItem::get_rect() const {
 	return rect;
 }
 
+const Rect2& VisualServerRaster::CanvasItem::get_subtree_rect() const {
+
+	if (!subtree_dirty)
+		return subtree_rect;
+
+	subtree_empty = commands.size()==0 && !custom_rect && !viewport.is_valid();
+	if (!subtree_empty)
+		subtree_rect=get_rect();
+
+	int cc=child_items.size();
+	const CanvasItem * const *children=child_items.ptr();
+
+	for(int i=0;i<cc;i++) {
+
+		const CanvasItem *c=children[i];
+		if (!c->visible)
+			continue;
+
+		const Rect2& r = c->get_subtree_rect();
+		if (c->subtree_empty)
+			continue;
+
+		Rect2 cr = c->xform.xform(r);
+		if (subtree_empty) {
+			subtree_rect=cr;
+			subtree_empty=false;
+		} else
+			subtree_rect=subtree_rect.merge(cr);
+	}
+
+	subtree_dirty=false;
+	return subtree_rect;
+}
+
 void VisualServerRaster::canvas_item_set_transform(RID p_item, const Matrix32& p_transform) {
 
 	VS_CHANGED;
@@ -2785,6 +2863,8 @@ void VisualServerRaster::canvas_item_set_transform(RID p_item, const Matrix32& p
 	ERR_FAIL_COND(!canvas_item);
 
 	canvas_item->xform=p_transform;
+	if (canvas_item->parent_item)
+		canvas_item->parent_item->subtree_changed();
 
 }
 
@@ -2797,6 +2877,9 @@ void VisualServerRaster::canvas_item_set_custom_rect(RID p_item, bool p_custom_r
 	canvas_item->custom_rect=p_custom_rect;
 	if (p_custom_rect)
 		canvas_item->rect=p_rect;
+	else
+		canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 }
 
@@ -2860,6 +2943,7 @@ void VisualServerRaster::canvas_item_add_line(RID p_item, const Point2& p_from,
 	line->to=p_to;
 	line->width=p_width;
 	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	
 	canvas_item->commands.push_back(line);	
@@ -2875,6 +2959,7 @@ void VisualServerRaster::canvas_item_add_rect(RID p_item, const Rect2& p_rect, c
 	rect->modulate=p_color;
 	rect->rect=p_rect;
 	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	canvas_item->commands.push_back(rect);
 }
@@ -2890,6 +2975,8 @@ void VisualServerRaster::canvas_item_add_circle(RID p_item, const Point2& p_pos,
 	circle->color=p_color;
 	circle->pos=p_pos;
 	circle->radius=p_radius;
+	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	canvas_item->commands.push_back(circle);
 
@@ -2920,6 +3007,7 @@ void VisualServerRaster::canvas_item_add_texture_rect(RID p_item, const Rect2& p
 	}
 	rect->texture=p_texture;
 	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 	canvas_item->commands.push_back(rect);
 }
 
@@ -2948,6 +3036,7 @@ void VisualServerRaster::canvas_item_add_texture_rect_region(RID p_item, const R
 	}
 
 	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	canvas_item->commands.push_back(rect);	
 	
@@ -2969,6 +3058,7 @@ void VisualServerRaster::canvas_item_add_style_box(RID p_item, const Rect2& p_re
 	style->margin[MARGIN_RIGHT]=p_bottomright.x;
 	style->margin[MARGIN_BOTTOM]=p_bottomright.y;
 	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	canvas_item->commands.push_back(style);		
 }
@@ -2985,6 +3075,7 @@ void VisualServerRaster::canvas_item_add_primitive(RID p_item,const Vector<Point
 	prim->colors=p_colors;
 	prim->width=p_width;
 	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	canvas_item->commands.push_back(prim);	
 }
@@ -3019,6 +3110,7 @@ void VisualServerRaster::canvas_item_add_polygon(RID p_item, const Vector<Point2
 	polygon->indices=indices;
 	polygon->count=indices.size();
 	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	canvas_item->commands.push_back(polygon);
 
@@ -3043,6 +3135,7 @@ void VisualServerRaster::canvas_item_add_triangle_array_ptr(RID p_item, int p_co
 	polygon->indices=p_indices;
 	polygon->count = p_count * 3;
 	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	canvas_item->commands.push_back(polygon);
 };
@@ -3082,6 +3175,7 @@ void VisualServerRaster::canvas_item_add_triangle_array(RID p_item, const Vector
 	polygon->indices=indices;
 	polygon->count = count;
 	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	canvas_item->commands.push_back(polygon);
 }
@@ -3096,6 +3190,8 @@ void VisualServerRaster::canvas_item_add_set_transform(RID p_item,const Matrix32
 	CanvasItem::CommandTransform * tr = memnew( CanvasItem::CommandTransform );
 	ERR_FAIL_COND(!tr);
 	tr->xform=p_transform;
+	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	canvas_item->commands.push_back(tr);
 
@@ -3110,6 +3206,8 @@ void VisualServerRaster::canvas_item_add_set_blend_mode(RID p_item, MaterialBlen
 	CanvasItem::CommandBlendMode * bm = memnew( CanvasItem::CommandBlendMode );
 	ERR_FAIL_COND(!bm);
 	bm->blend_mode = p_blend;
+	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	canvas_item->commands.push_back(bm);
 };
@@ -3123,6 +3221,8 @@ void VisualServerRaster::canvas_item_add_clip_ignore(RID p_item, bool p_ignore)
 	CanvasItem::CommandClipIgnore * ci = memnew( CanvasItem::CommandClipIgnore);
 	ERR_FAIL_COND(!ci);
 	ci->ignore=p_ignore;
+	canvas_item->rect_dirty=true;
+	canvas_item->subtree_changed();
 
 	canvas_item->commands.push_back(ci);
 
@@ -3135,7 +3235,7 @@ void VisualServerRaster::canvas_item_clear(RID p_item) {
 	
 	
 	canvas_item->clear();
-	
+	canvas_item->subtree_changed();
 }
 
 void VisualServerRaster::canvas_item_raise(RID p_item) {
@@ -3390,6 +3490,7 @@ void VisualServerRaster::free( RID p_rid ) {
 
 				CanvasItem *item_owner = canvas_item_owner.get(canvas_item->parent);
 				item_owner->child_items.erase(canvas_item);
+				item_owner->subtree_changed();
 
 			}
 		}
@@ -3397,6 +3498,7 @@ void VisualServerRaster::free( RID p_rid ) {
 		for (int i=0;i<canvas_item->child_items.size();i++) {
 
 			canvas_item->child_items[i]->parent=RID();
+			canvas_item->child_items[i]->parent_item=NULL;
 		}
 
 		canvas_item_owner.free( p_rid );
@@ -4807,8 +4909,8 @@ void VisualServerRaster::_render_camera(Viewport *p_viewport,Camera *p_camera, S
 		room_cull_count = p_scenario->octree.cull_point(p_camera->transform.origin,room_cull_result,MAX_ROOM_CULL,NULL,(1<<INSTANCE_ROOM)|(1<<INSTANCE_PORTAL));
 
 
-		Set<Instance*> current_rooms;
-		Set<Instance*> portal_rooms;
+		Set<Instance*,Comparator<Instance*>,FrameAllocator> current_rooms;
+		Set<Instance*,Comparator<Instance*>,FrameAllocator> portal_rooms;
 		//add to set
 		for(int i=0;i<room_cull_count;i++) {
 
@@ -4852,7 +4954,7 @@ void VisualServerRaster::_render_camera(Viewport *p_viewport,Camera *p_camera, S
 		if (current_rooms.size()) {
 			//camera is inside a room
 			// go through rooms
-			for(Set<Instance*>::Element *E=current_rooms.front();E;E=E->next()) {
+			for(Set<Instance*,Comparator<Instance*>,FrameAllocator>::Element *E=current_rooms.front();E;E=E->next()) {
 				_cull_room(p_camera,E->get());
 			}
 
@@ -5092,6 +5194,90 @@ void VisualServerRaster::_render_camera(Viewport *p_viewport,Camera *p_camera, S
 	rasterizer->end_scene();
 }
 
+bool VisualServerRaster::_canvas_batch_rect(const CanvasItem::CommandRect *p_rect,const Matrix32& p_xform,float p_opacity,MaterialBlendMode p_blend_mode) {
+
+	CanvasBatch &b=canvas_batch;
+
+	Size2 tex_size;
+	if (p_rect->texture.is_valid()) {
+
+		if (p_rect->texture!=b.size_cache_texture) {
+			b.size_cache_texture=p_rect->texture;
+			b.size_cache_valid=rasterizer->is_texture(p_rect->texture);
+			if (b.size_cache_valid)
+				b.size_cache=Size2(rasterizer->texture_get_width(p_rect->texture),rasterizer->texture_get_height(p_rect->texture));
+		}
+
+		if (!b.size_cache_valid || b.size_cache.width<=0 || b.size_cache.height<=0)
+			return false; //let the rasterizer deal with it
+		tex_size=b.size_cache;
+	}
+
+	if (b.quads && (b.texture!=p_rect->texture || b.blend_mode!=p_blend_mode || b.quads==CANVAS_BATCH_MAX_QUADS))
+		_canvas_batch_flush();
+
+	if (b.quads==0) {
+		b.texture=p_rect->texture;
+		b.blend_mode=p_blend_mode;
+	}
+
+	int ofs=b.quads*4;
+	const Rect2 &r=p_rect->rect;
+
+	Vector2 *v=&b.vertices[ofs];
+	v[0]=p_xform.xform(r.pos);
+	v[1]=p_xform.xform(Vector2(r.pos.x+r.size.width,r.pos.y));
+	v[2]=p_xform.xform(r.pos+r.size);
+	v[3]=p_xform.xform(Vector2(r.pos.x,r.pos.y+r.size.height));
+
+	if (tex_size!=Size2()) {
+
+		Rect2 src = (p_rect->flags&Rasterizer::CANVAS_RECT_REGION) ? p_rect->source : Rect2(Point2(),tex_size);
+		Vector2 *uv=&b.uvs[ofs];
+		uv[0]=Vector2(src.pos.x/tex_size.width,src.pos.y/tex_size.height);
+		uv[1]=Vector2((src.pos.x+src.size.width)/tex_size.width,src.pos.y/tex_size.height);
+		uv[2]=Vector2((src.pos.x+src.size.width)/tex_size.width,(src.pos.y+src.size.height)/tex_size.height);
+		uv[3]=Vector2(src.pos.x/tex_size.width,(src.pos.y+src.size.height)/tex_size.height);
+
+		if (p_rect->flags&Rasterizer::CANVAS_RECT_FLIP_H) {
+			SWAP(uv[0],uv[1]);
+			SWAP(uv[2],uv[3]);
+		}
+		if (p_rect->flags&Rasterizer::CANVAS_RECT_FLIP_V) {
+			SWAP(uv[1],uv[2]);
+			SWAP(uv[0],uv[3]);
+		}
+	}
+
+	Color c=p_rect->modulate;
+	c.a*=p_opacity; // opacity is baked, per vertex colors ignore canvas_set_opacity
+	Color *col=&b.colors[ofs];
+	col[0]=c;
+	col[1]=c;
+	col[2]=c;
+	col[3]=c;
+
+	b.quads++;
+	b.rects_in_frame++;
+	return true;
+}
+
+void VisualServerRaster::_canvas_batch_flush() {
+
+	CanvasBatch &b=canvas_batch;
+	if (b.quads==0)
+		return;
+
+	rasterizer->canvas_begin_rect(Matrix32());
+	rasterizer->canvas_set_opacity(1.0);
+	rasterizer->canvas_set_blend_mode(b.blend_mode);
+	rasterizer->canvas_draw_polygon(b.quads*6,b.indices,b.vertices,b.texture.is_valid()?b.uvs:NULL,b.colors,b.texture,false);
+	rasterizer->canvas_end_rect();
+
+	b.quads=0;
+	b.batches_in_frame++;
+}
+
 void VisualServerRaster::_render_canvas_item(CanvasItem *p_canvas_item,const Matrix32& p_transform,const Rect2& p_clip_rect, float p_opacity) {
 
 	CanvasItem *ci = p_canvas_item;
@@ -5102,9 +5288,18 @@ void VisualServerRaster::_render_canvas_item(CanvasItem *p_canvas_item,const Mat
 	if (p_opacity<0.007)
 		return;
 
+	Matrix32 xform = p_transform * ci->xform;
+
+	const Rect2& subtree_rect = ci->get_subtree_rect();
+	if (ci->subtree_empty)
+		return; //nothing to draw here or below
+
+	Rect2 subtree_global_rect = xform.xform(subtree_rect);
+	subtree_global_rect.pos+=p_clip_rect.pos;
+	if (!subtree_global_rect.intersects(p_clip_rect))
+		return; //whole subtree is off screen
 
 	Rect2 rect = ci->get_rect();
-	Matrix32 xform = p_transform * ci->xform;
 	Rect2 global_rect = xform.xform(rect);
 	global_rect.pos+=p_clip_rect.pos;
 
@@ -5113,6 +5308,8 @@ void VisualServerRaster::_render_canvas_item(CanvasItem *p_canvas_item,const Mat
 
 		Viewport *vp = viewport_owner.get(ci->viewport);
 
+		_canvas_batch_flush();
+
 		Point2i from = xform.get_origin() + Point2(viewport_rect.x,viewport_rect.y);
 		Point2i size = rect.size;
 		size.x *= xform[0].length();
@@ -5139,6 +5336,7 @@ void VisualServerRaster::_render_canvas_item(CanvasItem *p_canvas_item,const Mat
 	CanvasItem **top_items=(CanvasItem**)alloca(child_item_count*sizeof(CanvasItem*));
 
 	if (ci->clip) {
+		_canvas_batch_flush();
 		rasterizer->canvas_set_clip(true,global_rect);
 		canvas_clip=global_rect;
 	}
@@ -5159,9 +5357,12 @@ void VisualServerRaster::_render_canvas_item(CanvasItem *p_canvas_item,const Mat
 
 		if (p_clip_rect.intersects(global_rect)) {
 
-			rasterizer->canvas_begin_rect(xform);
-			rasterizer->canvas_set_opacity( opacity * ci->self_opacity );
-			rasterizer->canvas_set_blend_mode( ci->blend_mode );
+			float item_opacity = opacity * ci->self_opacity;
+			MaterialBlendMode blend_mode = ci->blend_mode;
+			Matrix32 extra_xform;
+			Matrix32 batch_xform = xform;
+			bool has_extra_xform=false;
+			bool rect_begun=false; //item state is only sent to the rasterizer for commands that are not batched
 
 			CanvasItem::Command **commands = &ci->commands[0];
 
@@ -5169,6 +5370,28 @@ void VisualServerRaster::_render_canvas_item(CanvasItem *p_canvas_item,const Mat
 
 				CanvasItem::Command *c=commands[i];
 
+				if (canvas_batching_enabled && c->type==CanvasItem::Command::TYPE_RECT) {
+
+					if (_canvas_batch_rect(static_cast<CanvasItem::CommandRect*>(c),batch_xform,item_opacity,blend_mode)) {
+						if (rect_begun) {
+							rasterizer->canvas_end_rect();
+							rect_begun=false;
+						}
+						continue;
+					}
+				}
+
+				if (!rect_begun && c->type!=CanvasItem::Command::TYPE_TRANSFORM && c->type!=CanvasItem::Command::TYPE_BLEND_MODE) {
+
+					_canvas_batch_flush();
+					rasterizer->canvas_begin_rect(xform);
+					rasterizer->canvas_set_opacity( item_opacity );
+					rasterizer->canvas_set_blend_mode( blend_mode );
+					if (has_extra_xform)
+						rasterizer->canvas_set_transform(extra_xform);
+					rect_begun=true;
+				}
+
 				switch(c->type) {
 					case CanvasItem::Command::TYPE_LINE: {
 
@@ -5247,12 +5470,18 @@ void VisualServerRaster::_render_canvas_item(CanvasItem *p_canvas_item,const Mat
 					case CanvasItem::Command::TYPE_TRANSFORM: {
 
 						CanvasItem::CommandTransform* transform = static_cast<CanvasItem::CommandTransform*>(c);
-						rasterizer->canvas_set_transform(transform->xform);
+						extra_xform=transform->xform;
+						batch_xform=xform*extra_xform;
+						has_extra_xform=true;
+						if (rect_begun)
+							rasterizer->canvas_set_transform(transform->xform);
 					} break;
 					case CanvasItem::Command::TYPE_BLEND_MODE: {
 
 						CanvasItem::CommandBlendMode* bm = static_cast<CanvasItem::CommandBlendMode*>(c);
-						rasterizer->canvas_set_blend_mode(bm->blend_mode);
+						blend_mode=bm->blend_mode;
+						if (rect_begun)
+							rasterizer->canvas_set_blend_mode(bm->blend_mode);
 
 					} break;
 					case CanvasItem::Command::TYPE_CLIP_IGNORE: {
@@ -5277,13 +5506,15 @@ void VisualServerRaster::_render_canvas_item(CanvasItem *p_canvas_item,const Mat
 					} break;
 				}
 			}
-			rasterizer->canvas_end_rect();
+			if (rect_begun)
+				rasterizer->canvas_end_rect();
 		}
 	}
 
 
 	if (reclip) {
 
+		_canvas_batch_flush();
 		rasterizer->canvas_set_clip(true,canvas_clip);
 	}
 
@@ -5303,6 +5534,7 @@ void VisualServerRaster::_render_canvas_item(CanvasItem *p_canvas_item,const Mat
 
 
 	if (ci->clip) {
+		_canvas_batch_flush();
 		rasterizer->canvas_set_clip(false,Rect2());
 		canvas_clip=Rect2();
 	}
@@ -5312,6 +5544,7 @@ void VisualServerRaster::_render_canvas_item(CanvasItem *p_canvas_item,const Mat
 void VisualServerRaster::_render_canvas(Canvas *p_canvas,const Matrix32 &p_transform) {
 
 	rasterizer->canvas_begin();
+	canvas_batch.size_cache_texture=RID(); //textures may have been resized since last frame
 
 	int l = p_canvas->child_items.size();
 
@@ -5339,6 +5572,7 @@ void VisualServerRaster::_render_canvas(Canvas *p_canvas,const Matrix32 &p_trans
 
 	}
 
+	_canvas_batch_flush();
 }
 
 
@@ -5393,14 +5627,14 @@ void VisualServerRaster::_draw_viewport(Viewport *p_viewport,int p_ofs_x, int p_
 	if (!p_viewport->hide_canvas) {
 		int i=0;
 
-		Map<Viewport::CanvasKey,Viewport::CanvasData*> canvas_map;
+		Map<Viewport::CanvasKey,Viewport::CanvasData*,Comparator<Viewport::CanvasKey>,FrameAllocator> canvas_map;
 
 		for (Map<RID,Viewport::CanvasData>::Element *E=p_viewport->canvas_map.front();E;E=E->next()) {
 			canvas_map[ Viewport::CanvasKey( E->key(), E->get().layer) ]=&E->get();
 
 		}
 
-		for (Map<Viewport::CanvasKey,Viewport::CanvasData*>::Element *E=canvas_map.front();E;E=E->next()) {
+		for (Map<Viewport::CanvasKey,Viewport::CanvasData*,Comparator<Viewport::CanvasKey>,FrameAllocator>::Element *E=canvas_map.front();E;E=E->next()) {
 
 
 	//		print_line("canvas "+itos(i)+" size: "+itos(I->get()->canvas->child_items.size()));
@@ -5557,11 +5791,17 @@ void VisualServerRaster::draw() {
 	shadows_enabled=GLOBAL_DEF("render/shadows_enabled",true);
 	room_cull_enabled = GLOBAL_DEF("render/room_cull_enabled",true);
 	light_discard_enabled = GLOBAL_DEF("render/light_discard_enabled",true);
+	canvas_batching_enabled = GLOBAL_DEF("render/canvas_batching",true);
+	canvas_batch.batches_in_frame=0;
+	canvas_batch.rects_in_frame=0;
 	rasterizer->begin_frame();
 	_draw_viewports();
 	_draw_cursors_and_margins();
 	rasterizer->end_frame();	
 	draw_extra_frame=rasterizer->needs_to_draw_next_frame();
+
+	instance_update_last_frame=instance_update_info;
+	instance_update_info=InstanceUpdateInfo();
 }
 
 bool VisualServerRaster::has_changed() const {
@@ -5571,6 +5811,15 @@ bool VisualServerRaster::has_changed() const {
 
 int VisualServerRaster::get_render_info(RenderInfo p_info) {
 
+	switch(p_info) {
+		case INFO_CANVAS_BATCHES_IN_FRAME: return canvas_batch.batches_in_frame;
+		case INFO_CANVAS_BATCHED_RECTS_IN_FRAME: return canvas_batch.rects_in_frame;
+		case INFO_INSTANCE_UPDATES_IN_FRAME: return instance_update_last_frame.instances;
+		case INFO_INSTANCE_TRANSFORM_USEC_IN_FRAME: return instance_update_last_frame.transform_usec;
+		case INFO_INSTANCE_OCTREE_USEC_IN_FRAME: return instance_update_last_frame.octree_usec;
+		default: {}
+	}
+
 	return rasterizer->get_render_info(p_info);
 }
 
@@ -5635,6 +5884,7 @@ void VisualServerRaster::init() {
 	default_cursor_texture = texture_create_from_image(img, 0);
 
 	aabb_random_points.resize( GLOBAL_DEF("render/aabb_random_points",16) );
+	instance_update_pool.init(GLOBAL_DEF("render/instance_update_threads",-1)); // -1: one per extra processor, 0: update on the render thread
 	for(int i=0;i<aabb_random_points.size();i++)
 		aabb_random_points[i]=Vector3(Math::random(0,1),Math::random(0,1),Math::random(0,1));
 	transformed_aabb_random_points.resize(aabb_random_points.size());
@@ -5661,6 +5911,7 @@ void VisualServerRaster::_clean_up_owner(RID_OwnerBase *p_owner,String p_type) {
 
 void VisualServerRaster::finish() {
 
+	instance_update_pool.finish();
 
 	free(default_cursor_texture);
 
@@ -5707,6 +5958,23 @@ VisualServerRaster::VisualServerRaster(Rasterizer *p_rasterizer) {
 	OctreeAllocator::allocator=&octree_allocator;
 	draw_extra_frame=false;
 
+	canvas_batching_enabled=true;
+	canvas_batch.quads=0;
+	canvas_batch.blend_mode=MATERIAL_BLEND_MODE_MIX;
+	canvas_batch.size_cache_valid=false;
+	canvas_batch.batches_in_frame=0;
+	canvas_batch.rects_in_frame=0;
+	for(int i=0;i<CANVAS_BATCH_MAX_QUADS;i++) {
+
+		int *idx=&canvas_batch.indices[i*6];
+		idx[0]=i*4+0;
+		idx[1]=i*4+1;
+		idx[2]=i*4+2;
+		idx[3]=i*4+0;
+		idx[4]=i*4+2;
+		idx[5]=i*4+3;
+	}
+
 }
 
 
@@ -34,6 +34,7 @@
 #include "servers/visual/rasterizer.h"
 #include "balloon_allocator.h"
 #include "octree.h"
+#include "os/thread_work_pool.h"
 
 /**
 	@author Juan Linietsky <reduzio@gmail.com>
@@ -51,7 +52,9 @@ class VisualServerRaster : public VisualServer {
 		MAX_LIGHTS_CULLED=256,
 		MAX_ROOM_CULL=32,
 		MAX_EXTERIOR_PORTALS=128,
-		INSTANCE_ROOMLESS_MASK=(1<<20)
+		INSTANCE_ROOMLESS_MASK=(1<<20),
+		CANVAS_BATCH_MAX_QUADS=1024,
+		INSTANCE_UPDATE_MIN_PARALLEL=64 // fewer dirty instances than this are not worth waking the pool
 
 
 	};
@@ -424,13 +427,22 @@ class VisualServerRaster : public VisualServer {
 		mutable bool custom_rect;
 		mutable bool rect_dirty;
 		mutable Rect2 rect;
+
+		// own rect merged with the rects of all visible children, in local coords.
+		// lets _render_canvas_item skip whole subtrees that are off screen.
+		CanvasItem *parent_item; // NULL if the parent is a canvas
+		mutable bool subtree_dirty;
+		mutable bool subtree_empty;
+		mutable Rect2 subtree_rect;
 		
 		Vector<Command*> commands;
 		Vector<CanvasItem*> child_items;
 
 		const Rect2& get_rect() const;
+		const Rect2& get_subtree_rect() const;
+		void subtree_changed() { for(CanvasItem *ci=this;ci;ci=ci->parent_item) ci->subtree_dirty=true; }
 		void clear() { for (int i=0;i<commands.size();i++) memdelete( commands[i] ); commands.clear(); clip=false; rect_dirty=true;};
-		CanvasItem() { clip=false; E=NULL; opacity=1; self_opacity=1; blend_mode=MATERIAL_BLEND_MODE_MIX; visible=true; rect_dirty=true; custom_rect=false; ontop=true; }
+		CanvasItem() { clip=false; E=NULL; opacity=1; self_opacity=1; blend_mode=MATERIAL_BLEND_MODE_MIX; visible=true; rect_dirty=true; custom_rect=false; ontop=true; parent_item=NULL; subtree_dirty=true; subtree_empty=true; }
 		~CanvasItem() { clear(); }
 	};
 
@@ -546,6 +558,29 @@ class VisualServerRaster : public VisualServer {
 	};
 
 	Rect2 canvas_clip;
+
+	// consecutive rects sharing texture and blend mode, already in canvas space
+	struct CanvasBatch {
+
+		RID texture;
+		MaterialBlendMode blend_mode;
+		int quads;
+		Vector2 vertices[CANVAS_BATCH_MAX_QUADS*4];
+		Vector2 uvs[CANVAS_BATCH_MAX_QUADS*4];
+		Color colors[CANVAS_BATCH_MAX_QUADS*4];
+		int indices[CANVAS_BATCH_MAX_QUADS*6];
+
+		RID size_cache_texture;
+		Size2 size_cache;
+		bool size_cache_valid;
+
+		int batches_in_frame;
+		int rects_in_frame;
+	};
+
+	CanvasBatch canvas_batch;
+	bool canvas_batching_enabled;
+
 	Color clear_color;
 	Cursor cursors[MAX_CURSORS];
 	RID default_cursor_texture;
@@ -580,12 +615,28 @@ class VisualServerRaster : public VisualServer {
 	void _instance_queue_update(Instance *p_instance,bool p_update_aabb=false);	
 	void _update_instances();
 	void _update_instance_aabb(Instance *p_instance);
+	void _update_instance_transform(Instance *p_instance);
+	static void _update_instance_work(void *p_userdata,int p_index);
 	void _update_instance(Instance *p_instance);
 	void _free_attached_instances(RID p_rid,bool p_free_scenario=false);
 	void _clean_up_owner(RID_OwnerBase *p_owner,String p_type);
 	
 	Instance *instance_update_list;
 
+	ThreadWorkPool instance_update_pool;
+	Vector<Instance*> instance_update_work;
+
+	struct InstanceUpdateInfo {
+
+		int instances;
+		uint64_t transform_usec;
+		uint64_t octree_usec;
+		InstanceUpdateInfo() { instances=0; transform_usec=0; octree_usec=0; }
+	};
+
+	InstanceUpdateInfo instance_update_info; // accumulating since last draw()
+	InstanceUpdateInfo instance_update_last_frame;
+
 	//RID default_scenario;
 	//RID default_viewport;
 
@@ -599,10 +650,10 @@ class VisualServerRaster : public VisualServer {
 	mutable RID_Owner<Viewport> viewport_owner;
 	
 	mutable RID_Owner<Scenario> scenario_owner;
-	mutable RID_Owner<Instance> instance_owner;
+	mutable RID_SlotOwner<Instance> instance_owner;
 	
 	mutable RID_Owner<Canvas> canvas_owner;
-	mutable RID_Owner<CanvasItem> canvas_item_owner;
+	mutable RID_SlotOwner<CanvasItem> canvas_item_owner;
 
 	Map< RID, Set<RID> > instance_dependency_map;
 	
@@ -614,6 +665,8 @@ class VisualServerRaster : public VisualServer {
 	void _cull_portal(Camera *p_camera, Instance *p_portal,Instance *p_from_portal);
 	void _cull_room(Camera *p_camera, Instance *p_room,Instance *p_from_portal=NULL);
 	void _render_camera(Viewport *p_viewport,Camera *p_camera, Scenario *p_scenario);
+	bool _canvas_batch_rect(const CanvasItem::CommandRect *p_rect,const Matrix32& p_xform,float p_opacity,MaterialBlendMode p_blend_mode);
+	void _canvas_batch_flush();
 	void _render_canvas_item(CanvasItem *p_canvas_item,const Matrix32& p_transform,const Rect2& p_clip_rect,float p_opacity);
 	void _render_canvas(Canvas *p_canvas,const Matrix32 &p_transform);
 	Vector<Vector3> _camera_generate_endpoints(Instance *p_light,Camera *p_camera,float p_range_min, float p_range_max);
@@ -28,6 +28,7 @@
 /*************************************************************************/
 #include "visual_server_wrap_mt.h"
 #include "os/os.h"
+#include "globals.h"
 
 void VisualServerWrapMT::thread_exit() {
 
@@ -83,8 +84,8 @@ void VisualServerWrapMT::thread_loop() {
 	exit=false;
 	draw_thread_up=true;
 	while(!exit) {
-		// flush commands one by one, until exit is requested
-		command_queue.wait_and_flush_one();
+		// flush commands until exit is requested
+		command_queue.wait_and_flush_all();
 	}
 	
 	command_queue.flush_all(); // flush all
@@ -173,7 +174,8 @@ void VisualServerWrapMT::finish() {
 }
 
 
-VisualServerWrapMT::VisualServerWrapMT(VisualServer* p_contained,bool p_create_thread) : command_queue(p_create_thread) {
+//single producer is only safe if nothing but the main thread talks to the visual server
+VisualServerWrapMT::VisualServerWrapMT(VisualServer* p_contained,bool p_create_thread) : command_queue(p_create_thread,p_create_thread && bool(GLOBAL_DEF("render/thread_single_producer",false))) {
 
 	visual_server=p_contained;
 	create_thread=p_create_thread;
@@ -626,6 +626,11 @@ void VisualServer::_bind_methods() {
 	BIND_CONSTANT( INFO_VIDEO_MEM_USED );
 	BIND_CONSTANT( INFO_TEXTURE_MEM_USED );
 	BIND_CONSTANT( INFO_VERTEX_MEM_USED );
+	BIND_CONSTANT( INFO_CANVAS_BATCHES_IN_FRAME );
+	BIND_CONSTANT( INFO_CANVAS_BATCHED_RECTS_IN_FRAME );
+	BIND_CONSTANT( INFO_INSTANCE_UPDATES_IN_FRAME );
+	BIND_CONSTANT( INFO_INSTANCE_TRANSFORM_USEC_IN_FRAME );
+	BIND_CONSTANT( INFO_INSTANCE_OCTREE_USEC_IN_FRAME );
 
 
 }
@@ -915,6 +915,11 @@ public:
 		INFO_VIDEO_MEM_USED,
 		INFO_TEXTURE_MEM_USED,
 		INFO_VERTEX_MEM_USED,
+		INFO_CANVAS_BATCHES_IN_FRAME,
+		INFO_CANVAS_BATCHED_RECTS_IN_FRAME,
+		INFO_INSTANCE_UPDATES_IN_FRAME,
+		INFO_INSTANCE_TRANSFORM_USEC_IN_FRAME,
+		INFO_INSTANCE_OCTREE_USEC_IN_FRAME,
 	};
 
 	virtual int get_render_info(RenderInfo p_info)=0;
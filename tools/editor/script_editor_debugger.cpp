@@ -342,6 +342,11 @@ void ScriptEditorDebugger::_parse_message(const String& p_msg,const Array& p_dat
 		perf_history.push_front(p);
 		perf_draw->update();
 
+	} else if (p_msg=="profile_frame" || p_msg=="profile_total") {
+
+		ERR_FAIL_COND(p_data.size()!=1);
+		_profiler_add_data(p_data[0],p_msg=="profile_total");
+
 	} else if (p_msg=="kill_me") {
 
 		editor->call_deferred("stop_child_process");
@@ -356,6 +361,95 @@ void ScriptEditorDebugger::_performance_select(Object*,int,bool) {
 
 }
 
+void ScriptEditorDebugger::_profiler_toggled(bool p_pressed) {
+
+	if (connection.is_null() || !connection->is_connected()) {
+
+		profiler_toggle->set_pressed(false);
+		profiler_toggle->set_text("Start Profiling");
+		return;
+	}
+
+	if (p_pressed)
+		_profiler_clear();
+
+	Array msg;
+	msg.push_back(p_pressed?"start_profiling":"stop_profiling");
+	ppeer->put_var(msg);
+
+	profiler_toggle->set_text(p_pressed?"Stop Profiling":"Start Profiling");
+	profiler_status->set_text(p_pressed?"Profiling..":"");
+}
+
+void ScriptEditorDebugger::_profiler_clear() {
+
+	profiler_data.clear();
+	profiler_frames=0;
+	profiler_dirty=false;
+	profiler_tree->clear();
+	profiler_status->set_text("");
+}
+
+void ScriptEditorDebugger::_profiler_add_data(const Array& p_data,bool p_totals) {
+
+	//flat array, 4 entries per function: signature, calls, self time, total time
+	if (p_totals)
+		profiler_data.clear();
+	else
+		profiler_frames++;
+
+	for(int i=0;i+3<p_data.size();i+=4) {
+
+		String signature = p_data[i];
+		Map<String,ProfilerEntry>::Element *E=profiler_data.find(signature);
+		if (!E) {
+			ProfilerEntry pe;
+			pe.signature=signature;
+			pe.calls=0;
+			pe.self_time=0;
+			pe.total_time=0;
+			E=profiler_data.insert(signature,pe);
+		}
+
+		E->get().calls+=uint64_t(p_data[i+1]);
+		E->get().self_time+=uint64_t(p_data[i+2]);
+		E->get().total_time+=uint64_t(p_data[i+3]);
+	}
+
+	profiler_dirty=true;
+	if (p_totals) {
+		//runtime totals replace what was summed from the frames
+		_profiler_update();
+		profiler_status->set_text("Totals over "+itos(profiler_frames)+" frames");
+	}
+}
+
+void ScriptEditorDebugger::_profiler_update() {
+
+	profiler_dirty=false;
+	profiler_last_update=OS::get_singleton()->get_ticks_msec();
+
+	Vector<ProfilerEntry> entries;
+	for (Map<String,ProfilerEntry>::Element *E=profiler_data.front();E;E=E->next()) {
+
+		entries.push_back(E->get());
+	}
+	entries.sort();
+
+	profiler_tree->clear();
+	TreeItem *root = profiler_tree->create_item();
+
+	for(int i=0;i<entries.size();i++) {
+
+		const ProfilerEntry &pe = entries[i];
+		TreeItem *it = profiler_tree->create_item(root);
+		it->set_text(0,pe.signature);
+		it->set_text(1,itos(pe.calls));
+		it->set_text(2,rtos(pe.self_time/1000.0));
+		it->set_text(3,rtos(pe.total_time/1000.0));
+	}
+}
+
 void ScriptEditorDebugger::_performance_draw() {
 
 
@@ -447,6 +541,11 @@ void ScriptEditorDebugger::_notification(int p_what) {
 		} break;
 		case NOTIFICATION_PROCESS: {
 
+			if (profiler_dirty && OS::get_singleton()->get_ticks_msec()-profiler_last_update>500) {
+				//frame data arrives every idle poll, refresh the view at a readable rate
+				_profiler_update();
+			}
+
 			if (connection.is_null()) {
 
 				if (server->is_connection_available()) {
@@ -610,6 +709,9 @@ void ScriptEditorDebugger::stop(){
 	pending_in_queue=0;
 	message.clear();
 
+	profiler_toggle->set_pressed(false);
+	profiler_toggle->set_text("Start Profiling");
+
 	if (log_forced_visible) {
 		EditorNode::get_log()->hide();
 		log_forced_visible=false;
@@ -678,6 +780,8 @@ void ScriptEditorDebugger::_bind_methods() {
 	ObjectTypeDB::bind_method(_MD("_performance_draw"),&ScriptEditorDebugger::_performance_draw);
 	ObjectTypeDB::bind_method(_MD("_performance_select"),&ScriptEditorDebugger::_performance_select);
 	ObjectTypeDB::bind_method(_MD("_scene_tree_request"),&ScriptEditorDebugger::_scene_tree_request);
+	ObjectTypeDB::bind_method(_MD("_profiler_toggled"),&ScriptEditorDebugger::_profiler_toggled);
+	ObjectTypeDB::bind_method(_MD("_profiler_clear"),&ScriptEditorDebugger::_profiler_clear);
 
 	ADD_SIGNAL(MethodInfo("goto_script_line"));
 	ADD_SIGNAL(MethodInfo("breaked",PropertyInfo(Variant::BOOL,"reallydid")));
@@ -834,6 +938,45 @@ ScriptEditorDebugger::ScriptEditorDebugger(EditorNode *p_editor){
 
 	}
 
+	VBoxContainer *profiler = memnew( VBoxContainer );
+	profiler->set_name("Profiler");
+	tabs->add_child(profiler);
+
+	HBoxContainer *profiler_hb = memnew( HBoxContainer );
+	profiler->add_child(profiler_hb);
+	profiler_toggle = memnew( Button );
+	profiler_toggle->set_toggle_mode(true);
+	profiler_toggle->set_text("Start Profiling");
+	profiler_toggle->connect("toggled",this,"_profiler_toggled");
+	profiler_hb->add_child(profiler_toggle);
+	Button *profiler_clear = memnew( Button );
+	profiler_clear->set_text("Clear");
+	profiler_clear->connect("pressed",this,"_profiler_clear");
+	profiler_hb->add_child(profiler_clear);
+	profiler_status = memnew( Label );
+	profiler_status->set_h_size_flags(SIZE_EXPAND_FILL);
+	profiler_hb->add_child(profiler_status);
+
+	profiler_tree = memnew( Tree );
+	profiler_tree->set_columns(4);
+	profiler_tree->set_column_title(0,"Function");
+	profiler_tree->set_column_title(1,"Calls");
+	profiler_tree->set_column_title(2,"Self (ms)");
+	profiler_tree->set_column_title(3,"Total (ms)");
+	profiler_tree->set_column_titles_visible(true);
+	profiler_tree->set_column_expand(1,false);
+	profiler_tree->set_column_min_width(1,80);
+	profiler_tree->set_column_expand(2,false);
+	profiler_tree->set_column_min_width(2,100);
+	profiler_tree->set_column_expand(3,false);
+	profiler_tree->set_column_min_width(3,100);
+	profiler_tree->set_hide_root(true);
+	profiler_tree->set_v_size_flags(SIZE_EXPAND_FILL);
+	profiler->add_child(profiler_tree);
+	profiler_frames=0;
+	profiler_dirty=false;
+	profiler_last_update=0;
+
 	info = memnew( HSplitContainer );
 	info->set_name("Info");
 	tabs->add_child(info);
@@ -83,6 +83,25 @@ class ScriptEditorDebugger : public Control {
 	Tree *perf_monitors;
 	Control *perf_draw;
 
+	struct ProfilerEntry {
+
+		String signature;
+		uint64_t calls;
+		uint64_t self_time; //usec
+		uint64_t total_time; //usec
+
+		bool operator<(const ProfilerEntry& p_entry) const { return self_time > p_entry.self_time; } //slowest first
+	};
+
+	Map<String,ProfilerEntry> profiler_data;
+	int profiler_frames;
+	bool profiler_dirty;
+	uint64_t profiler_last_update;
+
+	Button *profiler_toggle;
+	Label *profiler_status;
+	Tree *profiler_tree;
+
 	Tree *stack_dump;
 	PropertyEditor *inspector;
 
@@ -101,6 +120,10 @@ class ScriptEditorDebugger : public Control {
 
 	void _performance_draw();
 	void _performance_select(Object *, int, bool);
+	void _profiler_toggled(bool p_pressed);
+	void _profiler_clear();
+	void _profiler_add_data(const Array& p_data,bool p_totals);
+	void _profiler_update();
 	void _stack_dump_frame_selected();
 	void _output_clear();
 	void _hide_request();